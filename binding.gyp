@@ -27,6 +27,12 @@
   'targets' : [{
     'target_name' : 'tfjs_binding',
     'sources' : [
+      'binding/aligned_buffer_pool.cc',
+      'binding/batch_scheduler.cc',
+      'binding/graph_capture.cc',
+      'binding/graph_session.cc',
+      'binding/napi_ref_release_queue.cc',
+      'binding/tensor_arena.cc',
       'binding/tfjs_backend.cc',
       'binding/tfjs_binding.cc'
     ],
@@ -0,0 +1,147 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#include "aligned_buffer_pool.h"
+
+#include <cstdlib>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+namespace tfnodejs {
+
+namespace {
+
+// Every buffer is preceded by a kAlignment-sized header that records its size
+// class, so that Release() only needs the data pointer.
+struct BufferHeader {
+  size_t size_class;
+};
+
+void* AlignedMalloc(size_t byte_length) {
+#ifdef _WIN32
+  return _aligned_malloc(byte_length, AlignedBufferPool::kAlignment);
+#else
+  void* data = nullptr;
+  if (posix_memalign(&data, AlignedBufferPool::kAlignment, byte_length) != 0) {
+    return nullptr;
+  }
+  return data;
+#endif
+}
+
+void AlignedFree(void* data) {
+#ifdef _WIN32
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
+}  // namespace
+
+AlignedBufferPool::AlignedBufferPool(size_t max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes), cached_bytes_(0) {}
+
+AlignedBufferPool::~AlignedBufferPool() {
+  for (size_t i = 0; i < kNumClasses; i++) {
+    for (size_t j = 0; j < free_lists_[i].size(); j++) {
+      AlignedFree(free_lists_[i][j]);
+    }
+  }
+}
+
+size_t AlignedBufferPool::GetSizeClass(size_t byte_length) {
+  size_t size_class = 0;
+  size_t class_bytes = kMinClassBytes;
+  while (class_bytes < byte_length) {
+    if (++size_class == kNumClasses) {
+      return kUnpooledClass;
+    }
+    class_bytes <<= 1;
+  }
+  return size_class;
+}
+
+size_t AlignedBufferPool::GetClassBytes(size_t size_class) {
+  return kMinClassBytes << size_class;
+}
+
+void* AlignedBufferPool::Allocate(size_t byte_length) {
+  size_t size_class = GetSizeClass(byte_length);
+
+  void* block = nullptr;
+  if (size_class != kUnpooledClass) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<void*>& free_list = free_lists_[size_class];
+    if (!free_list.empty()) {
+      block = free_list.back();
+      free_list.pop_back();
+      cached_bytes_ -= GetClassBytes(size_class);
+    }
+  }
+
+  if (block == nullptr) {
+    size_t block_bytes = size_class == kUnpooledClass
+                             ? byte_length
+                             : GetClassBytes(size_class);
+    block = AlignedMalloc(kAlignment + block_bytes);
+    if (block == nullptr) {
+      return nullptr;
+    }
+    static_cast<BufferHeader*>(block)->size_class = size_class;
+  }
+  return static_cast<char*>(block) + kAlignment;
+}
+
+void AlignedBufferPool::Release(void* data) {
+  if (data == nullptr) {
+    return;
+  }
+  void* block = static_cast<char*>(data) - kAlignment;
+  size_t size_class = static_cast<BufferHeader*>(block)->size_class;
+  if (size_class != kUnpooledClass) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t class_bytes = GetClassBytes(size_class);
+    if (cached_bytes_ + class_bytes <= max_cached_bytes_) {
+      free_lists_[size_class].push_back(block);
+      cached_bytes_ += class_bytes;
+      return;
+    }
+  }
+  AlignedFree(block);
+}
+
+void AlignedBufferPool::SetMaxCachedBytes(size_t max_cached_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_cached_bytes_ = max_cached_bytes;
+  for (size_t i = kNumClasses; i-- > 0 && cached_bytes_ > max_cached_bytes_;) {
+    std::vector<void*>& free_list = free_lists_[i];
+    while (!free_list.empty() && cached_bytes_ > max_cached_bytes_) {
+      AlignedFree(free_list.back());
+      free_list.pop_back();
+      cached_bytes_ -= GetClassBytes(i);
+    }
+  }
+}
+
+size_t AlignedBufferPool::cached_bytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+}  // namespace tfnodejs
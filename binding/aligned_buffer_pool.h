@@ -0,0 +1,80 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_ALIGNED_BUFFER_POOL_H_
+#define TF_NODEJS_ALIGNED_BUFFER_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace tfnodejs {
+
+// Pool of buffers aligned for TensorFlow.
+//
+// TF_NewTensor() copies caller-provided memory that is not aligned to
+// EIGEN_MAX_ALIGN_BYTES. Buffers from this pool are always aligned to
+// kAlignment, so tensors created over them are adopted without a copy.
+// Buffers are grouped in power-of-two size classes and released buffers are
+// kept on per-class free lists, up to a cap on the total cached bytes.
+// Requests larger than the largest class are not pooled. All methods are
+// thread-safe.
+class AlignedBufferPool {
+ public:
+  // Largest EIGEN_MAX_ALIGN_BYTES used by TensorFlow builds (AVX-512).
+  static const size_t kAlignment = 64;
+
+  explicit AlignedBufferPool(size_t max_cached_bytes);
+  ~AlignedBufferPool();
+
+  // Returns a buffer of at least `byte_length` bytes aligned to kAlignment,
+  // or nullptr if allocation fails.
+  void* Allocate(size_t byte_length);
+
+  // Returns a buffer obtained from Allocate() to the pool.
+  void Release(void* data);
+
+  // Returns true if `data` satisfies TensorFlow's alignment requirement.
+  static bool IsAligned(const void* data) {
+    return reinterpret_cast<uintptr_t>(data) % kAlignment == 0;
+  }
+
+  // Sets the cap on the bytes held on the free lists and frees buffers above
+  // it. With a zero cap, released buffers are freed immediately.
+  void SetMaxCachedBytes(size_t max_cached_bytes);
+
+  // Returns the number of bytes held on the free lists.
+  size_t cached_bytes();
+
+ private:
+  static const size_t kMinClassBytes = 64;
+  static const size_t kNumClasses = 21;  // 64 bytes up to 64 MB.
+  static const size_t kUnpooledClass = kNumClasses;
+
+  static size_t GetSizeClass(size_t byte_length);
+  static size_t GetClassBytes(size_t size_class);
+
+  std::mutex mutex_;
+  std::vector<void*> free_lists_[kNumClasses];
+  size_t max_cached_bytes_;
+  size_t cached_bytes_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_ALIGNED_BUFFER_POOL_H_
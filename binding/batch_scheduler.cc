@@ -0,0 +1,370 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#include "batch_scheduler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tfnodejs {
+
+void BatchHistogram::Add(uint64_t value) {
+  size_t bucket = 0;
+  while (bucket < 63 && (static_cast<uint64_t>(1) << bucket) < value) {
+    bucket++;
+  }
+  if (buckets.size() <= bucket) {
+    buckets.resize(bucket + 1, 0);
+  }
+  buckets[bucket]++;
+  count++;
+  sum += value;
+  max = std::max(max, value);
+}
+
+BatchRequest::BatchRequest()
+    : num_rows(0), is_batchable(false), context(nullptr), deferred(nullptr) {}
+
+BatchRequest::~BatchRequest() {
+  for (size_t i = 0; i < inputs.size(); i++) {
+    TF_DeleteTensor(inputs[i]);
+  }
+  for (size_t i = 0; i < outputs.size(); i++) {
+    TF_DeleteTensor(outputs[i]);
+  }
+}
+
+BatchScheduler::BatchScheduler(int32_t model_id,
+                               std::shared_ptr<GraphSession> session,
+                               TensorArena* tensor_arena)
+    : model_id_(model_id),
+      session_(session),
+      tensor_arena_(tensor_arena),
+      env_(nullptr),
+      timer_(nullptr),
+      timeout_callback_(nullptr),
+      timeout_data_(nullptr),
+      max_batch_size_(1),
+      timeout_(0),
+      is_closed_(false),
+      is_running_(false) {}
+
+BatchScheduler::~BatchScheduler() {
+  if (timer_ != nullptr) {
+    uv_close(reinterpret_cast<uv_handle_t*>(timer_), OnTimerClose);
+  }
+}
+
+napi_status BatchScheduler::InitTimer(napi_env env, TimeoutCallback callback,
+                                      void* data) {
+  uv_loop_t* loop;
+  napi_status nstatus = napi_get_uv_event_loop(env, &loop);
+  if (nstatus != napi_ok) {
+    return nstatus;
+  }
+
+  timer_ = new uv_timer_t();
+  if (uv_timer_init(loop, timer_) != 0) {
+    delete timer_;
+    timer_ = nullptr;
+    return napi_generic_failure;
+  }
+  timer_->data = this;
+  env_ = env;
+  timeout_callback_ = callback;
+  timeout_data_ = data;
+  return napi_ok;
+}
+
+void BatchScheduler::Configure(int64_t max_batch_size,
+                               int64_t timeout_micros) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_batch_size_ = max_batch_size;
+  timeout_ = std::chrono::microseconds(timeout_micros);
+}
+
+void BatchScheduler::Enqueue(std::unique_ptr<BatchRequest> request) {
+  request->is_batchable = !request->inputs.empty();
+  for (size_t i = 0; i < request->inputs.size(); i++) {
+    TF_Tensor* input = request->inputs[i];
+    if (TF_NumDims(input) == 0 || TF_TensorType(input) == TF_STRING) {
+      request->is_batchable = false;
+    } else if (i == 0) {
+      request->num_rows = TF_Dim(input, 0);
+    } else if (TF_Dim(input, 0) != request->num_rows) {
+      request->is_batchable = false;
+    }
+  }
+  request->enqueue_time = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  queue_.push_back(std::move(request));
+  stats_.queue_depth.Add(queue_.size());
+}
+
+std::unique_ptr<BatchRequest> BatchScheduler::Remove(
+    const BatchRequest* request) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto it = queue_.begin(); it != queue_.end(); ++it) {
+    if (it->get() == request) {
+      std::unique_ptr<BatchRequest> removed = std::move(*it);
+      queue_.erase(it);
+      return removed;
+    }
+  }
+  return nullptr;
+}
+
+bool BatchScheduler::IsCompatible(const BatchRequest& head,
+                                  const BatchRequest& request) {
+  if (!head.is_batchable || !request.is_batchable ||
+      head.input_names != request.input_names ||
+      head.output_names != request.output_names) {
+    return false;
+  }
+  for (size_t i = 0; i < head.inputs.size(); i++) {
+    const TF_Tensor* a = head.inputs[i];
+    const TF_Tensor* b = request.inputs[i];
+    if (TF_TensorType(a) != TF_TensorType(b) ||
+        TF_NumDims(a) != TF_NumDims(b)) {
+      return false;
+    }
+    for (int d = 1; d < TF_NumDims(a); d++) {
+      if (TF_Dim(a, d) != TF_Dim(b, d)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int64_t BatchScheduler::CountBatchRows() {
+  const BatchRequest& head = *queue_.front();
+  if (!head.is_batchable) {
+    return max_batch_size_;
+  }
+  int64_t num_rows = 0;
+  for (size_t i = 0; i < queue_.size(); i++) {
+    const BatchRequest& request = *queue_[i];
+    if (i > 0 && !IsCompatible(head, request)) {
+      continue;
+    }
+    // A request that does not fit closes the batch.
+    if (num_rows + request.num_rows > max_batch_size_) {
+      return max_batch_size_;
+    }
+    num_rows += request.num_rows;
+  }
+  return num_rows;
+}
+
+bool BatchScheduler::IsBatchReady() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return CountBatchRows() >= max_batch_size_ ||
+         std::chrono::steady_clock::now() >=
+             queue_.front()->enqueue_time + timeout_;
+}
+
+void BatchScheduler::StartTimer() {
+  if (uv_is_active(reinterpret_cast<uv_handle_t*>(timer_))) {
+    return;
+  }
+  std::chrono::steady_clock::duration wait;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+      return;
+    }
+    wait = queue_.front()->enqueue_time + timeout_ -
+           std::chrono::steady_clock::now();
+  }
+  const int64_t wait_micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(wait).count();
+  const uint64_t wait_millis =
+      static_cast<uint64_t>(std::max<int64_t>((wait_micros + 999) / 1000, 1));
+  uv_timer_start(timer_, OnTimer, wait_millis, 0);
+}
+
+void BatchScheduler::StopTimer() { uv_timer_stop(timer_); }
+
+void BatchScheduler::OnTimer(uv_timer_t* handle) {
+  BatchScheduler* scheduler = static_cast<BatchScheduler*>(handle->data);
+  scheduler->timeout_callback_(scheduler->env_, scheduler,
+                               scheduler->timeout_data_);
+}
+
+void BatchScheduler::OnTimerClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_timer_t*>(handle);
+}
+
+void BatchScheduler::RunNextBatch(
+    std::vector<std::unique_ptr<BatchRequest>>* done) {
+  std::vector<BatchRequest*> batch;
+  int64_t num_rows = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // A deleted model takes its queued requests back.
+    if (queue_.empty()) {
+      return;
+    }
+
+    // The oldest request leads the batch and is joined by the compatible
+    // requests that fit, in queue order.
+    const BatchRequest* head = queue_.front().get();
+    for (auto it = queue_.begin(); it != queue_.end();) {
+      if (!batch.empty() &&
+          (!IsCompatible(*head, **it) ||
+           num_rows + (*it)->num_rows > max_batch_size_)) {
+        ++it;
+        continue;
+      }
+      num_rows += (*it)->num_rows;
+      batch.push_back(it->get());
+      done->push_back(std::move(*it));
+      it = queue_.erase(it);
+      if (!head->is_batchable || num_rows >= max_batch_size_) {
+        break;
+      }
+    }
+    stats_.batch_size.Add(static_cast<uint64_t>(num_rows));
+    stats_.batch_requests.Add(batch.size());
+  }
+  RunBatch(batch, num_rows);
+}
+
+TF_Tensor* BatchScheduler::NewTensor(TF_DataType dtype,
+                                     const std::vector<int64_t>& dims) {
+  size_t byte_length = TF_DataTypeSize(dtype);
+  for (size_t i = 0; i < dims.size(); i++) {
+    byte_length *= static_cast<size_t>(dims[i]);
+  }
+  const int num_dims = static_cast<int>(dims.size());
+  TF_Tensor* tensor =
+      tensor_arena_->NewTensor(dtype, dims.data(), num_dims, byte_length);
+  if (tensor == nullptr) {
+    tensor = TF_AllocateTensor(dtype, dims.data(), num_dims, byte_length);
+  }
+  return tensor;
+}
+
+// Returns the dimensions of a tensor.
+static std::vector<int64_t> GetDims(const TF_Tensor* tensor) {
+  std::vector<int64_t> dims(TF_NumDims(tensor));
+  for (size_t i = 0; i < dims.size(); i++) {
+    dims[i] = TF_Dim(tensor, static_cast<int>(i));
+  }
+  return dims;
+}
+
+void BatchScheduler::RunBatch(const std::vector<BatchRequest*>& batch,
+                              int64_t num_rows) {
+  BatchRequest* head = batch[0];
+  if (batch.size() == 1) {
+    session_->Run(head->input_names, head->inputs, head->output_names,
+                  &head->outputs, head->status.status);
+    return;
+  }
+
+  // Inputs are row-major, so concatenating along the first dimension appends
+  // the buffers of the requests.
+  std::vector<TF_Tensor*> inputs;
+  for (size_t i = 0; i < head->inputs.size(); i++) {
+    std::vector<int64_t> dims = GetDims(head->inputs[i]);
+    dims[0] = num_rows;
+    TF_Tensor* input = NewTensor(TF_TensorType(head->inputs[i]), dims);
+    char* data = static_cast<char*>(TF_TensorData(input));
+    for (size_t r = 0; r < batch.size(); r++) {
+      const size_t byte_length = TF_TensorByteSize(batch[r]->inputs[i]);
+      if (byte_length > 0) {
+        memcpy(data, TF_TensorData(batch[r]->inputs[i]), byte_length);
+        data += byte_length;
+      }
+    }
+    inputs.push_back(input);
+  }
+
+  TF_AutoStatus tf_status;
+  std::vector<TF_Tensor*> outputs;
+  session_->Run(head->input_names, inputs, head->output_names, &outputs,
+                tf_status.status);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    TF_DeleteTensor(inputs[i]);
+  }
+
+  // Every output must keep the batch dimension to be split.
+  for (size_t i = 0;
+       TF_GetCode(tf_status.status) == TF_OK && i < outputs.size(); i++) {
+    if (TF_TensorType(outputs[i]) == TF_STRING ||
+        TF_NumDims(outputs[i]) == 0 || TF_Dim(outputs[i], 0) != num_rows) {
+      const std::string message =
+          "Output " + head->output_names[i] + " of a batch of " +
+          std::to_string(num_rows) +
+          " rows cannot be split, run the model without batching";
+      TF_SetStatus(tf_status.status, TF_INVALID_ARGUMENT, message.c_str());
+    }
+  }
+
+  if (TF_GetCode(tf_status.status) == TF_OK) {
+    for (size_t i = 0; i < outputs.size(); i++) {
+      std::vector<int64_t> dims = GetDims(outputs[i]);
+      const size_t row_byte_length =
+          num_rows > 0 ? TF_TensorByteSize(outputs[i]) / num_rows : 0;
+      const char* data = static_cast<const char*>(TF_TensorData(outputs[i]));
+      for (size_t r = 0; r < batch.size(); r++) {
+        dims[0] = batch[r]->num_rows;
+        TF_Tensor* output = NewTensor(TF_TensorType(outputs[i]), dims);
+        const size_t byte_length = row_byte_length * batch[r]->num_rows;
+        if (byte_length > 0) {
+          memcpy(TF_TensorData(output), data, byte_length);
+          data += byte_length;
+        }
+        batch[r]->outputs.push_back(output);
+      }
+    }
+  } else {
+    for (size_t r = 0; r < batch.size(); r++) {
+      TF_SetStatus(batch[r]->status.status, TF_GetCode(tf_status.status),
+                   TF_Message(tf_status.status));
+    }
+  }
+  for (size_t i = 0; i < outputs.size(); i++) {
+    TF_DeleteTensor(outputs[i]);
+  }
+}
+
+void BatchScheduler::Close(
+    std::vector<std::unique_ptr<BatchRequest>>* aborted) {
+  is_closed_ = true;
+  StopTimer();
+  std::lock_guard<std::mutex> lock(mutex_);
+  while (!queue_.empty()) {
+    aborted->push_back(std::move(queue_.front()));
+    queue_.pop_front();
+  }
+}
+
+bool BatchScheduler::empty() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return queue_.empty();
+}
+
+BatchStats BatchScheduler::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace tfnodejs
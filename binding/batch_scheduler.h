@@ -0,0 +1,181 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_BATCH_SCHEDULER_H_
+#define TF_NODEJS_BATCH_SCHEDULER_H_
+
+#include <node_api.h>
+#include <uv.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "graph_session.h"
+#include "tensor_arena.h"
+#include "tensorflow/c/c_api.h"
+#include "tf_auto_status.h"
+
+namespace tfnodejs {
+
+struct ExecutionContext;
+
+// Counts values in power-of-two buckets. Bucket 0 holds values up to 1 and
+// bucket i > 0 holds values in (2^(i-1), 2^i].
+struct BatchHistogram {
+  BatchHistogram() : count(0), sum(0), max(0) {}
+
+  void Add(uint64_t value);
+
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  std::vector<uint64_t> buckets;
+};
+
+// A snapshot of the histograms of a BatchScheduler.
+struct BatchStats {
+  // Requests queued when a request is added, including itself.
+  BatchHistogram queue_depth;
+  // Rows of each executed batch.
+  BatchHistogram batch_size;
+  // Requests of each executed batch.
+  BatchHistogram batch_requests;
+};
+
+// A graph model run waiting to be batched. Inputs are concatenated along
+// their first dimension with the inputs of other requests for the same input
+// and output names, dtypes and trailing dimensions.
+struct BatchRequest {
+  BatchRequest();
+  ~BatchRequest();
+
+  std::vector<std::string> input_names;
+  std::vector<std::string> output_names;
+  // Owned feeds, resolved on the main thread.
+  std::vector<TF_Tensor*> inputs;
+  // Owned fetches, set once the request ran.
+  std::vector<TF_Tensor*> outputs;
+  // Set if the request failed.
+  TF_AutoStatus status;
+  // Rows of the request and whether it can share a batch, set by Enqueue().
+  // Requests without inputs, with scalar or string inputs, or with inputs of
+  // different first dimensions run alone.
+  int64_t num_rows;
+  bool is_batchable;
+  std::chrono::steady_clock::time_point enqueue_time;
+  // Context the outputs are created in.
+  ExecutionContext* context;
+  napi_deferred deferred;
+};
+
+// Collects concurrent runs of one graph model into batches. Requests are
+// queued on the main thread, which waits on the loop until the oldest request
+// has `max_batch_size` rows of compatible requests to join or
+// `timeout_micros` have passed since it was queued. RunNextBatch() then runs
+// them on a worker thread as one session call and splits the fetched tensors
+// back per request.
+class BatchScheduler {
+ public:
+  // Called on the main loop when the oldest request timed out.
+  typedef void (*TimeoutCallback)(napi_env env, BatchScheduler* scheduler,
+                                  void* data);
+
+  BatchScheduler(int32_t model_id, std::shared_ptr<GraphSession> session,
+                 TensorArena* tensor_arena);
+  ~BatchScheduler();
+
+  // Creates the timer of the batch timeout on the loop of `env`.
+  napi_status InitTimer(napi_env env, TimeoutCallback callback, void* data);
+
+  // Sets the row cap of a batch and how long the oldest request waits for a
+  // batch to fill. A cap of 1 runs every request alone.
+  void Configure(int64_t max_batch_size, int64_t timeout_micros);
+
+  // Queues a request.
+  void Enqueue(std::unique_ptr<BatchRequest> request);
+
+  // Takes a queued request back out.
+  std::unique_ptr<BatchRequest> Remove(const BatchRequest* request);
+
+  // Returns whether the oldest request has a full batch or timed out.
+  // Requires a non-empty queue.
+  bool IsBatchReady();
+
+  // Calls the timeout callback once the oldest request times out, unless the
+  // timer is already started or the queue is empty. libuv timers count whole
+  // milliseconds, so the wait rounds up to at least one.
+  void StartTimer();
+  void StopTimer();
+
+  // Takes the next batch without waiting, runs it and appends the requests
+  // it completed to `done`. Does nothing on an empty queue.
+  void RunNextBatch(std::vector<std::unique_ptr<BatchRequest>>* done);
+
+  // Marks the scheduler of a deleted model and moves the queued requests to
+  // `aborted`.
+  void Close(std::vector<std::unique_ptr<BatchRequest>>* aborted);
+
+  int32_t model_id() const { return model_id_; }
+  bool empty();
+  BatchStats GetStats();
+
+  // Main-thread state: whether the scheduler was closed and whether a
+  // RunNextBatch() call is scheduled.
+  bool is_closed() const { return is_closed_; }
+  bool is_running() const { return is_running_; }
+  void set_running(bool is_running) { is_running_ = is_running; }
+
+ private:
+  // Returns whether `request` can join a batch led by `head`.
+  static bool IsCompatible(const BatchRequest& head,
+                           const BatchRequest& request);
+
+  // Returns the rows of the requests that can join a batch led by the oldest
+  // request, up to `max_batch_size_`. Requires `mutex_`.
+  int64_t CountBatchRows();
+
+  // Runs the requests of a batch and sets their outputs or status.
+  void RunBatch(const std::vector<BatchRequest*>& batch, int64_t num_rows);
+
+  // Returns an uninitialized tensor, recycled through the arena if possible.
+  TF_Tensor* NewTensor(TF_DataType dtype, const std::vector<int64_t>& dims);
+
+  static void OnTimer(uv_timer_t* handle);
+  static void OnTimerClose(uv_handle_t* handle);
+
+  int32_t model_id_;
+  std::shared_ptr<GraphSession> session_;
+  TensorArena* tensor_arena_;
+  napi_env env_;
+  uv_timer_t* timer_;
+  TimeoutCallback timeout_callback_;
+  void* timeout_data_;
+  std::mutex mutex_;
+  std::deque<std::unique_ptr<BatchRequest>> queue_;
+  int64_t max_batch_size_;
+  std::chrono::microseconds timeout_;
+  bool is_closed_;
+  bool is_running_;
+  BatchStats stats_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_BATCH_SCHEDULER_H_
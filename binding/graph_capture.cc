@@ -0,0 +1,357 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#include "graph_capture.h"
+
+#include "proto_utils.h"
+#include "tfjs_backend.h"
+
+namespace tfnodejs {
+
+// Field numbers from tensorflow/core/framework/op_def.proto.
+static const uint32_t kOpDefInputArg = 2;
+static const uint32_t kArgDefNumberAttr = 5;
+static const uint32_t kArgDefTypeListAttr = 6;
+
+// Graph counterpart of ApplyOpAttr(). Returns false with `status` set for
+// attribute types that cannot be captured.
+static bool SetOperationAttr(TF_OperationDescription* desc,
+                             const OpAttr& attr, TF_Status* status) {
+  switch (attr.type) {
+    case TF_ATTR_STRING:
+      TF_SetAttrString(desc, attr.name, attr.string_value.data(),
+                       attr.string_value.size());
+      return true;
+
+    case TF_ATTR_INT:
+      if (attr.is_list) {
+        TF_SetAttrIntList(desc, attr.name, attr.int_values.data(),
+                          static_cast<int>(attr.int_values.size()));
+      } else {
+        TF_SetAttrInt(desc, attr.name, attr.int_values[0]);
+      }
+      return true;
+
+    case TF_ATTR_FLOAT:
+      if (attr.is_list) {
+        TF_SetAttrFloatList(desc, attr.name, attr.float_values.data(),
+                            static_cast<int>(attr.float_values.size()));
+      } else {
+        TF_SetAttrFloat(desc, attr.name, attr.float_values[0]);
+      }
+      return true;
+
+    case TF_ATTR_BOOL:
+      if (attr.is_list) {
+        TF_SetAttrBoolList(desc, attr.name, attr.bool_values.data(),
+                           static_cast<int>(attr.bool_values.size()));
+      } else {
+        TF_SetAttrBool(desc, attr.name, attr.bool_values[0]);
+      }
+      return true;
+
+    case TF_ATTR_TYPE:
+      if (attr.is_list) {
+        std::vector<TF_DataType> types;
+        for (size_t i = 0; i < attr.int_values.size(); i++) {
+          types.push_back(static_cast<TF_DataType>(attr.int_values[i]));
+        }
+        TF_SetAttrTypeList(desc, attr.name, types.data(),
+                           static_cast<int>(types.size()));
+      } else {
+        TF_SetAttrType(desc, attr.name,
+                       static_cast<TF_DataType>(attr.int_values[0]));
+      }
+      return true;
+
+    case TF_ATTR_SHAPE:
+      TF_SetAttrShape(desc, attr.name, attr.int_values.data(),
+                      static_cast<int>(attr.int_values.size()));
+      return true;
+
+    default: {
+      std::string message = std::string("Attribute '") + attr.name +
+                            "' cannot be captured (type: " +
+                            std::to_string(attr.type) + ")";
+      TF_SetStatus(status, TF_INVALID_ARGUMENT, message.c_str());
+      return false;
+    }
+  }
+}
+
+// Finishes an operation description. TF_FinishOperation() must be called
+// even after an attribute failed, but overwrites the status it is given, so
+// the attribute failure is copied over afterwards.
+static TF_Operation* FinishOperation(TF_OperationDescription* desc,
+                                     TF_Status* attr_status,
+                                     TF_Status* status) {
+  TF_Operation* oper = TF_FinishOperation(desc, status);
+  if (TF_GetCode(attr_status) != TF_OK) {
+    TF_SetStatus(status, TF_GetCode(attr_status), TF_Message(attr_status));
+    return nullptr;
+  }
+  return TF_GetCode(status) == TF_OK ? oper : nullptr;
+}
+
+GraphCapture::GraphCapture()
+    : graph_(TF_NewGraph()), num_ops_(0), next_node_id_(0) {}
+
+GraphCapture::~GraphCapture() { TF_DeleteGraph(graph_); }
+
+void GraphCapture::AddInput(TFE_TensorHandle* handle) {
+  if (TF_GetCode(status_.status) != TF_OK) {
+    return;
+  }
+
+  std::string name = "input_" + std::to_string(inputs_.size());
+  TF_OperationDescription* desc =
+      TF_NewOperation(graph_, "Placeholder", name.c_str());
+  TF_SetAttrType(desc, "dtype", TFE_TensorHandleDataType(handle));
+  TF_Operation* oper = TF_FinishOperation(desc, status_.status);
+  if (TF_GetCode(status_.status) != TF_OK) {
+    return;
+  }
+
+  TF_Output output = {oper, 0};
+  inputs_.push_back(output);
+  values_[handle] = output;
+}
+
+void GraphCapture::AddOp(const char* op_name,
+                         const std::vector<OpAttr>& attrs,
+                         const std::vector<TFE_TensorHandle*>& inputs,
+                         const std::vector<TFE_TensorHandle*>& outputs) {
+  if (TF_GetCode(status_.status) != TF_OK) {
+    return;
+  }
+
+  std::vector<int> sizes;
+  if (!GetInputSizes(op_name, attrs, inputs.size(), &sizes)) {
+    return;
+  }
+  std::vector<TF_Output> op_inputs(inputs.size());
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (!GetOutput(inputs[i], &op_inputs[i])) {
+      return;
+    }
+  }
+
+  std::string name = NewNodeName(op_name);
+  TF_OperationDescription* desc =
+      TF_NewOperation(graph_, op_name, name.c_str());
+  size_t offset = 0;
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (sizes[i] < 0) {
+      TF_AddInput(desc, op_inputs[offset++]);
+    } else {
+      TF_AddInputList(desc, op_inputs.data() + offset, sizes[i]);
+      offset += sizes[i];
+    }
+  }
+  TF_AutoStatus attr_status;
+  for (size_t i = 0; i < attrs.size(); i++) {
+    if (!SetOperationAttr(desc, attrs[i], attr_status.status)) {
+      break;
+    }
+  }
+  TF_Operation* oper =
+      FinishOperation(desc, attr_status.status, status_.status);
+  if (oper == nullptr) {
+    return;
+  }
+
+  for (size_t i = 0; i < outputs.size(); i++) {
+    TF_Output output = {oper, static_cast<int>(i)};
+    values_[outputs[i]] = output;
+  }
+  num_ops_++;
+}
+
+void GraphCapture::RemoveHandle(TFE_TensorHandle* handle) {
+  values_.erase(handle);
+}
+
+TF_Function* GraphCapture::ToFunction(
+    const char* name, const std::vector<TFE_TensorHandle*>& outputs,
+    TF_Status* status) {
+  std::vector<TF_Output> function_outputs(outputs.size());
+  for (size_t i = 0;
+       i < outputs.size() && TF_GetCode(status_.status) == TF_OK; i++) {
+    if (!GetOutput(outputs[i], &function_outputs[i])) {
+      break;
+    }
+
+    // Return arguments through an Identity node, so that no output is also
+    // an argument of the function.
+    for (size_t j = 0; j < inputs_.size(); j++) {
+      if (inputs_[j].oper != function_outputs[i].oper) {
+        continue;
+      }
+      std::string identity_name = NewNodeName("Identity");
+      TF_OperationDescription* desc =
+          TF_NewOperation(graph_, "Identity", identity_name.c_str());
+      TF_AddInput(desc, function_outputs[i]);
+      TF_Operation* oper = TF_FinishOperation(desc, status_.status);
+      function_outputs[i].oper = oper;
+      function_outputs[i].index = 0;
+      break;
+    }
+  }
+  if (TF_GetCode(status_.status) != TF_OK) {
+    TF_SetStatus(status, TF_GetCode(status_.status),
+                 TF_Message(status_.status));
+    return nullptr;
+  }
+
+  return TF_GraphToFunction(
+      graph_, name, /*append_hash_to_fn_name=*/0, /*num_opers=*/-1,
+      /*opers=*/nullptr, static_cast<int>(inputs_.size()), inputs_.data(),
+      static_cast<int>(function_outputs.size()), function_outputs.data(),
+      /*output_names=*/nullptr, /*opts=*/nullptr, /*description=*/nullptr,
+      status);
+}
+
+bool GraphCapture::GetOutput(TFE_TensorHandle* handle, TF_Output* output) {
+  auto value = values_.find(handle);
+  if (value != values_.end()) {
+    *output = value->second;
+    return true;
+  }
+
+  // Any other value is read as it is now, e.g. model weights or a tensor
+  // created while capturing.
+  TF_Tensor* tensor = TFE_TensorHandleResolve(handle, status_.status);
+  if (TF_GetCode(status_.status) != TF_OK) {
+    return false;
+  }
+  if (TF_TensorType(tensor) == TF_RESOURCE) {
+    TF_DeleteTensor(tensor);
+    TF_SetStatus(status_.status, TF_INVALID_ARGUMENT,
+                 "Resource tensors cannot be captured as constants");
+    return false;
+  }
+
+  std::string name = NewNodeName("Const");
+  TF_OperationDescription* desc =
+      TF_NewOperation(graph_, "Const", name.c_str());
+  TF_AutoStatus attr_status;
+  TF_SetAttrTensor(desc, "value", tensor, attr_status.status);
+  TF_SetAttrType(desc, "dtype", TF_TensorType(tensor));
+  TF_DeleteTensor(tensor);
+  TF_Operation* oper =
+      FinishOperation(desc, attr_status.status, status_.status);
+  if (oper == nullptr) {
+    return false;
+  }
+
+  output->oper = oper;
+  output->index = 0;
+  values_[handle] = *output;
+  return true;
+}
+
+bool GraphCapture::GetInputSizes(const char* op_name,
+                                 const std::vector<OpAttr>& attrs,
+                                 size_t num_inputs, std::vector<int>* sizes) {
+  auto input_args = input_args_.find(op_name);
+  if (input_args == input_args_.end()) {
+    TF_Buffer* op_def = TF_NewBuffer();
+    TF_GraphGetOpDef(graph_, op_name, op_def, status_.status);
+    std::vector<InputArg> args;
+    bool is_valid =
+        TF_GetCode(status_.status) == TF_OK &&
+        ForEachProtoField(
+            static_cast<const uint8_t*>(op_def->data), op_def->length,
+            [&args](uint32_t field, const uint8_t* data, size_t length) {
+              if (field != kOpDefInputArg) {
+                return;
+              }
+              InputArg arg;
+              ForEachProtoField(
+                  data, length,
+                  [&arg](uint32_t field, const uint8_t* data, size_t length) {
+                    const char* chars = reinterpret_cast<const char*>(data);
+                    if (field == kArgDefNumberAttr) {
+                      arg.number_attr.assign(chars, length);
+                    } else if (field == kArgDefTypeListAttr) {
+                      arg.type_list_attr.assign(chars, length);
+                    }
+                  });
+              args.push_back(arg);
+            });
+    TF_DeleteBuffer(op_def);
+    if (TF_GetCode(status_.status) != TF_OK) {
+      return false;
+    }
+    if (!is_valid) {
+      TF_SetStatus(status_.status, TF_INTERNAL,
+                   (std::string("Invalid OpDef for ") + op_name).c_str());
+      return false;
+    }
+    input_args = input_args_.emplace(op_name, std::move(args)).first;
+  }
+
+  // Eager Ops infer the length of a list argument from the inputs, so one
+  // list without a length attribute takes the inputs that are left over.
+  const std::vector<InputArg>& args = input_args->second;
+  const int kUnknownSize = -2;
+  sizes->assign(args.size(), -1);
+  size_t num_known_inputs = 0;
+  int unknown_arg = -1;
+  bool is_valid = true;
+  for (size_t i = 0; i < args.size(); i++) {
+    const InputArg& arg = args[i];
+    if (arg.number_attr.empty() && arg.type_list_attr.empty()) {
+      num_known_inputs++;
+      continue;
+    }
+    (*sizes)[i] = kUnknownSize;
+    for (size_t j = 0; j < attrs.size(); j++) {
+      if (arg.number_attr == attrs[j].name && !attrs[j].int_values.empty()) {
+        (*sizes)[i] = static_cast<int>(attrs[j].int_values[0]);
+      } else if (arg.type_list_attr == attrs[j].name) {
+        (*sizes)[i] = static_cast<int>(attrs[j].int_values.size());
+      }
+    }
+    if ((*sizes)[i] != kUnknownSize) {
+      num_known_inputs += (*sizes)[i];
+    } else if (unknown_arg < 0) {
+      unknown_arg = static_cast<int>(i);
+    } else {
+      is_valid = false;
+    }
+  }
+  if (unknown_arg >= 0 && num_known_inputs <= num_inputs) {
+    (*sizes)[unknown_arg] = static_cast<int>(num_inputs - num_known_inputs);
+    num_known_inputs = num_inputs;
+  }
+  if (!is_valid || num_known_inputs != num_inputs) {
+    TF_SetStatus(
+        status_.status, TF_INVALID_ARGUMENT,
+        (std::string("Cannot match the inputs of ") + op_name +
+         " to its OpDef")
+            .c_str());
+    return false;
+  }
+  return true;
+}
+
+std::string GraphCapture::NewNodeName(const char* op_name) {
+  return std::string(op_name) + "_" + std::to_string(next_node_id_++);
+}
+
+}  // namespace tfnodejs
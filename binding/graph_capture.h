@@ -0,0 +1,97 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_GRAPH_CAPTURE_H_
+#define TF_NODEJS_GRAPH_CAPTURE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include "tensorflow/c/c_api.h"
+#include "tensorflow/c/eager/c_api.h"
+#include "tf_auto_status.h"
+
+namespace tfnodejs {
+
+struct OpAttr;
+
+// Records eagerly executed Ops into a TF_Graph, so that the sequence can be
+// registered as a TF_Function and replayed as a single Op.
+//
+// Values are tracked by the TFE_TensorHandle that holds them eagerly. Handles
+// added with AddInput() become function arguments, outputs of recorded Ops
+// map to the outputs of their graph nodes and any other handle an Op reads is
+// captured as a constant. Recording never interrupts eager execution: the
+// first failure is kept and reported by ToFunction().
+class GraphCapture {
+ public:
+  GraphCapture();
+  ~GraphCapture();
+
+  // Adds a function argument that is fed by `handle` while capturing.
+  void AddInput(TFE_TensorHandle* handle);
+
+  // Records an Op that read `inputs` and produced `outputs`.
+  void AddOp(const char* op_name, const std::vector<OpAttr>& attrs,
+             const std::vector<TFE_TensorHandle*>& inputs,
+             const std::vector<TFE_TensorHandle*>& outputs);
+
+  // Forgets a handle that is about to be deleted, so that a new handle at the
+  // same address is not mistaken for it.
+  void RemoveHandle(TFE_TensorHandle* handle);
+
+  // Builds a function named `name` that returns the values of `outputs`.
+  // Returns nullptr with `status` set on failure.
+  TF_Function* ToFunction(const char* name,
+                          const std::vector<TFE_TensorHandle*>& outputs,
+                          TF_Status* status);
+
+  int num_ops() const { return num_ops_; }
+
+ private:
+  // Input argument of an OpDef. List arguments take the number of values
+  // from an int attribute or the length of a type list attribute.
+  struct InputArg {
+    std::string number_attr;
+    std::string type_list_attr;
+  };
+
+  // Returns the graph output holding the value of `handle`, capturing it as
+  // a constant if it is not known yet.
+  bool GetOutput(TFE_TensorHandle* handle, TF_Output* output);
+
+  // Splits `num_inputs` flat Op inputs into the sizes of the OpDef input
+  // arguments. A size of -1 marks a single, non-list input.
+  bool GetInputSizes(const char* op_name, const std::vector<OpAttr>& attrs,
+                     size_t num_inputs, std::vector<int>* sizes);
+
+  // Returns a unique node name for an Op type.
+  std::string NewNodeName(const char* op_name);
+
+  TF_Graph* graph_;
+  std::map<TFE_TensorHandle*, TF_Output> values_;
+  std::vector<TF_Output> inputs_;
+  std::map<std::string, std::vector<InputArg>> input_args_;
+  // First recording failure.
+  TF_AutoStatus status_;
+  int num_ops_;
+  int next_node_id_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_GRAPH_CAPTURE_H_
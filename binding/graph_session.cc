@@ -0,0 +1,318 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#include "graph_session.h"
+
+#include <cstdlib>
+#include "proto_utils.h"
+#include "tf_auto_status.h"
+
+namespace tfnodejs {
+
+// Field numbers from tensorflow/core/protobuf/meta_graph.proto and
+// tensorflow/core/framework/tensor_shape.proto.
+static const uint32_t kMetaGraphDefSignatureDef = 5;
+static const uint32_t kMapEntryKey = 1;
+static const uint32_t kMapEntryValue = 2;
+static const uint32_t kSignatureDefInputs = 1;
+static const uint32_t kSignatureDefOutputs = 2;
+static const uint32_t kSignatureDefMethodName = 3;
+static const uint32_t kTensorInfoName = 1;
+static const uint32_t kTensorInfoDtype = 2;
+static const uint32_t kTensorInfoTensorShape = 3;
+static const uint32_t kTensorShapeDim = 2;
+static const uint32_t kTensorShapeUnknownRank = 3;
+static const uint32_t kDimSize = 1;
+
+// Reads the key and the serialized value of a map entry.
+static bool ParseMapEntry(const uint8_t* data, size_t length,
+                          std::string* key, const uint8_t** value,
+                          size_t* value_length) {
+  *value = nullptr;
+  *value_length = 0;
+  return ForEachProtoField(
+      data, length,
+      [&](uint32_t field, const uint8_t* field_data, size_t field_length) {
+        if (field == kMapEntryKey) {
+          key->assign(reinterpret_cast<const char*>(field_data),
+                      field_length);
+        } else if (field == kMapEntryValue) {
+          *value = field_data;
+          *value_length = field_length;
+        }
+      });
+}
+
+static bool ParseTensorShape(const uint8_t* data, size_t length,
+                             SignatureTensor* tensor) {
+  bool is_valid = true;
+  tensor->has_rank = true;
+  is_valid &= ForEachProtoField(
+      data, length,
+      [&](uint32_t field, const uint8_t* dim_data, size_t dim_length) {
+        if (field != kTensorShapeDim) {
+          return;
+        }
+        int64_t size = 0;
+        is_valid &= ForEachProtoField(
+            dim_data, dim_length,
+            [](uint32_t field, const uint8_t* data, size_t length) {},
+            [&size](uint32_t field, uint64_t value) {
+              if (field == kDimSize) {
+                size = static_cast<int64_t>(value);
+              }
+            });
+        tensor->shape.push_back(size);
+      },
+      [tensor](uint32_t field, uint64_t value) {
+        if (field == kTensorShapeUnknownRank && value != 0) {
+          tensor->has_rank = false;
+        }
+      });
+  if (!tensor->has_rank) {
+    tensor->shape.clear();
+  }
+  return is_valid;
+}
+
+static bool ParseTensorInfo(const uint8_t* data, size_t length,
+                            SignatureTensor* tensor) {
+  bool is_valid = true;
+  is_valid &= ForEachProtoField(
+      data, length,
+      [&](uint32_t field, const uint8_t* field_data, size_t field_length) {
+        if (field == kTensorInfoName) {
+          tensor->name.assign(reinterpret_cast<const char*>(field_data),
+                              field_length);
+        } else if (field == kTensorInfoTensorShape) {
+          is_valid &= ParseTensorShape(field_data, field_length, tensor);
+        }
+      },
+      [tensor](uint32_t field, uint64_t value) {
+        if (field == kTensorInfoDtype) {
+          tensor->dtype = static_cast<TF_DataType>(value);
+        }
+      });
+  return is_valid;
+}
+
+static bool ParseSignatureDef(const uint8_t* data, size_t length,
+                              SignatureDef* signature) {
+  bool is_valid = true;
+  is_valid &= ForEachProtoField(
+      data, length,
+      [&](uint32_t field, const uint8_t* field_data, size_t field_length) {
+        if (field == kSignatureDefMethodName) {
+          signature->method_name.assign(
+              reinterpret_cast<const char*>(field_data), field_length);
+          return;
+        }
+        if (field != kSignatureDefInputs && field != kSignatureDefOutputs) {
+          return;
+        }
+        std::string key;
+        const uint8_t* value;
+        size_t value_length;
+        is_valid &= ParseMapEntry(field_data, field_length, &key, &value,
+                                  &value_length);
+        SignatureTensor& tensor = field == kSignatureDefInputs
+                                      ? signature->inputs[key]
+                                      : signature->outputs[key];
+        if (value != nullptr) {
+          is_valid &= ParseTensorInfo(value, value_length, &tensor);
+        }
+      });
+  return is_valid;
+}
+
+// Parses the signatures of a serialized MetaGraphDef.
+static bool ParseSignatureDefs(
+    const uint8_t* data, size_t length,
+    std::map<std::string, SignatureDef>* signatures) {
+  bool is_valid = true;
+  is_valid &= ForEachProtoField(
+      data, length,
+      [&](uint32_t field, const uint8_t* field_data, size_t field_length) {
+        if (field != kMetaGraphDefSignatureDef) {
+          return;
+        }
+        std::string key;
+        const uint8_t* value;
+        size_t value_length;
+        is_valid &= ParseMapEntry(field_data, field_length, &key, &value,
+                                  &value_length);
+        SignatureDef& signature = (*signatures)[key];
+        if (value != nullptr) {
+          is_valid &= ParseSignatureDef(value, value_length, &signature);
+        }
+      });
+  return is_valid;
+}
+
+TF_SessionOptions* GraphSession::NewSessionOptions(
+    const std::string& config_proto, TF_Status* status) {
+  TF_SessionOptions* session_options = TF_NewSessionOptions();
+  if (!config_proto.empty()) {
+    TF_SetConfig(session_options, config_proto.data(), config_proto.size(),
+                 status);
+    if (TF_GetCode(status) != TF_OK) {
+      TF_DeleteSessionOptions(session_options);
+      return nullptr;
+    }
+  }
+  return session_options;
+}
+
+GraphSession* GraphSession::Create(const void* graph_def,
+                                   size_t graph_def_length,
+                                   const std::string& config_proto,
+                                   TF_Status* status) {
+  TF_Graph* graph = TF_NewGraph();
+  TF_Buffer* graph_def_buffer =
+      TF_NewBufferFromString(graph_def, graph_def_length);
+  TF_ImportGraphDefOptions* import_options = TF_NewImportGraphDefOptions();
+  TF_GraphImportGraphDef(graph, graph_def_buffer, import_options, status);
+  TF_DeleteImportGraphDefOptions(import_options);
+  TF_DeleteBuffer(graph_def_buffer);
+  if (TF_GetCode(status) != TF_OK) {
+    TF_DeleteGraph(graph);
+    return nullptr;
+  }
+
+  TF_SessionOptions* session_options = NewSessionOptions(config_proto, status);
+  if (session_options == nullptr) {
+    TF_DeleteGraph(graph);
+    return nullptr;
+  }
+  TF_Session* session = TF_NewSession(graph, session_options, status);
+  TF_DeleteSessionOptions(session_options);
+  if (TF_GetCode(status) != TF_OK) {
+    TF_DeleteGraph(graph);
+    return nullptr;
+  }
+  return new GraphSession(graph, session);
+}
+
+GraphSession* GraphSession::LoadSavedModel(const std::string& export_dir,
+                                           const std::vector<std::string>& tags,
+                                           const std::string& config_proto,
+                                           TF_Status* status) {
+  TF_SessionOptions* session_options = NewSessionOptions(config_proto, status);
+  if (session_options == nullptr) {
+    return nullptr;
+  }
+  std::vector<const char*> tag_names;
+  for (size_t i = 0; i < tags.size(); i++) {
+    tag_names.push_back(tags[i].c_str());
+  }
+
+  TF_Graph* graph = TF_NewGraph();
+  TF_Buffer* meta_graph_def = TF_NewBuffer();
+  TF_Session* session = TF_LoadSessionFromSavedModel(
+      session_options, nullptr, export_dir.c_str(), tag_names.data(),
+      static_cast<int>(tag_names.size()), graph, meta_graph_def, status);
+  TF_DeleteSessionOptions(session_options);
+  if (TF_GetCode(status) != TF_OK) {
+    TF_DeleteBuffer(meta_graph_def);
+    TF_DeleteGraph(graph);
+    return nullptr;
+  }
+
+  GraphSession* graph_session = new GraphSession(graph, session);
+  const bool is_valid = ParseSignatureDefs(
+      static_cast<const uint8_t*>(meta_graph_def->data),
+      meta_graph_def->length, &graph_session->signatures_);
+  TF_DeleteBuffer(meta_graph_def);
+  if (!is_valid) {
+    delete graph_session;
+    TF_SetStatus(status, TF_INTERNAL,
+                 ("Invalid MetaGraphDef in SavedModel " + export_dir).c_str());
+    return nullptr;
+  }
+  return graph_session;
+}
+
+GraphSession::GraphSession(TF_Graph* graph, TF_Session* session)
+    : graph_(graph), session_(session) {}
+
+GraphSession::~GraphSession() {
+  // Errors cannot be reported from here, the session is released either way.
+  TF_AutoStatus tf_status;
+  TF_CloseSession(session_, tf_status.status);
+  TF_DeleteSession(session_, tf_status.status);
+  TF_DeleteGraph(graph_);
+}
+
+bool GraphSession::GetOutput(const std::string& name, TF_Output* output,
+                             TF_Status* status) {
+  std::lock_guard<std::mutex> lock(outputs_mutex_);
+  auto cached = outputs_.find(name);
+  if (cached != outputs_.end()) {
+    *output = cached->second;
+    return true;
+  }
+
+  // A trailing `:index` selects an output other than the first one.
+  std::string node_name = name;
+  int index = 0;
+  const size_t colon = name.rfind(':');
+  if (colon != std::string::npos && colon + 1 < name.size() &&
+      name.find_first_not_of("0123456789", colon + 1) == std::string::npos) {
+    node_name = name.substr(0, colon);
+    index = atoi(name.c_str() + colon + 1);
+  }
+
+  TF_Operation* oper = TF_GraphOperationByName(graph_, node_name.c_str());
+  if (oper == nullptr || index >= TF_OperationNumOutputs(oper)) {
+    const std::string message = "Graph has no tensor named " + name;
+    TF_SetStatus(status, TF_NOT_FOUND, message.c_str());
+    return false;
+  }
+  output->oper = oper;
+  output->index = index;
+  outputs_[name] = *output;
+  return true;
+}
+
+void GraphSession::Run(const std::vector<std::string>& input_names,
+                       const std::vector<TF_Tensor*>& inputs,
+                       const std::vector<std::string>& output_names,
+                       std::vector<TF_Tensor*>* outputs, TF_Status* status) {
+  std::vector<TF_Output> feeds(input_names.size());
+  for (size_t i = 0; i < input_names.size(); i++) {
+    if (!GetOutput(input_names[i], &feeds[i], status)) {
+      return;
+    }
+  }
+  std::vector<TF_Output> fetches(output_names.size());
+  for (size_t i = 0; i < output_names.size(); i++) {
+    if (!GetOutput(output_names[i], &fetches[i], status)) {
+      return;
+    }
+  }
+
+  outputs->assign(fetches.size(), nullptr);
+  TF_SessionRun(session_, nullptr, feeds.data(), inputs.data(),
+                static_cast<int>(feeds.size()), fetches.data(),
+                outputs->data(), static_cast<int>(fetches.size()), nullptr, 0,
+                nullptr, status);
+  if (TF_GetCode(status) != TF_OK) {
+    outputs->clear();
+  }
+}
+
+}  // namespace tfnodejs
@@ -0,0 +1,106 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_GRAPH_SESSION_H_
+#define TF_NODEJS_GRAPH_SESSION_H_
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "tensorflow/c/c_api.h"
+
+namespace tfnodejs {
+
+// A tensor of a SignatureDef.
+struct SignatureTensor {
+  SignatureTensor() : dtype(TF_FLOAT), has_rank(false) {}
+
+  // Name of the graph tensor. Empty for sparse and composite tensors.
+  std::string name;
+  TF_DataType dtype;
+  // Whether the rank is known. Unknown sizes in `shape` are -1.
+  bool has_rank;
+  std::vector<int64_t> shape;
+};
+
+// A named signature of a SavedModel, keyed by its input and output names.
+struct SignatureDef {
+  std::string method_name;
+  std::map<std::string, SignatureTensor> inputs;
+  std::map<std::string, SignatureTensor> outputs;
+};
+
+// A TF_Graph imported from a serialized GraphDef or loaded from a SavedModel,
+// and the TF_Session that runs it. Running the whole graph in one session call
+// lets TensorFlow optimize it (e.g. fold constants) and avoids a round trip to
+// JS for every node.
+class GraphSession {
+ public:
+  // Imports `graph_def` and creates a session for it, configured by a
+  // serialized ConfigProto. Returns nullptr with `status` set on failure.
+  static GraphSession* Create(const void* graph_def, size_t graph_def_length,
+                              const std::string& config_proto,
+                              TF_Status* status);
+
+  // Loads the MetaGraph of a SavedModel that matches `tags`, restores its
+  // variables into a new session and parses its signatures. Returns nullptr
+  // with `status` set on failure.
+  static GraphSession* LoadSavedModel(const std::string& export_dir,
+                                      const std::vector<std::string>& tags,
+                                      const std::string& config_proto,
+                                      TF_Status* status);
+  ~GraphSession();
+
+  // Signatures by key. Empty unless loaded from a SavedModel.
+  const std::map<std::string, SignatureDef>& signatures() const {
+    return signatures_;
+  }
+
+  // Runs the graph, feeding `inputs` to the tensors named by `input_names`,
+  // and stores the tensors named by `output_names` in `outputs`. Tensor names
+  // are `node` or `node:index`. The caller owns the output tensors. Runs may
+  // overlap on different threads.
+  void Run(const std::vector<std::string>& input_names,
+           const std::vector<TF_Tensor*>& inputs,
+           const std::vector<std::string>& output_names,
+           std::vector<TF_Tensor*>* outputs, TF_Status* status);
+
+ private:
+  GraphSession(TF_Graph* graph, TF_Session* session);
+
+  // Resolves a tensor name to a graph output. Sets `status` and returns false
+  // if the graph has no such tensor.
+  bool GetOutput(const std::string& name, TF_Output* output,
+                 TF_Status* status);
+
+  // Returns new session options configured by a serialized ConfigProto, or
+  // nullptr with `status` set if the proto is invalid.
+  static TF_SessionOptions* NewSessionOptions(const std::string& config_proto,
+                                              TF_Status* status);
+
+  TF_Graph* graph_;
+  TF_Session* session_;
+  std::map<std::string, SignatureDef> signatures_;
+  // Graph outputs by tensor name, filled as names are resolved.
+  std::mutex outputs_mutex_;
+  std::map<std::string, TF_Output> outputs_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_GRAPH_SESSION_H_
@@ -0,0 +1,121 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#include "napi_ref_release_queue.h"
+
+#include <cstdio>
+#include <thread>
+
+namespace tfnodejs {
+
+NapiRefReleaseQueue::NapiRefReleaseQueue()
+    : head_(nullptr),
+      shut_down_(false),
+      num_pushing_(0),
+      async_(nullptr),
+      num_released_(0) {}
+
+NapiRefReleaseQueue::~NapiRefReleaseQueue() { Shutdown(); }
+
+void NapiRefReleaseQueue::Shutdown() {
+  if (shut_down_.exchange(true)) {
+    return;
+  }
+  // A producer either sees the flag or is counted before this check, so once
+  // the count drops to zero no entry can be linked or signaled anymore.
+  while (num_pushing_.load() != 0) {
+    std::this_thread::yield();
+  }
+  Drain();
+  if (async_ != nullptr) {
+    async_->data = nullptr;
+    uv_close(reinterpret_cast<uv_handle_t*>(async_), OnClose);
+    async_ = nullptr;
+  }
+}
+
+napi_status NapiRefReleaseQueue::Init(napi_env env) {
+  uv_loop_t* loop;
+  napi_status nstatus = napi_get_uv_event_loop(env, &loop);
+  if (nstatus != napi_ok) {
+    return nstatus;
+  }
+
+  async_ = new uv_async_t();
+  if (uv_async_init(loop, async_, OnAsync) != 0) {
+    delete async_;
+    async_ = nullptr;
+    return napi_generic_failure;
+  }
+  async_->data = this;
+  // Pending releases should not keep the process alive.
+  uv_unref(reinterpret_cast<uv_handle_t*>(async_));
+  return napi_ok;
+}
+
+void NapiRefReleaseQueue::Push(Entry* entry) {
+  // Sequentially consistent, so that Shutdown() either waits for this push
+  // or the push sees the queue shut down.
+  num_pushing_.fetch_add(1);
+  if (shut_down_.load()) {
+    num_pushing_.fetch_sub(1);
+    delete entry;
+    return;
+  }
+
+  Entry* head = head_.load(std::memory_order_relaxed);
+  do {
+    entry->next = head;
+  } while (!head_.compare_exchange_weak(
+      head, entry, std::memory_order_release, std::memory_order_relaxed));
+
+  // Only the push onto an empty list needs to wake the loop. uv_async_send()
+  // coalesces calls, so a spurious wake-up is harmless either way.
+  if (head == nullptr) {
+    uv_async_send(async_);
+  }
+  num_pushing_.fetch_sub(1, std::memory_order_release);
+}
+
+void NapiRefReleaseQueue::Drain() {
+  // The consumer takes the whole list at once, so there is no ABA hazard.
+  Entry* entry = head_.exchange(nullptr, std::memory_order_acquire);
+  while (entry != nullptr) {
+    Entry* next = entry->next;
+    if (entry->auto_ref.Cleanup() != napi_ok) {
+#if DEBUG
+      fprintf(stderr, "Exception cleaning up napi_ref instance\n");
+#endif
+    }
+    delete entry;
+    num_released_++;
+    entry = next;
+  }
+}
+
+void NapiRefReleaseQueue::OnAsync(uv_async_t* handle) {
+  NapiRefReleaseQueue* queue = static_cast<NapiRefReleaseQueue*>(handle->data);
+  if (queue != nullptr) {
+    queue->Drain();
+  }
+}
+
+void NapiRefReleaseQueue::OnClose(uv_handle_t* handle) {
+  delete reinterpret_cast<uv_async_t*>(handle);
+}
+
+}  // namespace tfnodejs
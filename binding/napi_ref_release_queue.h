@@ -0,0 +1,85 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_NAPI_REF_RELEASE_QUEUE_H_
+#define TF_NODEJS_NAPI_REF_RELEASE_QUEUE_H_
+
+#include <node_api.h>
+#include <uv.h>
+#include <atomic>
+#include <cstdint>
+#include "napi_auto_ref.h"
+
+namespace tfnodejs {
+
+// Releases napi_ref instances on the main loop on behalf of other threads.
+//
+// TensorFlow calls tensor deallocators from whichever thread drops the last
+// reference to a buffer, but N-API calls are only allowed on the main thread.
+// Deallocators push their reference onto a lock-free list (any number of
+// producers, a single consumer) and wake the main loop through a uv_async_t,
+// which then deletes every queued reference in one pass.
+class NapiRefReleaseQueue {
+ public:
+  // A reference queued for release. Entries are linked intrusively so that
+  // pushing never allocates.
+  struct Entry {
+    Entry(NapiRefReleaseQueue* queue) : queue(queue), next(nullptr) {}
+
+    NapiAutoRef auto_ref;
+    NapiRefReleaseQueue* queue;
+    Entry* next;
+  };
+
+  NapiRefReleaseQueue();
+  ~NapiRefReleaseQueue();
+
+  // Attaches the queue to the event loop of `env`. Must be called on the main
+  // thread before any entry is pushed.
+  napi_status Init(napi_env env);
+
+  // Queues `entry` for release. Safe to call from any thread.
+  void Push(Entry* entry);
+
+  // Releases every queued entry. Must be called on the main thread.
+  void Drain();
+
+  // Releases every queued entry and detaches the queue from the event loop.
+  // Waits for pushes in progress on other threads first. Entries pushed
+  // afterwards are deleted without touching their reference, since the env
+  // that owns it is going away. Must be called on the main thread.
+  void Shutdown();
+
+  // Returns the number of references released so far.
+  uint64_t num_released() const { return num_released_; }
+
+ private:
+  static void OnAsync(uv_async_t* handle);
+  static void OnClose(uv_handle_t* handle);
+
+  std::atomic<Entry*> head_;
+  std::atomic<bool> shut_down_;
+  // Number of Push() calls that passed the shutdown check and may still
+  // link their entry or wake the loop.
+  std::atomic<int> num_pushing_;
+  uv_async_t* async_;
+  uint64_t num_released_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_NAPI_REF_RELEASE_QUEUE_H_
@@ -0,0 +1,98 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_PROTO_UTILS_H_
+#define TF_NODEJS_PROTO_UTILS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tfnodejs {
+
+// Reads a base-128 varint from a serialized protocol buffer.
+inline bool ReadProtoVarint(const uint8_t** data, const uint8_t* end,
+                            uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; *data < end && shift < 64; shift += 7) {
+    uint8_t byte = *(*data)++;
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Invokes `fn(field_number, data, length)` for every length-delimited field and
+// `varint_fn(field_number, value)` for every varint field of a serialized
+// protocol buffer, and skips all other fields. Returns false if the buffer is
+// malformed.
+template <typename Fn, typename VarintFn>
+inline bool ForEachProtoField(const uint8_t* data, size_t length, Fn fn,
+                              VarintFn varint_fn) {
+  const uint8_t* end = data + length;
+  while (data < end) {
+    uint64_t key;
+    uint64_t value;
+    if (!ReadProtoVarint(&data, end, &key)) {
+      return false;
+    }
+    switch (key & 7) {
+      case 0:  // Varint.
+        if (!ReadProtoVarint(&data, end, &value)) {
+          return false;
+        }
+        varint_fn(static_cast<uint32_t>(key >> 3), value);
+        break;
+      case 1:  // 64-bit.
+        if (end - data < 8) {
+          return false;
+        }
+        data += 8;
+        break;
+      case 2:  // Length-delimited.
+        if (!ReadProtoVarint(&data, end, &value) ||
+            value > static_cast<uint64_t>(end - data)) {
+          return false;
+        }
+        fn(static_cast<uint32_t>(key >> 3), data, static_cast<size_t>(value));
+        data += value;
+        break;
+      case 5:  // 32-bit.
+        if (end - data < 4) {
+          return false;
+        }
+        data += 4;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Invokes `fn(field_number, data, length)` for every length-delimited field of
+// a serialized protocol buffer and skips all other fields. Returns false if
+// the buffer is malformed.
+template <typename Fn>
+inline bool ForEachProtoField(const uint8_t* data, size_t length, Fn fn) {
+  return ForEachProtoField(data, length, fn, [](uint32_t, uint64_t) {});
+}
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_PROTO_UTILS_H_
@@ -0,0 +1,180 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#include "tensor_arena.h"
+
+namespace tfnodejs {
+
+// Default caps: enough for the inputs of a handful of fixed-shape models.
+static const size_t kDefaultMaxCachedBytes = 64 * 1024 * 1024;
+static const size_t kDefaultMaxBuffersPerKey = 8;
+
+TensorArena::TensorArena(AlignedBufferPool* buffer_pool)
+    : buffer_pool_(buffer_pool),
+      max_cached_bytes_(kDefaultMaxCachedBytes),
+      max_buffers_per_key_(kDefaultMaxBuffersPerKey),
+      use_count_(0),
+      cached_bytes_(0),
+      num_hits_(0),
+      num_misses_(0) {}
+
+TensorArena::~TensorArena() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& kv : buckets_) {
+    ReleaseBuffers(&kv.second);
+  }
+}
+
+void TensorArena::Configure(size_t max_cached_bytes,
+                            size_t max_buffers_per_key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_cached_bytes_ = max_cached_bytes;
+  max_buffers_per_key_ = max_buffers_per_key;
+
+  // Trim buckets down to the new caps.
+  for (auto it = buckets_.begin(); it != buckets_.end();) {
+    Bucket& bucket = it->second;
+    while (!bucket.buffers.empty() &&
+           (bucket.buffers.size() > max_buffers_per_key_ ||
+            cached_bytes_ > max_cached_bytes_)) {
+      buffer_pool_->Release(bucket.buffers.back());
+      bucket.buffers.pop_back();
+      cached_bytes_ -= bucket.byte_length;
+    }
+    if (bucket.buffers.empty() && bucket.num_live == 0) {
+      it = buckets_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+TF_Tensor* TensorArena::NewTensor(TF_DataType dtype, const int64_t* dims,
+                                  int num_dims, size_t byte_length) {
+  if (byte_length == 0) {
+    return nullptr;
+  }
+
+  Bucket* bucket;
+  void* data = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (max_cached_bytes_ == 0) {
+      return nullptr;
+    }
+
+    const Key key(dtype, byte_length);
+    bucket = &buckets_[key];
+    bucket->arena = this;
+    bucket->key = key;
+    bucket->byte_length = byte_length;
+    bucket->num_live++;
+    bucket->last_use = ++use_count_;
+    if (!bucket->buffers.empty()) {
+      data = bucket->buffers.back();
+      bucket->buffers.pop_back();
+      cached_bytes_ -= byte_length;
+      num_hits_++;
+    } else {
+      num_misses_++;
+    }
+  }
+
+  if (data == nullptr) {
+    data = buffer_pool_->Allocate(byte_length);
+    if (data == nullptr) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      bucket->num_live--;
+      EraseIfUnused(bucket);
+      return nullptr;
+    }
+  }
+  return TF_NewTensor(dtype, dims, num_dims, data, byte_length, Deallocate,
+                      bucket);
+}
+
+void TensorArena::Deallocate(void* data, size_t byte_length, void* arg) {
+  Bucket* bucket = static_cast<Bucket*>(arg);
+  TensorArena* arena = bucket->arena;
+  {
+    std::lock_guard<std::mutex> lock(arena->mutex_);
+    bucket->num_live--;
+    if (bucket->buffers.size() < arena->max_buffers_per_key_ &&
+        arena->MakeRoom(bucket->byte_length, bucket)) {
+      bucket->buffers.push_back(data);
+      arena->cached_bytes_ += bucket->byte_length;
+      return;
+    }
+    arena->EraseIfUnused(bucket);
+  }
+  arena->buffer_pool_->Release(data);
+}
+
+bool TensorArena::MakeRoom(size_t byte_length, const Bucket* keep) {
+  if (byte_length > max_cached_bytes_) {
+    return false;
+  }
+  while (cached_bytes_ + byte_length > max_cached_bytes_) {
+    Bucket* lru = nullptr;
+    for (auto& kv : buckets_) {
+      Bucket& bucket = kv.second;
+      if (&bucket != keep && !bucket.buffers.empty() &&
+          (lru == nullptr || bucket.last_use < lru->last_use)) {
+        lru = &bucket;
+      }
+    }
+    if (lru == nullptr) {
+      return false;
+    }
+    buffer_pool_->Release(lru->buffers.back());
+    lru->buffers.pop_back();
+    cached_bytes_ -= lru->byte_length;
+    EraseIfUnused(lru);
+  }
+  return true;
+}
+
+void TensorArena::EraseIfUnused(const Bucket* bucket) {
+  if (bucket->buffers.empty() && bucket->num_live == 0) {
+    buckets_.erase(bucket->key);
+  }
+}
+
+void TensorArena::ReleaseBuffers(Bucket* bucket) {
+  for (size_t i = 0; i < bucket->buffers.size(); i++) {
+    buffer_pool_->Release(bucket->buffers[i]);
+  }
+  cached_bytes_ -= bucket->buffers.size() * bucket->byte_length;
+  bucket->buffers.clear();
+}
+
+uint64_t TensorArena::num_hits() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_hits_;
+}
+
+uint64_t TensorArena::num_misses() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return num_misses_;
+}
+
+size_t TensorArena::cached_bytes() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cached_bytes_;
+}
+
+}  // namespace tfnodejs
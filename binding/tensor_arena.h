@@ -0,0 +1,107 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_TENSOR_ARENA_H_
+#define TF_NODEJS_TENSOR_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "aligned_buffer_pool.h"
+#include "tensorflow/c/c_api.h"
+
+namespace tfnodejs {
+
+// Recycles TF_Tensor buffers by (dtype, byte length).
+//
+// Serving a fixed-shape model creates tensors of the same dtype and size over
+// and over. Tensors created through NewTensor() own a buffer that goes back
+// to the arena when TensorFlow deletes the tensor, so that the next tensor
+// with the same key reuses it. Buffers come from an AlignedBufferPool and go
+// back to it when a cap is exceeded. When the byte cap is reached, buffers of
+// the least recently used keys make room, and keys without cached or live
+// buffers are dropped, so varying shapes do not grow the arena. All methods
+// are thread-safe, since TensorFlow may delete tensors from its own threads.
+class TensorArena {
+ public:
+  explicit TensorArena(AlignedBufferPool* buffer_pool);
+  ~TensorArena();
+
+  // Sets the caps on the total bytes cached by the arena and on the number of
+  // buffers cached per key. A zero `max_cached_bytes` disables the arena and
+  // releases every cached buffer.
+  void Configure(size_t max_cached_bytes, size_t max_buffers_per_key);
+
+  // Returns a tensor with an uninitialized buffer from the arena, or nullptr
+  // if the arena is disabled or `byte_length` is zero.
+  TF_Tensor* NewTensor(TF_DataType dtype, const int64_t* dims, int num_dims,
+                       size_t byte_length);
+
+  uint64_t num_hits();
+  uint64_t num_misses();
+  size_t cached_bytes();
+
+ private:
+  typedef std::pair<TF_DataType, size_t> Key;
+
+  // Buffers cached for one key. Buckets live in a std::map, so their address
+  // is stable and can be handed to TF_NewTensor() as deallocator argument. A
+  // bucket stays in the map while tensors of its key are alive.
+  struct Bucket {
+    Bucket() : arena(nullptr), byte_length(0), num_live(0), last_use(0) {}
+
+    TensorArena* arena;
+    Key key;
+    size_t byte_length;
+    std::vector<void*> buffers;
+    // Tensors created from the bucket that TensorFlow has not deleted yet.
+    size_t num_live;
+    // Value of `use_count_` when the key was last requested.
+    uint64_t last_use;
+  };
+
+  static void Deallocate(void* data, size_t byte_length, void* arg);
+
+  // Returns every buffer in `bucket` to the buffer pool. Requires `mutex_`.
+  void ReleaseBuffers(Bucket* bucket);
+
+  // Releases buffers of the least recently used buckets other than `keep`
+  // until `byte_length` more bytes fit under the byte cap. Returns false if
+  // they cannot. Requires `mutex_`.
+  bool MakeRoom(size_t byte_length, const Bucket* keep);
+
+  // Drops a bucket without cached buffers or live tensors. Requires
+  // `mutex_`.
+  void EraseIfUnused(const Bucket* bucket);
+
+  AlignedBufferPool* buffer_pool_;
+  std::mutex mutex_;
+  std::map<Key, Bucket> buckets_;
+  size_t max_cached_bytes_;
+  size_t max_buffers_per_key_;
+  uint64_t use_count_;
+  size_t cached_bytes_;
+  uint64_t num_hits_;
+  uint64_t num_misses_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_TENSOR_ARENA_H_
@@ -0,0 +1,182 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+#ifndef TF_NODEJS_TFE_HANDLE_TABLE_H_
+#define TF_NODEJS_TFE_HANDLE_TABLE_H_
+
+#include "tensorflow/c/eager/c_api.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tfnodejs {
+
+// Dense table of TFE_TensorHandle pointers addressed by int32 IDs.
+//
+// An ID packs a slot index in the low `kIndexBits` bits and the generation of
+// that slot in the next `kGenerationBits` bits, so IDs are always
+// non-negative. Removing a handle bumps the slot generation,
+// which makes any previously issued ID for that slot stale. Freed slots are
+// reused in FIFO order so that a slot (and therefore a generation) is recycled
+// as late as possible. Generations wrap, so a stale ID only resolves again
+// once its slot was reused 2^kGenerationBits times, which FIFO reuse spreads
+// over every free slot.
+class TFEHandleTable {
+ public:
+  static const int kIndexBits = 22;
+  static const int kGenerationBits = 9;
+  static const uint32_t kMaxSlots = 1u << kIndexBits;
+
+  // Data stored for a live handle.
+  struct Entry {
+    Entry()
+        : handle(nullptr), context_id(0), num_bytes(0), releaser(nullptr) {}
+
+    TFE_TensorHandle* handle;
+    // Owner-defined ID of the context the handle belongs to.
+    uint32_t context_id;
+    // Number of bytes accounted for the handle.
+    size_t num_bytes;
+    // Owner-defined object tied to the handle's lifetime, if any.
+    void* releaser;
+  };
+
+  TFEHandleTable() : free_head_(kNoSlot), free_tail_(kNoSlot), size_(0) {}
+
+  // Stores `handle` and returns its ID, or -1 when all slots are in use.
+  int32_t Insert(TFE_TensorHandle* handle, uint32_t context_id,
+                 size_t num_bytes) {
+    uint32_t index;
+    if (free_head_ != kNoSlot) {
+      index = free_head_;
+      free_head_ = slots_[index].next_free;
+      if (free_head_ == kNoSlot) {
+        free_tail_ = kNoSlot;
+      }
+    } else if (slots_.size() < kMaxSlots) {
+      index = static_cast<uint32_t>(slots_.size());
+      slots_.push_back(Slot());
+    } else {
+      return -1;
+    }
+
+    Slot& slot = slots_[index];
+    slot.entry.handle = handle;
+    slot.entry.context_id = context_id;
+    slot.entry.num_bytes = num_bytes;
+    slot.next_free = kNoSlot;
+    size_++;
+    return static_cast<int32_t>((slot.generation << kIndexBits) | index);
+  }
+
+  // Returns the handle for `id`, or nullptr if the ID is unknown or stale.
+  TFE_TensorHandle* Get(int32_t id) const {
+    const Slot* slot = Find(id);
+    return slot == nullptr ? nullptr : slot->entry.handle;
+  }
+
+  // Returns the entry for `id`, or nullptr if the ID is unknown or stale.
+  Entry* GetEntry(int32_t id) {
+    Slot* slot = const_cast<Slot*>(Find(id));
+    return slot == nullptr ? nullptr : &slot->entry;
+  }
+
+  // Removes the entry for `id` and copies it to `removed`. Returns false if
+  // the ID is unknown or stale. The caller owns the removed handle.
+  bool Remove(int32_t id, Entry* removed) {
+    Slot* slot = const_cast<Slot*>(Find(id));
+    if (slot == nullptr) {
+      return false;
+    }
+
+    *removed = slot->entry;
+    slot->entry = Entry();
+    size_--;
+    slot->generation = (slot->generation + 1) & kGenerationMask;
+
+    uint32_t index = static_cast<uint32_t>(id) & kIndexMask;
+    if (free_tail_ == kNoSlot) {
+      free_head_ = index;
+    } else {
+      slots_[free_tail_].next_free = index;
+    }
+    free_tail_ = index;
+    return true;
+  }
+
+  // Returns the number of live handles.
+  size_t size() const { return size_; }
+
+  // Invokes `fn` with the entry of every live handle.
+  template <typename Fn>
+  void ForEachEntry(Fn fn) const {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      if (slots_[i].entry.handle != nullptr) {
+        fn(slots_[i].entry);
+      }
+    }
+  }
+
+  // Invokes `fn` with every live handle.
+  template <typename Fn>
+  void ForEach(Fn fn) const {
+    for (size_t i = 0; i < slots_.size(); i++) {
+      if (slots_[i].entry.handle != nullptr) {
+        fn(slots_[i].entry.handle);
+      }
+    }
+  }
+
+ private:
+  static const uint32_t kIndexMask = kMaxSlots - 1;
+  static const uint32_t kGenerationMask = (1u << kGenerationBits) - 1;
+  static const uint32_t kNoSlot = 0xFFFFFFFF;
+
+  struct Slot {
+    Slot() : generation(0), next_free(kNoSlot) {}
+
+    Entry entry;
+    uint32_t generation;
+    uint32_t next_free;
+  };
+
+  const Slot* Find(int32_t id) const {
+    if (id < 0) {
+      return nullptr;
+    }
+    uint32_t index = static_cast<uint32_t>(id) & kIndexMask;
+    uint32_t generation = static_cast<uint32_t>(id) >> kIndexBits;
+    if (index >= slots_.size()) {
+      return nullptr;
+    }
+    const Slot& slot = slots_[index];
+    if (slot.entry.handle == nullptr || slot.generation != generation) {
+      return nullptr;
+    }
+    return &slot;
+  }
+
+  std::vector<Slot> slots_;
+  uint32_t free_head_;
+  uint32_t free_tail_;
+  size_t size_;
+};
+
+}  // namespace tfnodejs
+
+#endif  // TF_NODEJS_TFE_HANDLE_TABLE_H_
@@ -17,52 +17,169 @@
 
 #include "tfjs_backend.h"
 
+#include "aligned_buffer_pool.h"
 #include "napi_auto_ref.h"
+#include "napi_ref_release_queue.h"
+#include "tensor_arena.h"
 #include "tf_auto_tensor.h"
 #include "tfe_auto_op.h"
 #include "utils.h"
 
 #include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 
 namespace tfnodejs {
 
-// Used to hold strings beyond the lifetime of a JS call.
+// Used to hold strings beyond the lifetime of a JS call. Shared by the
+// backends of all envs, so access is guarded by ATTR_NAME_SET_MUTEX.
 static std::set<std::string> ATTR_NAME_SET;
+static std::mutex ATTR_NAME_SET_MUTEX;
 
-// Callback to cleanup extra reference count for shared V8/TF tensor memory:
+// Returns a copy of `name` that lives as long as the process.
+static const char *InternAttrName(const std::string &name) {
+  std::lock_guard<std::mutex> lock(ATTR_NAME_SET_MUTEX);
+  return ATTR_NAME_SET.insert(name).first->c_str();
+}
+
+// Upper bound on the bytes kept on the free lists of the aligned buffer pool.
+static const size_t kMaxAlignedPoolCachedBytes = 256 * 1024 * 1024;
+
+// Ties the lifetime of a tensor to a JS external value. When the value is
+// garbage collected before the tensor is deleted, the tensor is queued for
+// release.
+struct TensorReleaser {
+  TFJSBackend *backend;
+  // Set to -1 once the tensor is deleted explicitly.
+  int32_t tensor_id;
+};
+
+// A JS ArrayBuffer whose memory backs TF_Tensors, with the number of those
+// tensors.
+struct JSBackedBuffer {
+  size_t byte_length;
+  size_t num_tensors;
+};
+
+// ArrayBuffers shared with TF_Tensors, keyed by start address. Ops may forward
+// a shared buffer, or part of it, to their outputs (e.g. Reshape, Slice), so a
+// tensor whose data lies inside one of these ranges is JS memory as well.
+// Distinct ArrayBuffers never overlap, so the range containing an address is
+// the one starting right before it. Shared by the backends of all envs and
+// updated from TensorFlow threads, so access is guarded by
+// gJSBackedBuffersMutex.
+static std::mutex gJSBackedBuffersMutex;
+static std::map<uintptr_t, JSBackedBuffer> gJSBackedBuffers;
+
+// Returns the range containing `start`, or end(). Requires
+// gJSBackedBuffersMutex.
+static std::map<uintptr_t, JSBackedBuffer>::iterator FindJSBackedBuffer(
+    uintptr_t start) {
+  auto it = gJSBackedBuffers.upper_bound(start);
+  if (it == gJSBackedBuffers.begin()) {
+    return gJSBackedBuffers.end();
+  }
+  --it;
+  // Empty views may sit at the very end of their ArrayBuffer.
+  return start <= it->first + it->second.byte_length ? it
+                                                      : gJSBackedBuffers.end();
+}
+
+static void AddJSBackedBuffer(const void *buffer_data, size_t byte_length) {
+  std::lock_guard<std::mutex> lock(gJSBackedBuffersMutex);
+  JSBackedBuffer &buffer =
+      gJSBackedBuffers[reinterpret_cast<uintptr_t>(buffer_data)];
+  buffer.byte_length = std::max(buffer.byte_length, byte_length);
+  buffer.num_tensors++;
+}
+
+// Releases the range of the ArrayBuffer that contains `data`.
+static void RemoveJSBackedBuffer(const void *data) {
+  std::lock_guard<std::mutex> lock(gJSBackedBuffersMutex);
+  auto it = FindJSBackedBuffer(reinterpret_cast<uintptr_t>(data));
+  if (it != gJSBackedBuffers.end() && --it->second.num_tensors == 0) {
+    gJSBackedBuffers.erase(it);
+  }
+}
+
+// Returns whether `len` bytes at `data` are memory of a JS typed array, which
+// must not be handed to V8 again or outlive the env that owns it.
+static bool IsJSBackedBuffer(const void *data, size_t len) {
+  const uintptr_t start = reinterpret_cast<uintptr_t>(data);
+  std::lock_guard<std::mutex> lock(gJSBackedBuffersMutex);
+  auto it = FindJSBackedBuffer(start);
+  return it != gJSBackedBuffers.end() &&
+         start + len <= it->first + it->second.byte_length;
+}
+
+// Callback to cleanup extra reference count for shared V8/TF tensor memory.
+// TensorFlow may invoke this from any thread, so the reference is handed to
+// the release queue instead of being deleted here.
 static void DeallocTensor(void *data, size_t len, void *arg) {
-  NapiAutoRef *auto_ref = static_cast<NapiAutoRef *>(arg);
-  if (!auto_ref) {
+  RemoveJSBackedBuffer(data);
+  NapiRefReleaseQueue::Entry *entry =
+      static_cast<NapiRefReleaseQueue::Entry *>(arg);
+  if (!entry) {
 #if DEBUG
     fprintf(stderr, "Invalid NapiAutoRef reference passed to V8 cleanup\n");
 #endif
     return;
   }
-  if (auto_ref->Cleanup() != napi_ok) {
-#if DEBUG
-    fprintf(stderr, "Exception cleaning up napi_ref instance\n");
-#endif
-  }
-  delete auto_ref;
+  entry->queue->Push(entry);
+}
+
+static void NoopDeallocator(void *data, size_t len, void *arg) {}
+
+// Returns the alignment TF_NewTensor() needs to adopt a buffer instead of
+// copying it, which is EIGEN_MAX_ALIGN_BYTES of the TensorFlow build. The C
+// API does not expose it, so it is probed once at growing offsets into an
+// over-aligned buffer.
+static uintptr_t GetTFTensorAlignment() {
+  static const uintptr_t alignment = [] {
+    alignas(128) static char probe[256];
+    uintptr_t offset = 1;
+    for (; offset < 128; offset *= 2) {
+      const int64_t dims[] = {1};
+      TF_Tensor *tensor = TF_NewTensor(TF_UINT8, dims, 1, probe + offset, 1,
+                                       NoopDeallocator, nullptr);
+      const bool is_adopted = TF_TensorData(tensor) == probe + offset;
+      TF_DeleteTensor(tensor);
+      if (is_adopted) {
+        break;
+      }
+    }
+    return offset;
+  }();
+  return alignment;
 }
 
+// Backend state used when creating tensors that share JS typed array memory.
+struct TypedArrayTensorContext {
+  NapiRefReleaseQueue *ref_release_queue;
+  // Incremented when a misaligned buffer has to be copied.
+  uint64_t *num_misaligned_copies;
+  // Provides recycled buffers for those copies.
+  TensorArena *tensor_arena;
+};
+
 // Creates a TFE_TensorHandle from a JS typed array.
-TFE_TensorHandle *CreateTFE_TensorHandleFromTypedArray(napi_env env,
-                                                       int64_t *shape,
-                                                       uint32_t shape_length,
-                                                       TF_DataType dtype,
-                                                       napi_value array_value) {
+TFE_TensorHandle *CreateTFE_TensorHandleFromTypedArray(
+    napi_env env, int64_t *shape, uint32_t shape_length, TF_DataType dtype,
+    napi_value array_value, const TypedArrayTensorContext &context) {
   napi_status nstatus;
   napi_typedarray_type array_type;
   size_t array_length;
   void *array_data;
+  napi_value array_buffer;
   nstatus =
       napi_get_typedarray_info(env, array_value, &array_type, &array_length,
-                               &array_data, nullptr, nullptr);
+                               &array_data, &array_buffer, nullptr);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
   // Double check the underlying TF_Tensor type matches the supplied
@@ -151,32 +268,62 @@ TFE_TensorHandle *CreateTFE_TensorHandleFromTypedArray(napi_env env,
     }
   }
 
+  // Currently, int64-type Tensors are represented as Int32Arrays.
+  // So the logic for comparing the byte size of the typed-array representation
+  // and the byte size of the tensor dtype needs to be special-cased for int64.
+  const size_t byte_size =
+      dtype == TF_INT64 ? num_elements * width * 2 : num_elements * width;
+
+  TF_AutoStatus tf_status;
+
+  // TF_NewTensor() copies buffers that are not aligned for Eigen into a fresh
+  // allocation instead of sharing them. Buffers from binding.allocAligned()
+  // never take this path. Copy into a recycled arena buffer instead.
+  if (reinterpret_cast<uintptr_t>(array_data) % GetTFTensorAlignment() != 0) {
+    TF_AutoTensor arena_tensor(context.tensor_arena->NewTensor(
+        dtype, shape, shape_length, byte_size));
+    if (arena_tensor.tensor != nullptr) {
+      (*context.num_misaligned_copies)++;
+      memcpy(TF_TensorData(arena_tensor.tensor), array_data, byte_size);
+      TFE_TensorHandle *tfe_tensor_handle =
+          TFE_NewTensorHandle(arena_tensor.tensor, tf_status.status);
+      ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+      return tfe_tensor_handle;
+    }
+  }
+
+  // The whole ArrayBuffer is registered as JS memory, so that views of it
+  // never overlap other registered ranges.
+  void *buffer_data;
+  size_t buffer_length;
+  nstatus = napi_get_arraybuffer_info(env, array_buffer, &buffer_data,
+                                      &buffer_length);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
   // Sharing V8 memory with the underlying TensorFlow tensor requires adding an
   // additional refcount. When the Tensor is deleted, the refcount will be
   // reduced in the callback helper.
-  NapiAutoRef *auto_ref = new NapiAutoRef();
-  nstatus = auto_ref->Init(env, array_value);
+  NapiRefReleaseQueue::Entry *ref_entry =
+      new NapiRefReleaseQueue::Entry(context.ref_release_queue);
+  nstatus = ref_entry->auto_ref.Init(env, array_value);
   if (nstatus != napi_ok) {
-    delete auto_ref;
+    delete ref_entry;
   }
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-  // Currently, int64-type Tensors are represented as Int32Arrays.
-  // So the logic for comparing the byte size of the typed-array representation
-  // and the byte size of the tensor dtype needs to be special-cased for int64.
-  const size_t byte_size =
-      dtype == TF_INT64 ? num_elements * width * 2 : num_elements * width;
-
+  AddJSBackedBuffer(buffer_data, buffer_length);
   TF_AutoTensor tensor(TF_NewTensor(dtype, shape, shape_length, array_data,
-                                    byte_size, DeallocTensor, auto_ref));
+                                    byte_size, DeallocTensor, ref_entry));
+  // TensorFlow copied the buffer, e.g. with the arena disabled, and already
+  // released the reference.
+  if (byte_size > 0 && TF_TensorData(tensor.tensor) != array_data) {
+    (*context.num_misaligned_copies)++;
+  }
 
-  TF_AutoStatus tf_status;
+  // On failure the reference is released through DeallocTensor() once the
+  // TF_Tensor is deleted.
   TFE_TensorHandle *tfe_tensor_handle =
       TFE_NewTensorHandle(tensor.tensor, tf_status.status);
-  if (TF_GetCode(tf_status.status) != TF_OK) {
-    delete auto_ref;
-    TFE_DeleteTensorHandle(tfe_tensor_handle);
-  }
   ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
 
   return tfe_tensor_handle;
@@ -253,17 +400,15 @@ TFE_TensorHandle *CreateTFE_TensorHandleFromStringArray(
   return tfe_tensor_handle;
 }
 
-TFE_TensorHandle *CreateTFE_TensorHandleFromJSValues(napi_env env,
-                                                     int64_t *shape,
-                                                     uint32_t shape_length,
-                                                     TF_DataType dtype,
-                                                     napi_value array_value) {
+TFE_TensorHandle *CreateTFE_TensorHandleFromJSValues(
+    napi_env env, int64_t *shape, uint32_t shape_length, TF_DataType dtype,
+    napi_value array_value, const TypedArrayTensorContext &context) {
   bool is_typed_array;
   napi_status nstatus = napi_is_typedarray(env, array_value, &is_typed_array);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
   if (is_typed_array) {
     return CreateTFE_TensorHandleFromTypedArray(env, shape, shape_length, dtype,
-                                                array_value);
+                                                array_value, context);
   } else {
     return CreateTFE_TensorHandleFromStringArray(env, shape, shape_length,
                                                  dtype, array_value);
@@ -283,11 +428,17 @@ TFE_TensorHandle *CopyTFE_TensorHandleToDevice(napi_env env,
   return new_handle;
 }
 
+// Finalizer for external ArrayBuffers that view the data of a TF_Tensor.
+static void DeleteSharedTensor(napi_env env, void *data, void *hint) {
+  TF_DeleteTensor(static_cast<TF_Tensor *>(hint));
+}
+
 void CopyTFE_TensorHandleDataToTypedArray(napi_env env,
                                           TFE_Context *tfe_context,
                                           TFE_TensorHandle *tfe_tensor_handle,
                                           TF_DataType tensor_data_type,
                                           napi_typedarray_type array_type,
+                                          bool share_buffer,
                                           napi_value *result) {
   TF_AutoStatus tf_status;
 
@@ -306,15 +457,31 @@ void CopyTFE_TensorHandleDataToTypedArray(napi_env env,
   size_t byte_length = TF_TensorByteSize(tensor.tensor);
 
   napi_value array_buffer_value;
-  void *array_buffer_data;
   napi_status nstatus;
-  nstatus = napi_create_arraybuffer(env, byte_length, &array_buffer_data,
-                                    &array_buffer_value);
-  ENSURE_NAPI_OK(env, nstatus);
+  void *tensor_data = TF_TensorData(tensor.tensor);
+  // V8 already owns the memory of tensors uploaded from a typed array, and a
+  // second ArrayBuffer over it would alias the source array, so those are
+  // copied.
+  if (share_buffer && byte_length > 0 && tensor_data != nullptr &&
+      !IsJSBackedBuffer(tensor_data, byte_length)) {
+    // Expose the resolved tensor buffer directly. The TF_Tensor is kept alive
+    // until the ArrayBuffer is garbage collected.
+    nstatus = napi_create_external_arraybuffer(env, tensor_data, byte_length,
+                                               DeleteSharedTensor,
+                                               tensor.tensor,
+                                               &array_buffer_value);
+    ENSURE_NAPI_OK(env, nstatus);
+    tensor.tensor = nullptr;
+  } else {
+    void *array_buffer_data;
+    nstatus = napi_create_arraybuffer(env, byte_length, &array_buffer_data,
+                                      &array_buffer_value);
+    ENSURE_NAPI_OK(env, nstatus);
 
-  // TFE_TensorHandleResolve can use a shared data pointer, memcpy() the
-  // current value to the newly allocated NAPI buffer.
-  memcpy(array_buffer_data, TF_TensorData(tensor.tensor), byte_length);
+    // TFE_TensorHandleResolve can use a shared data pointer, memcpy() the
+    // current value to the newly allocated NAPI buffer.
+    memcpy(array_buffer_data, tensor_data, byte_length);
+  }
 
   nstatus = napi_create_typedarray(env, array_type, num_elements,
                                    array_buffer_value, 0, result);
@@ -447,9 +614,11 @@ void CopyTFE_TensorHandleDataToResourceArray(
 }
 
 // Handles converting the stored TF_Tensor data into the correct JS value.
+// When `share_buffer` is set, numeric tensors are returned as a view over the
+// resolved TF_Tensor buffer instead of a copy.
 void CopyTFE_TensorHandleDataToJSData(napi_env env, TFE_Context *tfe_context,
                                       TFE_TensorHandle *tfe_tensor_handle,
-                                      napi_value *result) {
+                                      bool share_buffer, napi_value *result) {
   if (tfe_context == nullptr) {
     NAPI_THROW_ERROR(env, "Invalid TFE_Context");
     return;
@@ -498,7 +667,7 @@ void CopyTFE_TensorHandleDataToJSData(napi_env env, TFE_Context *tfe_context,
   } else {
     CopyTFE_TensorHandleDataToTypedArray(env, tfe_context, tfe_tensor_handle,
                                          tensor_data_type, typed_array_type,
-                                         result);
+                                         share_buffer, result);
   }
 }
 
@@ -546,7 +715,9 @@ void GetTFE_TensorHandleType(napi_env env, TFE_TensorHandle *handle,
   ENSURE_NAPI_OK(env, nstatus);
 }
 
-void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
+// Converts a JS TFEOpAttr object into a native OpAttr that can be applied to
+// TFE_Op instances without calling back into N-API.
+void ParseOpAttr(napi_env env, napi_value attr_value, OpAttr *attr) {
   napi_status nstatus;
 
   napi_value attr_name_value;
@@ -560,32 +731,27 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
   // OpAttr will be used beyond the scope of this function call. Stash ops in
   // a set for re-use instead of dynamically reallocating strings for
   // operations.
-  const char *attr_name =
-      ATTR_NAME_SET.insert(attr_name_string.c_str()).first->c_str();
+  attr->name = InternAttrName(attr_name_string);
 
   napi_value attr_type_value;
   nstatus = napi_get_named_property(env, attr_value, "type", &attr_type_value);
   ENSURE_NAPI_OK(env, nstatus);
 
-  TF_AttrType tf_attr_type;
   nstatus = napi_get_value_int32(env, attr_type_value,
-                                 reinterpret_cast<int32_t *>(&tf_attr_type));
+                                 reinterpret_cast<int32_t *>(&attr->type));
   ENSURE_NAPI_OK(env, nstatus);
 
   napi_value js_value;
   nstatus = napi_get_named_property(env, attr_value, "value", &js_value);
   ENSURE_NAPI_OK(env, nstatus);
 
-  switch (tf_attr_type) {
+  attr->is_list = false;
+  switch (attr->type) {
     case TF_ATTR_STRING: {
       // NOTE: String attribute values do not have to be utf8 encoded strings
       // (could be arbitrary byte sequences).
-      std::string str_value;
-      nstatus = GetStringParam(env, js_value, str_value);
+      nstatus = GetStringParam(env, js_value, attr->string_value);
       ENSURE_NAPI_OK(env, nstatus);
-
-      TFE_OpSetAttrString(tfe_op, attr_name, str_value.c_str(),
-                          str_value.size());
       break;
     }
 
@@ -594,7 +760,8 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
         uint32_t length;
         nstatus = napi_get_array_length(env, js_value, &length);
         ENSURE_NAPI_OK(env, nstatus);
-        std::unique_ptr<int64_t[]> data(new int64_t[length]);
+        attr->is_list = true;
+        attr->int_values.resize(length);
         for (uint32_t i = 0; i < length; ++i) {
           napi_value element;
           nstatus = napi_get_element(env, js_value, i, &element);
@@ -602,16 +769,13 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
           int32_t value;
           nstatus = napi_get_value_int32(env, element, &value);
           ENSURE_NAPI_OK(env, nstatus);
-          data[i] = value;
+          attr->int_values[i] = value;
         }
-        TFE_OpSetAttrIntList(tfe_op, attr_name, data.get(),
-                             static_cast<int>(length));
       } else {
         int64_t value;
         nstatus = napi_get_value_int64(env, js_value, &value);
         ENSURE_NAPI_OK(env, nstatus);
-
-        TFE_OpSetAttrInt(tfe_op, attr_name, value);
+        attr->int_values.assign(1, value);
       }
       break;
     }
@@ -621,7 +785,8 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
         uint32_t length;
         nstatus = napi_get_array_length(env, js_value, &length);
         ENSURE_NAPI_OK(env, nstatus);
-        std::unique_ptr<float[]> data(new float[length]);
+        attr->is_list = true;
+        attr->float_values.resize(length);
         for (uint32_t i = 0; i < length; ++i) {
           napi_value element;
           nstatus = napi_get_element(env, js_value, i, &element);
@@ -629,15 +794,13 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
           double value;
           nstatus = napi_get_value_double(env, element, &value);
           ENSURE_NAPI_OK(env, nstatus);
-          data[i] = static_cast<float>(value);
+          attr->float_values[i] = static_cast<float>(value);
         }
-        TFE_OpSetAttrFloatList(tfe_op, attr_name, data.get(),
-                               static_cast<int>(length));
       } else {
         double value;
         nstatus = napi_get_value_double(env, js_value, &value);
         ENSURE_NAPI_OK(env, nstatus);
-        TFE_OpSetAttrFloat(tfe_op, attr_name, static_cast<float>(value));
+        attr->float_values.assign(1, static_cast<float>(value));
       }
       break;
     }
@@ -647,7 +810,8 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
         uint32_t length;
         nstatus = napi_get_array_length(env, js_value, &length);
         ENSURE_NAPI_OK(env, nstatus);
-        std::unique_ptr<unsigned char[]> data(new unsigned char[length]);
+        attr->is_list = true;
+        attr->bool_values.resize(length);
         for (uint32_t i = 0; i < length; ++i) {
           napi_value element;
           nstatus = napi_get_element(env, js_value, i, &element);
@@ -655,183 +819,2834 @@ void AssignOpAttr(napi_env env, TFE_Op *tfe_op, napi_value attr_value) {
           bool value;
           nstatus = napi_get_value_bool(env, element, &value);
           ENSURE_NAPI_OK(env, nstatus);
-          data[i] = value ? 1 : 0;
+          attr->bool_values[i] = value ? 1 : 0;
         }
-        TFE_OpSetAttrBoolList(tfe_op, attr_name, data.get(),
-                              static_cast<int>(length));
       } else {
         bool value;
         nstatus = napi_get_value_bool(env, js_value, &value);
         ENSURE_NAPI_OK(env, nstatus);
-        TFE_OpSetAttrBool(tfe_op, attr_name, value ? 1 : 0);
+        attr->bool_values.assign(1, value ? 1 : 0);
       }
       break;
     }
 
     case TF_ATTR_TYPE: {
-      TF_DataType tf_data_type;
-      nstatus = napi_get_value_int32(
-          env, js_value, reinterpret_cast<int32_t *>(&tf_data_type));
+      int32_t tf_data_type;
+      nstatus = napi_get_value_int32(env, js_value, &tf_data_type);
       ENSURE_NAPI_OK(env, nstatus);
-
-      TFE_OpSetAttrType(tfe_op, attr_name, tf_data_type);
+      attr->int_values.assign(1, tf_data_type);
       break;
     }
 
     case TF_ATTR_SHAPE: {
-      std::vector<int64_t> shape_vector;
-      ExtractArrayShape(env, js_value, &shape_vector);
+      attr->int_values.clear();
+      ExtractArrayShape(env, js_value, &attr->int_values);
+      break;
+    }
+
+    default:
+      REPORT_UNKNOWN_TF_ATTR_TYPE(env, attr->type);
+      break;
+  }
+}
+
+// Converts a JS array of TFEOpAttr objects into native OpAttr values.
+void ParseOpAttrs(napi_env env, napi_value op_attr_inputs,
+                  std::vector<OpAttr> *attrs) {
+  napi_status nstatus;
+
+  uint32_t op_attrs_length;
+  nstatus = napi_get_array_length(env, op_attr_inputs, &op_attrs_length);
+  ENSURE_NAPI_OK(env, nstatus);
+
+  attrs->resize(op_attrs_length);
+  for (uint32_t i = 0; i < op_attrs_length; i++) {
+    napi_value cur_op_attr;
+    nstatus = napi_get_element(env, op_attr_inputs, i, &cur_op_attr);
+    ENSURE_NAPI_OK(env, nstatus);
+
+    ParseOpAttr(env, cur_op_attr, &(*attrs)[i]);
+
+    // Check to see if an exception exists, if so return a failure.
+    if (IsExceptionPending(env)) {
+      return;
+    }
+  }
+}
+
+// Returns true if the host stores multi-byte values least significant byte
+// first.
+static bool IsLittleEndianHost() {
+  const uint16_t probe = 1;
+  uint8_t first_byte;
+  memcpy(&first_byte, &probe, 1);
+  return first_byte == 1;
+}
+
+// Reads little-endian values from packed op attribute and program buffers,
+// byte-swapping them on big-endian hosts. See `encodeOpAttrs()` and
+// `encodeProgram()` in src/ops/op_utils.ts for the layouts.
+class PackedBufferReader {
+ public:
+  PackedBufferReader(const uint8_t *data, size_t length)
+      : data_(data), length_(length), offset_(0) {}
+
+  template <typename T>
+  bool Read(T *value) {
+    if (length_ - offset_ < sizeof(T)) {
+      return false;
+    }
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, data_ + offset_, sizeof(T));
+    static const bool kSwapBytes = !IsLittleEndianHost();
+    if (kSwapBytes) {
+      std::reverse(bytes, bytes + sizeof(T));
+    }
+    memcpy(value, bytes, sizeof(T));
+    offset_ += sizeof(T);
+    return true;
+  }
+
+  bool ReadBytes(size_t num_bytes, const char **bytes) {
+    if (length_ - offset_ < num_bytes) {
+      return false;
+    }
+    *bytes = reinterpret_cast<const char *>(data_ + offset_);
+    offset_ += num_bytes;
+    return true;
+  }
+
+ private:
+  const uint8_t *data_;
+  size_t length_;
+  size_t offset_;
+};
+
+// Converts a packed op attribute buffer into native OpAttr values. The buffer
+// starts with an int32 attribute count followed by one record per attribute:
+// int32 type, int32 is_list, int32 name byte length, name bytes, int32 value
+// count and the values. String values are raw bytes, int and shape values are
+// float64, float values are float32, bool values are uint8 and type values are
+// int32.
+void ParseOpAttrsFromBuffer(napi_env env, const uint8_t *data, size_t length,
+                            std::vector<OpAttr> *attrs) {
+  PackedBufferReader reader(data, length);
+
+  int32_t num_attrs;
+  if (!reader.Read(&num_attrs) || num_attrs < 0) {
+    NAPI_THROW_ERROR(env, "Invalid packed op attributes");
+    return;
+  }
+
+  attrs->resize(num_attrs);
+  for (int32_t i = 0; i < num_attrs; i++) {
+    OpAttr &attr = (*attrs)[i];
+
+    int32_t type;
+    int32_t is_list;
+    int32_t name_length;
+    const char *name;
+    int32_t count;
+    if (!reader.Read(&type) || !reader.Read(&is_list) ||
+        !reader.Read(&name_length) || name_length < 0 ||
+        !reader.ReadBytes(name_length, &name) || !reader.Read(&count) ||
+        count < 0) {
+      NAPI_THROW_ERROR(env, "Invalid packed op attribute at index %d", i);
+      return;
+    }
+
+    // OpAttr will be used beyond the scope of this function call. Stash ops in
+    // a set for re-use instead of dynamically reallocating strings for
+    // operations.
+    attr.name = InternAttrName(std::string(name, name_length));
+    attr.type = static_cast<TF_AttrType>(type);
+    attr.is_list = is_list != 0;
+
+    bool ok = true;
+    switch (attr.type) {
+      case TF_ATTR_STRING: {
+        const char *bytes;
+        ok = reader.ReadBytes(count, &bytes);
+        if (ok) {
+          attr.string_value.assign(bytes, count);
+        }
+        break;
+      }
+
+      case TF_ATTR_INT:
+      case TF_ATTR_SHAPE:
+        attr.int_values.resize(count);
+        for (int32_t j = 0; ok && j < count; j++) {
+          double value;
+          ok = reader.Read(&value);
+          attr.int_values[j] = static_cast<int64_t>(value);
+        }
+        break;
+
+      case TF_ATTR_FLOAT:
+        attr.float_values.resize(count);
+        for (int32_t j = 0; ok && j < count; j++) {
+          ok = reader.Read(&attr.float_values[j]);
+        }
+        break;
+
+      case TF_ATTR_BOOL:
+        attr.bool_values.resize(count);
+        for (int32_t j = 0; ok && j < count; j++) {
+          ok = reader.Read(&attr.bool_values[j]);
+        }
+        break;
+
+      case TF_ATTR_TYPE:
+        attr.int_values.resize(count);
+        for (int32_t j = 0; ok && j < count; j++) {
+          int32_t value;
+          ok = reader.Read(&value);
+          attr.int_values[j] = value;
+        }
+        break;
+
+      default:
+        REPORT_UNKNOWN_TF_ATTR_TYPE(env, attr.type);
+        return;
+    }
+
+    // Scalar attributes always carry exactly one value.
+    if (!ok || (!attr.is_list && attr.type != TF_ATTR_STRING &&
+                attr.type != TF_ATTR_SHAPE && count != 1)) {
+      NAPI_THROW_ERROR(env, "Invalid packed op attribute value for '%s'",
+                       attr.name);
+      return;
+    }
+  }
+}
+
+// Throws if a scalar attribute carries no value to apply.
+static bool EnsureScalarAttrValue(napi_env env, const OpAttr &attr,
+                                  size_t num_values) {
+  if (num_values == 0) {
+    NAPI_THROW_ERROR(env, "Missing value for op attribute '%s'", attr.name);
+    return false;
+  }
+  return true;
+}
 
+void ApplyOpAttr(napi_env env, TFE_Op *tfe_op, const OpAttr &attr) {
+  switch (attr.type) {
+    case TF_ATTR_STRING:
+      if (attr.is_list) {
+        NAPI_THROW_ERROR(env, "String list op attributes are not supported: %s",
+                         attr.name);
+        return;
+      }
+      TFE_OpSetAttrString(tfe_op, attr.name, attr.string_value.c_str(),
+                          attr.string_value.size());
+      break;
+
+    case TF_ATTR_INT:
+      if (attr.is_list) {
+        TFE_OpSetAttrIntList(tfe_op, attr.name, attr.int_values.data(),
+                             static_cast<int>(attr.int_values.size()));
+      } else if (EnsureScalarAttrValue(env, attr, attr.int_values.size())) {
+        TFE_OpSetAttrInt(tfe_op, attr.name, attr.int_values[0]);
+      }
+      break;
+
+    case TF_ATTR_FLOAT:
+      if (attr.is_list) {
+        TFE_OpSetAttrFloatList(tfe_op, attr.name, attr.float_values.data(),
+                               static_cast<int>(attr.float_values.size()));
+      } else if (EnsureScalarAttrValue(env, attr, attr.float_values.size())) {
+        TFE_OpSetAttrFloat(tfe_op, attr.name, attr.float_values[0]);
+      }
+      break;
+
+    case TF_ATTR_BOOL:
+      if (attr.is_list) {
+        TFE_OpSetAttrBoolList(tfe_op, attr.name, attr.bool_values.data(),
+                              static_cast<int>(attr.bool_values.size()));
+      } else if (EnsureScalarAttrValue(env, attr, attr.bool_values.size())) {
+        TFE_OpSetAttrBool(tfe_op, attr.name, attr.bool_values[0]);
+      }
+      break;
+
+    case TF_ATTR_TYPE:
+      if (attr.is_list) {
+        std::vector<TF_DataType> types;
+        types.reserve(attr.int_values.size());
+        for (size_t i = 0; i < attr.int_values.size(); i++) {
+          types.push_back(static_cast<TF_DataType>(attr.int_values[i]));
+        }
+        TFE_OpSetAttrTypeList(tfe_op, attr.name, types.data(),
+                              static_cast<int>(types.size()));
+      } else if (EnsureScalarAttrValue(env, attr, attr.int_values.size())) {
+        TFE_OpSetAttrType(tfe_op, attr.name,
+                          static_cast<TF_DataType>(attr.int_values[0]));
+      }
+      break;
+
+    case TF_ATTR_SHAPE: {
       TF_AutoStatus tf_status;
-      TFE_OpSetAttrShape(tfe_op, attr_name, shape_vector.data(),
-                         shape_vector.size(), tf_status.status);
+      TFE_OpSetAttrShape(tfe_op, attr.name, attr.int_values.data(),
+                         attr.int_values.size(), tf_status.status);
       ENSURE_TF_OK(env, tf_status);
       break;
     }
 
     default:
-      REPORT_UNKNOWN_TF_ATTR_TYPE(env, tf_attr_type);
+      REPORT_UNKNOWN_TF_ATTR_TYPE(env, attr.type);
       break;
   }
 }
 
-TFJSBackend::TFJSBackend(napi_env env) : next_tensor_id_(0) {
+void ApplyOpAttrs(napi_env env, TFE_Op *tfe_op,
+                  const std::vector<OpAttr> &attrs) {
+  for (size_t i = 0; i < attrs.size(); i++) {
+    ApplyOpAttr(env, tfe_op, attrs[i]);
+
+    // Check to see if an exception exists, if so return a failure.
+    if (IsExceptionPending(env)) {
+      return;
+    }
+  }
+}
+
+ExecutionContext::ExecutionContext(uint32_t id)
+    : id(id),
+      tfe_context(nullptr),
+      is_shared(false),
+      is_async(false) {
+  config.intra_op_parallelism_threads = -1;
+  config.inter_op_parallelism_threads = -1;
+  config.allow_soft_placement = -1;
+  config.share_context = -1;
+  config.async_execution = -1;
+}
+
+TFJSBackend::TFJSBackend(napi_env env)
+    : num_tensor_bytes_(0),
+      peak_tensor_bytes_(0),
+      num_disposed_tensors_(0),
+      num_reclaimed_tensors_(0),
+      ref_release_queue_(new NapiRefReleaseQueue()),
+      aligned_buffer_pool_(new AlignedBufferPool(kMaxAlignedPoolCachedBytes)),
+      num_misaligned_copies_(0),
+      num_skipped_device_copies_(0),
+      tensor_arena_(new TensorArena(aligned_buffer_pool_)),
+      next_prepared_op_id_(0),
+      capture_context_(nullptr),
+      next_graph_session_id_(0) {
+  contexts_.emplace_back(new ExecutionContext(0));
+  contexts_[0]->name = "default";
+  context_ = contexts_[0].get();
+
+  if (ref_release_queue_->Init(env) != napi_ok) {
+    NAPI_THROW_ERROR(env, "Exception creating the napi_ref release queue");
+    return;
+  }
+}
+
+// Returns the value of an integer environment variable, or `default_value` if
+// the variable is unset or not a non-negative integer.
+static int32_t GetEnvInt32(const char *name, int32_t default_value) {
+  const char *env_value = std::getenv(name);
+  if (env_value == nullptr || *env_value == '\0') {
+    return default_value;
+  }
+  char *end;
+  long value = std::strtol(env_value, &end, 10);
+  if (*end != '\0' || value < 0 || value > INT32_MAX) {
+    return default_value;
+  }
+  return static_cast<int32_t>(value);
+}
+
+// Appends a base-128 varint to a serialized protocol buffer.
+static void AppendProtoVarint(std::string *proto, uint64_t value) {
+  while (value >= 0x80) {
+    proto->push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  proto->push_back(static_cast<char>(value));
+}
+
+// Appends a varint-typed field to a serialized protocol buffer.
+static void AppendProtoVarintField(std::string *proto, uint32_t field_number,
+                                   uint64_t value) {
+  AppendProtoVarint(proto, field_number << 3);  // Wire type 0 (varint).
+  AppendProtoVarint(proto, value);
+}
+
+// ConfigProto field numbers from tensorflow/core/protobuf/config.proto.
+static const uint32_t kConfigProtoIntraOpParallelismThreads = 2;
+static const uint32_t kConfigProtoInterOpParallelismThreads = 5;
+static const uint32_t kConfigProtoAllowSoftPlacement = 7;
+
+// Returns the serialized ConfigProto of a context config, with the options
+// that are unset in the config read from environment variables.
+static std::string BuildConfigProto(const ContextConfig &context_config) {
+  const int32_t intra_op_threads =
+      context_config.intra_op_parallelism_threads >= 0
+          ? context_config.intra_op_parallelism_threads
+          : GetEnvInt32("TFJS_INTRA_OP_PARALLELISM_THREADS", -1);
+  const int32_t inter_op_threads =
+      context_config.inter_op_parallelism_threads >= 0
+          ? context_config.inter_op_parallelism_threads
+          : GetEnvInt32("TFJS_INTER_OP_PARALLELISM_THREADS", -1);
+  const int32_t allow_soft_placement =
+      context_config.allow_soft_placement >= 0
+          ? context_config.allow_soft_placement
+          : GetEnvInt32("TFJS_ALLOW_SOFT_PLACEMENT", -1);
+
+  // Protobuf parsing keeps the last value of a repeated scalar field, so the
+  // explicit options override the same fields in the user supplied proto.
+  std::string config_proto = context_config.config_proto;
+  if (intra_op_threads >= 0) {
+    AppendProtoVarintField(&config_proto,
+                           kConfigProtoIntraOpParallelismThreads,
+                           intra_op_threads);
+  }
+  if (inter_op_threads >= 0) {
+    AppendProtoVarintField(&config_proto,
+                           kConfigProtoInterOpParallelismThreads,
+                           inter_op_threads);
+  }
+  if (allow_soft_placement >= 0) {
+    AppendProtoVarintField(&config_proto, kConfigProtoAllowSoftPlacement,
+                           allow_soft_placement != 0);
+  }
+  return config_proto;
+}
+
+// Returns whether a context config asks for asynchronous execution.
+static bool IsAsyncExecution(const ContextConfig &context_config) {
+  const int32_t async_execution =
+      context_config.async_execution >= 0
+          ? context_config.async_execution
+          : GetEnvInt32("TFJS_ASYNC_EXECUTION", 0);
+  return async_execution != 0;
+}
+
+// Creates a TFE_Context from a context config and returns the name of its
+// default device and whether it executes Ops asynchronously. Throws and
+// returns false on failure.
+static bool NewTFEContext(napi_env env, const ContextConfig &context_config,
+                          TFE_Context **tfe_context_out,
+                          std::string *device_name, bool *is_async) {
+  const bool async_execution = IsAsyncExecution(context_config);
+  const std::string config_proto = BuildConfigProto(context_config);
+
   TF_AutoStatus tf_status;
   TFE_ContextOptions *tfe_options = TFE_NewContextOptions();
-  tfe_context_ = TFE_NewContext(tfe_options, tf_status.status);
-  if (TF_GetCode(tf_status.status) != TF_OK) {
-    NAPI_THROW_ERROR(env, "Exception creating TFE_Context");
+  if (!config_proto.empty()) {
+    TFE_ContextOptionsSetConfig(tfe_options, config_proto.data(),
+                                config_proto.size(), tf_status.status);
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      TFE_DeleteContextOptions(tfe_options);
+      NAPI_THROW_ERROR(env, "Invalid TFE_Context config: %s",
+                       TF_Message(tf_status.status));
+      return false;
+    }
   }
-
+  TFE_ContextOptionsSetAsync(tfe_options, async_execution);
+  TFE_Context *tfe_context = TFE_NewContext(tfe_options, tf_status.status);
   TFE_DeleteContextOptions(tfe_options);
+  ENSURE_TF_OK_RETVAL(env, tf_status, false);
 
   TF_DeviceList *device_list =
-      TFE_ContextListDevices(tfe_context_, tf_status.status);
+      TFE_ContextListDevices(tfe_context, tf_status.status);
   if (TF_GetCode(tf_status.status) != TF_OK) {
+    TFE_DeleteContext(tfe_context);
     NAPI_THROW_ERROR(env, "Exception creating TFE_Context");
+    return false;
   }
 
   // TODO(kreeger): Add better support for this in the future through the JS
   // API. https://github.com/tensorflow/tfjs/issues/320
   std::string cpu_device_name;
+  std::string gpu_device_name;
   const int num_devices = TF_DeviceListCount(device_list);
   for (int i = 0; i < num_devices; i++) {
     const char *device_type =
         TF_DeviceListType(device_list, i, tf_status.status);
-    ENSURE_TF_OK(env, tf_status);
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      break;
+    }
 
     // Keep a reference to the host CPU device:
     if (strcmp(device_type, "CPU") == 0) {
-      cpu_device_name =
-          std::string(TF_DeviceListName(device_list, i, tf_status.status));
-      ENSURE_TF_OK(env, tf_status);
+      cpu_device_name = TF_DeviceListName(device_list, i, tf_status.status);
     } else if (strcmp(device_type, "GPU") == 0) {
-      device_name =
-          std::string(TF_DeviceListName(device_list, i, tf_status.status));
-      ENSURE_TF_OK(env, tf_status);
+      gpu_device_name = TF_DeviceListName(device_list, i, tf_status.status);
+    }
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      break;
     }
   }
+  TF_DeleteDeviceList(device_list);
+  if (TF_GetCode(tf_status.status) != TF_OK) {
+    TFE_DeleteContext(tfe_context);
+    ENSURE_TF_OK_RETVAL(env, tf_status, false);
+  }
 
   // If no GPU devices found, fallback to host CPU:
-  if (device_name.empty()) {
-    device_name = cpu_device_name;
-  }
-  TF_DeleteDeviceList(device_list);
+  *device_name = gpu_device_name.empty() ? cpu_device_name : gpu_device_name;
+  *tfe_context_out = tfe_context;
+  *is_async = async_execution;
+  return true;
 }
 
-TFJSBackend::~TFJSBackend() {
-  for (auto &kv : tfe_handle_map_) {
-    TFE_DeleteTensorHandle(kv.second);
+// TFE_Context shared by the contexts of every env (e.g. worker threads) that
+// opt in with `shareContext`. It is created from the config of the first
+// such context and deleted with the last one. Later contexts must ask for the
+// same config.
+static std::mutex gSharedContextMutex;
+static TFE_Context *gSharedTFEContext = nullptr;
+static std::string gSharedDeviceName;
+static std::string gSharedConfigProto;
+static bool gSharedIsAsync = false;
+static int gSharedContextRefCount = 0;
+
+bool TFJSBackend::EnsureContext(napi_env env) {
+  if (context_->tfe_context != nullptr) {
+    return true;
   }
-  if (tfe_context_ != nullptr) {
-    TFE_DeleteContext(tfe_context_);
+
+  const ContextConfig &config = context_->config;
+  const int32_t share_context = config.share_context >= 0
+                                    ? config.share_context
+                                    : GetEnvInt32("TFJS_SHARE_CONTEXT", 0);
+  if (share_context == 0) {
+    return NewTFEContext(env, config, &context_->tfe_context,
+                         &context_->device_name, &context_->is_async);
   }
-}
 
-TFJSBackend *TFJSBackend::Create(napi_env env) { return new TFJSBackend(env); }
+  std::lock_guard<std::mutex> lock(gSharedContextMutex);
+  const std::string config_proto = BuildConfigProto(config);
+  if (gSharedTFEContext == nullptr) {
+    if (!NewTFEContext(env, config, &gSharedTFEContext, &gSharedDeviceName,
+                       &gSharedIsAsync)) {
+      return false;
+    }
+    gSharedConfigProto = config_proto;
+  } else if (config_proto != gSharedConfigProto ||
+             IsAsyncExecution(config) != gSharedIsAsync) {
+    NAPI_THROW_ERROR(env,
+                     "The shared TFE_Context was created with a different "
+                     "config than context '%s' asks for",
+                     context_->name.c_str());
+    return false;
+  }
+  gSharedContextRefCount++;
+  context_->tfe_context = gSharedTFEContext;
+  context_->device_name = gSharedDeviceName;
+  context_->is_async = gSharedIsAsync;
+  context_->is_shared = true;
+  return true;
+}
 
-int32_t TFJSBackend::InsertHandle(TFE_TensorHandle *tfe_handle) {
-  return tfe_handle_map_.insert(std::make_pair(next_tensor_id_++, tfe_handle))
-      .first->first;
+ExecutionContext::~ExecutionContext() {
+  if (tfe_context == nullptr) {
+    return;
+  }
+  if (!is_shared) {
+    TFE_DeleteContext(tfe_context);
+    return;
+  }
+  std::lock_guard<std::mutex> lock(gSharedContextMutex);
+  if (--gSharedContextRefCount == 0) {
+    TFE_DeleteContext(gSharedTFEContext);
+    gSharedTFEContext = nullptr;
+  }
 }
 
-napi_value TFJSBackend::CreateTensor(napi_env env, napi_value shape_value,
-                                     napi_value dtype_value,
-                                     napi_value array_value) {
+bool TFJSBackend::ParseContextConfig(napi_env env, napi_value config_value,
+                                     ContextConfig *config) {
   napi_status nstatus;
-
-  std::vector<int64_t> shape_vector;
-  ExtractArrayShape(env, shape_value, &shape_vector);
-  // Check to see if an exception exists, if so return a failure.
-  if (IsExceptionPending(env)) {
-    return nullptr;
+  struct {
+    const char *name;
+    int32_t *value;
+  } int_options[] = {
+      {"intraOpParallelismThreads", &config->intra_op_parallelism_threads},
+      {"interOpParallelismThreads", &config->inter_op_parallelism_threads}};
+  for (size_t i = 0; i < ARRAY_SIZE(int_options); i++) {
+    napi_value js_value;
+    nstatus =
+        napi_get_named_property(env, config_value, int_options[i].name,
+                                &js_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+
+    napi_valuetype type;
+    nstatus = napi_typeof(env, js_value, &type);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+    if (type == napi_undefined) {
+      continue;
+    }
+    ENSURE_VALUE_IS_NUMBER_RETVAL(env, js_value, false);
+
+    int32_t value;
+    nstatus = napi_get_value_int32(env, js_value, &value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+    if (value < 0) {
+      NAPI_THROW_ERROR(env, "%s must be non-negative (got: %d)",
+                       int_options[i].name, value);
+      return false;
+    }
+    *int_options[i].value = value;
   }
 
-  int32_t dtype_int32;
-  nstatus = napi_get_value_int32(env, dtype_value, &dtype_int32);
-  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
-
-  TFE_TensorHandle *tfe_handle = CreateTFE_TensorHandleFromJSValues(
-      env, shape_vector.data(), shape_vector.size(),
-      static_cast<TF_DataType>(dtype_int32), array_value);
+  struct {
+    const char *name;
+    int32_t *value;
+  } bool_options[] = {{"allowSoftPlacement", &config->allow_soft_placement},
+                      {"shareContext", &config->share_context},
+                      {"asyncExecution", &config->async_execution}};
+  for (size_t i = 0; i < ARRAY_SIZE(bool_options); i++) {
+    napi_value js_value;
+    nstatus = napi_get_named_property(env, config_value, bool_options[i].name,
+                                      &js_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+
+    napi_valuetype type;
+    nstatus = napi_typeof(env, js_value, &type);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+    if (type == napi_undefined) {
+      continue;
+    }
 
-  // Check to see if an exception exists, if so return a failure.
-  if (IsExceptionPending(env)) {
-    return nullptr;
+    bool value;
+    nstatus = napi_get_value_bool(env, js_value, &value);
+    if (nstatus != napi_ok) {
+      NAPI_THROW_ERROR(env, "%s must be a boolean", bool_options[i].name);
+      return false;
+    }
+    *bool_options[i].value = value ? 1 : 0;
   }
 
-  // Copy non-int32 and non-string tensors to a device. Most GPU kernels expect
-  // to have int32 tensors in host memory.
-  if (dtype_int32 != TF_INT32 && dtype_int32 != TF_STRING) {
-    // Note that this is a shallow copy and will share the underlying buffer
-    // if copying to the same device.
-    TFE_TensorHandle *new_handle = CopyTFE_TensorHandleToDevice(
-        env, device_name.c_str(), tfe_handle, tfe_context_);
-
-    TFE_DeleteTensorHandle(tfe_handle);
-    tfe_handle = new_handle;
+  napi_value config_proto_value;
+  nstatus = napi_get_named_property(env, config_value, "configProto",
+                                    &config_proto_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+  napi_valuetype type;
+  nstatus = napi_typeof(env, config_proto_value, &type);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+  if (type != napi_undefined) {
+    void *data;
+    size_t length;
+    if (!GetTypedArrayData(env, config_proto_value, napi_uint8_array, &data,
+                           &length)) {
+      return false;
+    }
+    config->config_proto.assign(static_cast<const char *>(data), length);
   }
 
-  napi_value output_tensor_id;
-  nstatus = napi_create_int32(env, InsertHandle(tfe_handle), &output_tensor_id);
-  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
-  return output_tensor_id;
+  return true;
 }
 
-void TFJSBackend::DeleteTensor(napi_env env, napi_value tensor_id_value) {
-  int32_t tensor_id;
-  ENSURE_NAPI_OK(env, napi_get_value_int32(env, tensor_id_value, &tensor_id));
-
-  auto tensor_entry = tfe_handle_map_.find(tensor_id);
-  if (tensor_entry == tfe_handle_map_.end()) {
+void TFJSBackend::ConfigureContext(napi_env env, napi_value config_value) {
+  ExecutionContext *context = contexts_[0].get();
+  if (context->tfe_context != nullptr) {
     NAPI_THROW_ERROR(env,
-                     "Delete called on a Tensor not referenced (tensor_id: %d)",
-                     tensor_id);
+                     "The TFE_Context is already created, configure it before "
+                     "creating tensors or executing Ops");
     return;
   }
 
-  TFE_DeleteTensorHandle(tensor_entry->second);
-  tfe_handle_map_.erase(tensor_entry);
+  ContextConfig config = context->config;
+  if (ParseContextConfig(env, config_value, &config)) {
+    context->config = config;
+  }
 }
 
-napi_value TFJSBackend::GetTensorData(napi_env env,
-                                      napi_value tensor_id_value) {
-  int32_t tensor_id;
-  ENSURE_NAPI_OK_RETVAL(
-      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+napi_value TFJSBackend::CreateContext(napi_env env, napi_value name_value,
+                                      napi_value config_value) {
+  napi_status nstatus;
 
-  auto tensor_entry = tfe_handle_map_.find(tensor_id);
-  if (tensor_entry == tfe_handle_map_.end()) {
-    NAPI_THROW_ERROR(
-        env, "Get data called on a Tensor not referenced (tensor_id: %d)",
-        tensor_id);
-    return nullptr;
-  }
+  std::string name;
+  nstatus = GetStringParam(env, name_value, name);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  for (size_t i = 0; i < contexts_.size(); i++) {
+    if (contexts_[i]->name == name) {
+      NAPI_THROW_ERROR(env, "Context '%s' already exists", name.c_str());
+      return nullptr;
+    }
+  }
+  uint32_t context_id = static_cast<uint32_t>(contexts_.size());
+  std::unique_ptr<ExecutionContext> context(new ExecutionContext(context_id));
+  context->name = name;
+  if (!ParseContextConfig(env, config_value, &context->config)) {
+    return nullptr;
+  }
+  contexts_.push_back(std::move(context));
+
+  napi_value context_id_value;
+  nstatus = napi_create_uint32(env, context_id, &context_id_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return context_id_value;
+}
+
+void TFJSBackend::SetContext(napi_env env, napi_value context_id_value) {
+  uint32_t context_id;
+  ENSURE_NAPI_OK(env,
+                 napi_get_value_uint32(env, context_id_value, &context_id));
+  if (context_id >= contexts_.size()) {
+    NAPI_THROW_ERROR(env, "Context ID not referenced (context_id: %u)",
+                     context_id);
+    return;
+  }
+  context_ = contexts_[context_id].get();
+}
+
+// Lists the names and types of the devices of a context. Throws and returns
+// false on failure.
+static bool ListTFEDevices(
+    napi_env env, TFE_Context *tfe_context,
+    std::vector<std::pair<std::string, std::string>> *devices) {
+  TF_AutoStatus tf_status;
+  TF_DeviceList *device_list =
+      TFE_ContextListDevices(tfe_context, tf_status.status);
+  ENSURE_TF_OK_RETVAL(env, tf_status, false);
+
+  const int num_devices = TF_DeviceListCount(device_list);
+  for (int i = 0; i < num_devices; i++) {
+    const char *name = TF_DeviceListName(device_list, i, tf_status.status);
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      break;
+    }
+    const char *type = TF_DeviceListType(device_list, i, tf_status.status);
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      break;
+    }
+    devices->emplace_back(name, type);
+  }
+  TF_DeleteDeviceList(device_list);
+  ENSURE_TF_OK_RETVAL(env, tf_status, false);
+  return true;
+}
+
+napi_value TFJSBackend::ListDevices(napi_env env) {
+  napi_status nstatus;
+
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
+  std::vector<std::pair<std::string, std::string>> devices;
+  if (!ListTFEDevices(env, context_->tfe_context, &devices)) {
+    return nullptr;
+  }
+
+  napi_value devices_value;
+  nstatus = napi_create_array_with_length(env, devices.size(), &devices_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  for (size_t i = 0; i < devices.size(); i++) {
+    napi_value device_value;
+    nstatus = napi_create_object(env, &device_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    napi_value name_value;
+    nstatus = napi_create_string_utf8(env, devices[i].first.c_str(),
+                                      devices[i].first.size(), &name_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_named_property(env, device_value, "name", name_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    napi_value type_value;
+    nstatus = napi_create_string_utf8(env, devices[i].second.c_str(),
+                                      devices[i].second.size(), &type_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_named_property(env, device_value, "type", type_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    nstatus = napi_set_element(env, devices_value, i, device_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+  return devices_value;
+}
+
+void TFJSBackend::SetDevice(napi_env env, napi_value device_name_value) {
+  if (!EnsureContext(env)) {
+    return;
+  }
+
+  std::string device_name;
+  ENSURE_NAPI_OK(env, GetStringParam(env, device_name_value, device_name));
+  if (device_name.empty()) {
+    context_->op_device_name.clear();
+    return;
+  }
+
+  std::vector<std::pair<std::string, std::string>> devices;
+  if (!ListTFEDevices(env, context_->tfe_context, &devices)) {
+    return;
+  }
+
+  // Match full names like "/job:localhost/replica:0/task:0/device:CPU:1" or
+  // their "CPU:1" suffix.
+  const std::string suffix = "/device:" + device_name;
+  for (size_t i = 0; i < devices.size(); i++) {
+    const std::string &name = devices[i].first;
+    if (name == device_name ||
+        (name.size() > suffix.size() &&
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix) ==
+             0)) {
+      context_->op_device_name = name;
+      return;
+    }
+  }
+  NAPI_THROW_ERROR(env, "Unknown device: %s (context: %s)",
+                   device_name.c_str(), context_->name.c_str());
+}
+
+napi_value TFJSBackend::GetTensorDevice(napi_env env,
+                                        napi_value tensor_id_value) {
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  TFE_TensorHandle *tfe_handle = GetHandle(tensor_id);
+  if (tfe_handle == nullptr) {
+    NAPI_THROW_ERROR(env, "Tensor ID not referenced (tensor_id: %d)",
+                     tensor_id);
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  const char *device_name =
+      TFE_TensorHandleDeviceName(tfe_handle, tf_status.status);
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  napi_value device_name_value;
+  ENSURE_NAPI_OK_RETVAL(env,
+                        napi_create_string_utf8(env, device_name,
+                                                NAPI_AUTO_LENGTH,
+                                                &device_name_value),
+                        nullptr);
+  return device_name_value;
+}
+
+void TFJSBackend::Sync(napi_env env) {
+  if (!EnsureContext(env)) {
+    return;
+  }
+
+  TF_AutoStatus tf_status;
+  TFE_ContextAsyncWait(context_->tfe_context, tf_status.status);
+  if (TF_GetCode(tf_status.status) != TF_OK) {
+    // Report the error once, later Ops may run again.
+    TFE_ContextAsyncClearError(context_->tfe_context);
+  }
+  ENSURE_TF_OK(env, tf_status);
+
+  AccountUnsizedTensors(env, context_);
+}
+
+napi_value TFJSBackend::GetTensorShape(napi_env env,
+                                       napi_value tensor_id_value) {
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  TFE_TensorHandle *tfe_handle = handle_table_.Get(tensor_id);
+  if (tfe_handle == nullptr) {
+    NAPI_THROW_ERROR(env, "Tensor ID not referenced (tensor_id: %d)",
+                     tensor_id);
+    return nullptr;
+  }
+
+  napi_value shape_value;
+  GetTFE_TensorHandleShape(env, tfe_handle, &shape_value);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  // The Op has completed, so its size is known now.
+  AccountTensorBytes(env, tensor_id);
+  return shape_value;
+}
+
+napi_value TFJSBackend::GetLazyTensorShape(napi_env env,
+                                           napi_callback_info info) {
+  napi_value js_this;
+  void *data;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_cb_info(env, info, nullptr, nullptr, &js_this, &data),
+      nullptr);
+
+  napi_value tensor_id_value;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_named_property(env, js_this, "id", &tensor_id_value),
+      nullptr);
+  return static_cast<TFJSBackend *>(data)->GetTensorShape(env,
+                                                          tensor_id_value);
+}
+
+TFE_Op *TFJSBackend::NewOp(const char *op_name,
+                           const std::string &device_name,
+                           TF_Status *status) {
+  TFE_Op *tfe_op = TFE_NewOp(context_->tfe_context, op_name, status);
+  if (TF_GetCode(status) != TF_OK || device_name.empty()) {
+    return tfe_op;
+  }
+  TFE_OpSetDevice(tfe_op, device_name.c_str(), status);
+  if (TF_GetCode(status) != TF_OK) {
+    TFE_DeleteOp(tfe_op);
+    return nullptr;
+  }
+  return tfe_op;
+}
+
+ExecutionContext *TFJSBackend::GetTensorContext(int32_t tensor_id) {
+  const TFEHandleTable::Entry *entry = handle_table_.GetEntry(tensor_id);
+  return entry == nullptr ? nullptr : contexts_[entry->context_id].get();
+}
+
+TFE_TensorHandle *TFJSBackend::GetHandle(int32_t tensor_id) {
+  return handle_table_.Get(tensor_id);
+}
+
+TFE_TensorHandle *TFJSBackend::GetInputHandle(napi_env env,
+                                              int32_t tensor_id) {
+  const TFEHandleTable::Entry *entry = handle_table_.GetEntry(tensor_id);
+  if (entry != nullptr && entry->context_id == context_->id) {
+    return entry->handle;
+  }
+  if (entry != nullptr) {
+    NAPI_THROW_ERROR(env,
+                     "Input Tensor belongs to another context (tensor_id: %d, "
+                     "context: %s)",
+                     tensor_id, context_->name.c_str());
+  } else {
+    NAPI_THROW_ERROR(env, "Input Tensor ID not referenced (tensor_id: %d)",
+                     tensor_id);
+  }
+  return nullptr;
+}
+
+TFJSBackend::~TFJSBackend() {
+  // Releasers finalized during env teardown must not reach this backend.
+  handle_table_.ForEachEntry([](const TFEHandleTable::Entry &entry) {
+    if (entry.releaser != nullptr) {
+      static_cast<TensorReleaser *>(entry.releaser)->tensor_id = -1;
+    }
+  });
+
+  // Tensors still referenced by an ID go before the contexts that run them.
+  // Their buffers return to the arena and the queue, so those go last.
+  handle_table_.ForEach(TFE_DeleteTensorHandle);
+  contexts_.clear();
+
+  // Tensors and ArrayBuffers held by JS values that are finalized during env
+  // teardown may still return buffers and references afterwards. The queue,
+  // the arena and the pool release everything they cache, but the objects
+  // themselves are intentionally leaked so that those late returns stay safe.
+  ref_release_queue_->Shutdown();
+  tensor_arena_->Configure(0, 0);
+  aligned_buffer_pool_->SetMaxCachedBytes(0);
+}
+
+TFJSBackend *TFJSBackend::Create(napi_env env) { return new TFJSBackend(env); }
+
+void TFJSBackend::Destroy(void *backend) {
+  delete static_cast<TFJSBackend *>(backend);
+}
+
+// Number of unsized tensors an async context keeps before sizing them.
+static const size_t kMaxUnsizedTensors = 4096;
+
+// Returns the number of bytes held by the tensor behind a handle. Variable
+// length dtypes (e.g. TF_STRING) are not accounted for.
+static size_t GetTFE_TensorHandleByteSize(TFE_TensorHandle *tfe_handle) {
+  TF_AutoStatus tf_status;
+  int64_t num_elements =
+      TFE_TensorHandleNumElements(tfe_handle, tf_status.status);
+  if (TF_GetCode(tf_status.status) != TF_OK || num_elements < 0) {
+    return 0;
+  }
+  return static_cast<size_t>(num_elements) *
+         TF_DataTypeSize(TFE_TensorHandleDataType(tfe_handle));
+}
+
+int32_t TFJSBackend::InsertHandle(napi_env env, ExecutionContext *context,
+                                  TFE_TensorHandle *tfe_handle) {
+  // New tensors are the point where memory grows, release tensors collected
+  // by GC first.
+  ReleaseGCTensors(env);
+
+  // The size of an async Op output is only known once the Op completes.
+  size_t num_bytes =
+      context->is_async ? 0 : GetTFE_TensorHandleByteSize(tfe_handle);
+  int32_t tensor_id = handle_table_.Insert(tfe_handle, context->id, num_bytes);
+  if (tensor_id < 0) {
+    DeleteHandle(tfe_handle);
+    NAPI_THROW_ERROR(env, "Too many live tensors (max: %u)",
+                     TFEHandleTable::kMaxSlots);
+    return tensor_id;
+  }
+  if (context->is_async) {
+    // Bound the backlog, at the cost of an occasional wait.
+    if (context->unsized_tensor_ids.size() >= kMaxUnsizedTensors) {
+      AccountUnsizedTensors(env, context);
+    }
+    context->unsized_tensor_ids.push_back(tensor_id);
+    return tensor_id;
+  }
+  AdjustTensorBytes(env, static_cast<int64_t>(num_bytes));
+  return tensor_id;
+}
+
+void TFJSBackend::AccountTensorBytes(napi_env env, int32_t tensor_id) {
+  // Tensors sized already, or deleted since, have nothing left to account.
+  // A zero-byte tensor is sized again, which is harmless.
+  TFEHandleTable::Entry *entry = handle_table_.GetEntry(tensor_id);
+  if (entry == nullptr || entry->num_bytes != 0) {
+    return;
+  }
+  entry->num_bytes = GetTFE_TensorHandleByteSize(entry->handle);
+  AdjustTensorBytes(env, static_cast<int64_t>(entry->num_bytes));
+}
+
+void TFJSBackend::AccountUnsizedTensors(napi_env env,
+                                        ExecutionContext *context) {
+  for (size_t i = 0; i < context->unsized_tensor_ids.size(); i++) {
+    AccountTensorBytes(env, context->unsized_tensor_ids[i]);
+  }
+  context->unsized_tensor_ids.clear();
+}
+
+void TFJSBackend::AdjustTensorBytes(napi_env env, int64_t change_in_bytes) {
+  if (change_in_bytes == 0) {
+    return;
+  }
+  num_tensor_bytes_ += change_in_bytes;
+  if (num_tensor_bytes_ > peak_tensor_bytes_) {
+    peak_tensor_bytes_ = num_tensor_bytes_;
+  }
+
+  // Let V8 know about the native memory held on behalf of JS so that garbage
+  // collection is scheduled with the real heap pressure in mind.
+  int64_t adjusted_value;
+  ENSURE_NAPI_OK(env, napi_adjust_external_memory(env, change_in_bytes,
+                                                  &adjusted_value));
+}
+
+bool TFJSBackend::ReserveHandles(
+    napi_env env, const std::vector<TFE_TensorHandle *> &handles) {
+  if (handle_table_.size() + handles.size() <= TFEHandleTable::kMaxSlots) {
+    return true;
+  }
+  for (size_t i = 0; i < handles.size(); i++) {
+    DeleteHandle(handles[i]);
+  }
+  NAPI_THROW_ERROR(env, "Too many live tensors (max: %u)",
+                   TFEHandleTable::kMaxSlots);
+  return false;
+}
+
+napi_value TFJSBackend::CreateTensor(napi_env env, napi_value shape_value,
+                                     napi_value dtype_value,
+                                     napi_value array_value) {
+  napi_status nstatus;
+
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
+  std::vector<int64_t> shape_vector;
+  ExtractArrayShape(env, shape_value, &shape_vector);
+  // Check to see if an exception exists, if so return a failure.
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  int32_t dtype_int32;
+  nstatus = napi_get_value_int32(env, dtype_value, &dtype_int32);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  TypedArrayTensorContext context = {
+      ref_release_queue_, &num_misaligned_copies_, tensor_arena_};
+  TFE_TensorHandle *tfe_handle = CreateTFE_TensorHandleFromJSValues(
+      env, shape_vector.data(), shape_vector.size(),
+      static_cast<TF_DataType>(dtype_int32), array_value, context);
+
+  // Check to see if an exception exists, if so return a failure.
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  tfe_handle = PlaceTensorHandle(env, tfe_handle);
+  if (tfe_handle == nullptr) {
+    return nullptr;
+  }
+
+  int32_t tensor_id = InsertHandle(env, context_, tfe_handle);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  napi_value output_tensor_id;
+  nstatus = napi_create_int32(env, tensor_id, &output_tensor_id);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return output_tensor_id;
+}
+
+TFE_TensorHandle *TFJSBackend::PlaceTensorHandle(napi_env env,
+                                                 TFE_TensorHandle *tfe_handle) {
+  // Copy non-int32 and non-string tensors to a device. Most GPU kernels expect
+  // to have int32 tensors in host memory.
+  TF_DataType dtype = TFE_TensorHandleDataType(tfe_handle);
+  if (dtype == TF_INT32 || dtype == TF_STRING) {
+    return tfe_handle;
+  }
+
+  // New handles live on the host CPU. A copy to the same device would only
+  // wrap the same buffer in another handle.
+  const std::string &device_name = context_->op_device_name.empty()
+                                        ? context_->device_name
+                                        : context_->op_device_name;
+  TF_AutoStatus tf_status;
+  const char *handle_device_name =
+      TFE_TensorHandleDeviceName(tfe_handle, tf_status.status);
+  if (TF_GetCode(tf_status.status) == TF_OK &&
+      device_name == handle_device_name) {
+    num_skipped_device_copies_++;
+    return tfe_handle;
+  }
+
+  TFE_TensorHandle *new_handle = CopyTFE_TensorHandleToDevice(
+      env, device_name.c_str(), tfe_handle, context_->tfe_context);
+  if (new_handle != nullptr) {
+    DeviceCopyStats &stats = device_copy_stats_[device_name];
+    stats.num_copies++;
+    stats.num_bytes += GetTFE_TensorHandleByteSize(tfe_handle);
+  }
+  TFE_DeleteTensorHandle(tfe_handle);
+  return new_handle;
+}
+
+bool TFJSBackend::RemoveHandle(int32_t tensor_id, size_t *num_bytes) {
+  TFEHandleTable::Entry entry;
+  if (!handle_table_.Remove(tensor_id, &entry)) {
+    return false;
+  }
+  if (entry.releaser != nullptr) {
+    // The releaser outlives the table entry. Disarm it so that its finalizer
+    // does not release the tensor a second time.
+    static_cast<TensorReleaser *>(entry.releaser)->tensor_id = -1;
+  }
+  DeleteHandle(entry.handle);
+  num_disposed_tensors_++;
+  *num_bytes = entry.num_bytes;
+  return true;
+}
+
+void TFJSBackend::FinalizeTensorReleaser(napi_env env, void *data,
+                                         void *hint) {
+  std::unique_ptr<TensorReleaser> releaser(static_cast<TensorReleaser *>(data));
+  if (releaser->tensor_id < 0) {
+    return;
+  }
+
+  // Finalizers can run during garbage collection, where calling into JS is
+  // not allowed. Only queue the tensor here and release it on the next call
+  // into the backend.
+  TFJSBackend *backend = releaser->backend;
+  TFEHandleTable::Entry *entry =
+      backend->handle_table_.GetEntry(releaser->tensor_id);
+  if (entry != nullptr) {
+    entry->releaser = nullptr;
+    backend->gc_released_tensor_ids_.push_back(releaser->tensor_id);
+  }
+}
+
+void TFJSBackend::ReleaseGCTensors(napi_env env) {
+  if (gc_released_tensor_ids_.empty()) {
+    return;
+  }
+
+  std::vector<int32_t> tensor_ids;
+  tensor_ids.swap(gc_released_tensor_ids_);
+
+  int64_t num_released_bytes = 0;
+  for (size_t i = 0; i < tensor_ids.size(); i++) {
+    TFEHandleTable::Entry entry;
+    if (handle_table_.Remove(tensor_ids[i], &entry)) {
+      DeleteHandle(entry.handle);
+      num_released_bytes += entry.num_bytes;
+      num_reclaimed_tensors_++;
+    }
+  }
+  AdjustTensorBytes(env, -num_released_bytes);
+}
+
+napi_value TFJSBackend::TrackTensor(napi_env env, napi_value tensor_id_value) {
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  TFEHandleTable::Entry *entry = handle_table_.GetEntry(tensor_id);
+  if (entry == nullptr) {
+    NAPI_THROW_ERROR(env,
+                     "Track called on a Tensor not referenced (tensor_id: %d)",
+                     tensor_id);
+    return nullptr;
+  }
+  if (entry->releaser != nullptr) {
+    NAPI_THROW_ERROR(env, "Tensor is already tracked (tensor_id: %d)",
+                     tensor_id);
+    return nullptr;
+  }
+
+  TensorReleaser *releaser = new TensorReleaser();
+  releaser->backend = this;
+  releaser->tensor_id = tensor_id;
+
+  napi_value releaser_value;
+  napi_status nstatus = napi_create_external(
+      env, releaser, FinalizeTensorReleaser, nullptr, &releaser_value);
+  if (nstatus != napi_ok) {
+    delete releaser;
+  }
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  entry->releaser = releaser;
+  return releaser_value;
+}
+
+// Tensors exported by ExportTensor() and not yet imported, keyed by token.
+// Shared by the backends of all envs.
+static std::mutex gTensorExportsMutex;
+static std::map<uint32_t, TF_Tensor *> gTensorExports;
+static uint32_t gNextTensorExportToken = 1;
+
+napi_value TFJSBackend::ExportTensor(napi_env env,
+                                     napi_value tensor_id_value) {
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  TFE_TensorHandle *tfe_handle = GetHandle(tensor_id);
+  if (tfe_handle == nullptr) {
+    NAPI_THROW_ERROR(env,
+                     "Export called on a Tensor not referenced (tensor_id: %d)",
+                     tensor_id);
+    return nullptr;
+  }
+  // Resource handles are only meaningful in the context that created them.
+  if (TFE_TensorHandleDataType(tfe_handle) == TF_RESOURCE) {
+    NAPI_THROW_ERROR(env, "Resource tensors cannot be exported");
+    return nullptr;
+  }
+
+  // Resolving a host tensor shares its buffer, so the export holds a
+  // reference to the data instead of a copy.
+  TF_AutoStatus tf_status;
+  TF_Tensor *tensor = TFE_TensorHandleResolve(tfe_handle, tf_status.status);
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  // Memory of a typed array belongs to the heap of this env, which the
+  // importer may outlive, and changes when JS writes to the array. It is
+  // copied into a TensorFlow owned buffer. SharedArrayBuffer memory is copied
+  // as well, since the tensor only holds a reference of this env to it.
+  const size_t byte_length = TF_TensorByteSize(tensor);
+  if (byte_length > 0 &&
+      IsJSBackedBuffer(TF_TensorData(tensor), byte_length)) {
+    std::vector<int64_t> dims(TF_NumDims(tensor));
+    for (size_t i = 0; i < dims.size(); i++) {
+      dims[i] = TF_Dim(tensor, static_cast<int>(i));
+    }
+    const int num_dims = static_cast<int>(dims.size());
+    TF_Tensor *copy = tensor_arena_->NewTensor(
+        TF_TensorType(tensor), dims.data(), num_dims, byte_length);
+    if (copy == nullptr) {
+      copy = TF_AllocateTensor(TF_TensorType(tensor), dims.data(), num_dims,
+                               byte_length);
+    }
+    memcpy(TF_TensorData(copy), TF_TensorData(tensor), byte_length);
+    TF_DeleteTensor(tensor);
+    tensor = copy;
+  }
+
+  uint32_t token;
+  {
+    std::lock_guard<std::mutex> lock(gTensorExportsMutex);
+    do {
+      token = gNextTensorExportToken++;
+    } while (token == 0 || gTensorExports.count(token) != 0);
+    gTensorExports[token] = tensor;
+  }
+
+  napi_value token_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_uint32(env, token, &token_value),
+                        nullptr);
+  return token_value;
+}
+
+// Removes an export from the registry and returns its tensor, or nullptr if
+// the token is not referenced.
+static TF_Tensor *TakeTensorExport(uint32_t token) {
+  std::lock_guard<std::mutex> lock(gTensorExportsMutex);
+  auto export_entry = gTensorExports.find(token);
+  if (export_entry == gTensorExports.end()) {
+    return nullptr;
+  }
+  TF_Tensor *tensor = export_entry->second;
+  gTensorExports.erase(export_entry);
+  return tensor;
+}
+
+napi_value TFJSBackend::ImportTensor(napi_env env, napi_value token_value) {
+  napi_status nstatus;
+
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
+  uint32_t token;
+  nstatus = napi_get_value_uint32(env, token_value, &token);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  TF_AutoTensor tensor(TakeTensorExport(token));
+  if (tensor.tensor == nullptr) {
+    NAPI_THROW_ERROR(env, "Tensor export token not referenced (token: %u)",
+                     token);
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  TFE_TensorHandle *tfe_handle =
+      TFE_NewTensorHandle(tensor.tensor, tf_status.status);
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  tfe_handle = PlaceTensorHandle(env, tfe_handle);
+  if (tfe_handle == nullptr) {
+    return nullptr;
+  }
+
+  std::vector<TFE_TensorHandle *> handles(1, tfe_handle);
+  napi_value tensor_infos = CreateOutputTensorInfos(env, context_, handles);
+  if (tensor_infos == nullptr) {
+    return nullptr;
+  }
+  napi_value tensor_info;
+  nstatus = napi_get_element(env, tensor_infos, 0, &tensor_info);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return tensor_info;
+}
+
+void TFJSBackend::ReleaseTensorExport(napi_env env, napi_value token_value) {
+  uint32_t token;
+  ENSURE_NAPI_OK(env, napi_get_value_uint32(env, token_value, &token));
+
+  TF_Tensor *tensor = TakeTensorExport(token);
+  if (tensor == nullptr) {
+    NAPI_THROW_ERROR(env, "Tensor export token not referenced (token: %u)",
+                     token);
+    return;
+  }
+  TF_DeleteTensor(tensor);
+}
+
+bool TFJSBackend::GetInputHandles(napi_env env, napi_value tensor_ids_value,
+                                  std::vector<TFE_TensorHandle *> *handles) {
+  void *tensor_ids_data;
+  size_t num_tensor_ids;
+  if (!GetTypedArrayData(env, tensor_ids_value, napi_int32_array,
+                         &tensor_ids_data, &num_tensor_ids)) {
+    return false;
+  }
+  const int32_t *tensor_ids = static_cast<int32_t *>(tensor_ids_data);
+  for (size_t i = 0; i < num_tensor_ids; i++) {
+    TFE_TensorHandle *tfe_handle = GetInputHandle(env, tensor_ids[i]);
+    if (tfe_handle == nullptr) {
+      return false;
+    }
+    handles->push_back(tfe_handle);
+  }
+  return true;
+}
+
+void TFJSBackend::BeginCapture(napi_env env, napi_value input_tensor_ids) {
+  if (!EnsureContext(env)) {
+    return;
+  }
+  if (capture_ != nullptr) {
+    NAPI_THROW_ERROR(env, "A capture is already in progress (context: %s)",
+                     capture_context_->name.c_str());
+    return;
+  }
+
+  std::vector<TFE_TensorHandle *> inputs;
+  if (!GetInputHandles(env, input_tensor_ids, &inputs)) {
+    return;
+  }
+
+  capture_.reset(new GraphCapture());
+  capture_context_ = context_;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    capture_->AddInput(inputs[i]);
+  }
+}
+
+napi_value TFJSBackend::EndCapture(napi_env env, napi_value name_value,
+                                   napi_value output_tensor_ids) {
+  if (capture_ == nullptr) {
+    NAPI_THROW_ERROR(env, "No capture is in progress");
+    return nullptr;
+  }
+  // The capture ends here whether or not the function can be built.
+  std::unique_ptr<GraphCapture> capture(std::move(capture_));
+  ExecutionContext *context = capture_context_;
+  capture_context_ = nullptr;
+  if (context != context_) {
+    NAPI_THROW_ERROR(env, "Capture must end in context %s",
+                     context->name.c_str());
+    return nullptr;
+  }
+
+  std::string name;
+  ENSURE_NAPI_OK_RETVAL(env, GetStringParam(env, name_value, name), nullptr);
+
+  std::vector<TFE_TensorHandle *> outputs;
+  if (!GetInputHandles(env, output_tensor_ids, &outputs)) {
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  TF_Function *function =
+      capture->ToFunction(name.c_str(), outputs, tf_status.status);
+  if (TF_GetCode(tf_status.status) != TF_OK) {
+    NAPI_THROW_ERROR(env, "Failed to capture function %s: %s", name.c_str(),
+                     TF_Message(tf_status.status));
+    return nullptr;
+  }
+  // The context keeps its own copy of the function definition.
+  TFE_ContextAddFunction(context->tfe_context, function, tf_status.status);
+  TF_DeleteFunction(function);
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  napi_value num_ops_value;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_create_int32(env, capture->num_ops(), &num_ops_value),
+      nullptr);
+  return num_ops_value;
+}
+
+void TFJSBackend::CancelCapture(napi_env env) {
+  capture_.reset();
+  capture_context_ = nullptr;
+}
+
+napi_value TFJSBackend::LoadGraphModel(napi_env env,
+                                       napi_value graph_def_value) {
+  void *graph_def_data;
+  size_t graph_def_length;
+  if (!GetTypedArrayData(env, graph_def_value, napi_uint8_array,
+                         &graph_def_data, &graph_def_length)) {
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  GraphSession *session = GraphSession::Create(
+      graph_def_data, graph_def_length, BuildConfigProto(context_->config),
+      tf_status.status);
+  if (TF_GetCode(tf_status.status) != TF_OK) {
+    NAPI_THROW_ERROR(env, "Failed to load graph model: %s",
+                     TF_Message(tf_status.status));
+    return nullptr;
+  }
+
+  int32_t model_id = next_graph_session_id_++;
+  graph_sessions_[model_id].reset(session);
+
+  napi_value model_id_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_int32(env, model_id, &model_id_value),
+                        nullptr);
+  return model_id_value;
+}
+
+// Reads a JS array of strings. Throws and returns false if it is not one.
+static bool GetStringArrayParam(napi_env env, napi_value array_value,
+                                std::vector<std::string> *strings) {
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, array_value, false);
+
+  uint32_t length;
+  ENSURE_NAPI_OK_RETVAL(env, napi_get_array_length(env, array_value, &length),
+                        false);
+  strings->resize(length);
+  for (uint32_t i = 0; i < length; i++) {
+    napi_value string_value;
+    ENSURE_NAPI_OK_RETVAL(
+        env, napi_get_element(env, array_value, i, &string_value), false);
+    ENSURE_NAPI_OK_RETVAL(
+        env, GetStringParam(env, string_value, (*strings)[i]), false);
+  }
+  return true;
+}
+
+// Deletes the non-null tensors of a list.
+static void DeleteTFTensors(const std::vector<TF_Tensor *> &tensors) {
+  for (size_t i = 0; i < tensors.size(); i++) {
+    if (tensors[i] != nullptr) {
+      TF_DeleteTensor(tensors[i]);
+    }
+  }
+}
+
+GraphSession *TFJSBackend::GetGraphSession(napi_env env,
+                                           napi_value model_id_value) {
+  int32_t model_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, model_id_value, &model_id), nullptr);
+  auto session_entry = graph_sessions_.find(model_id);
+  if (session_entry == graph_sessions_.end()) {
+    NAPI_THROW_ERROR(env, "Graph model ID not referenced (model_id: %d)",
+                     model_id);
+    return nullptr;
+  }
+  return session_entry->second.get();
+}
+
+napi_value TFJSBackend::RunGraphModel(napi_env env, napi_value model_id_value,
+                                      napi_value input_names_value,
+                                      napi_value input_tensor_ids,
+                                      napi_value output_names_value) {
+  GraphSession *session = GetGraphSession(env, model_id_value);
+  if (session == nullptr) {
+    return nullptr;
+  }
+
+  std::vector<std::string> input_names;
+  std::vector<std::string> output_names;
+  if (!GetStringArrayParam(env, input_names_value, &input_names) ||
+      !GetStringArrayParam(env, output_names_value, &output_names)) {
+    return nullptr;
+  }
+  return RunGraphSession(env, session, input_names, input_tensor_ids,
+                         output_names);
+}
+
+// Maps the input or output names of a signature to their graph tensor names.
+// Throws and returns false if a name is unknown or not a dense tensor.
+static bool GetSignatureTensorNames(
+    napi_env env, const std::string &signature_key,
+    const std::map<std::string, SignatureTensor> &tensors,
+    const std::vector<std::string> &keys, std::vector<std::string> *names) {
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto tensor = tensors.find(keys[i]);
+    if (tensor == tensors.end()) {
+      NAPI_THROW_ERROR(env, "Signature %s has no tensor named %s",
+                       signature_key.c_str(), keys[i].c_str());
+      return false;
+    }
+    if (tensor->second.name.empty()) {
+      NAPI_THROW_ERROR(env, "Tensor %s of signature %s is not a dense tensor",
+                       keys[i].c_str(), signature_key.c_str());
+      return false;
+    }
+    names->push_back(tensor->second.name);
+  }
+  return true;
+}
+
+napi_value TFJSBackend::RunSignature(napi_env env, napi_value model_id_value,
+                                     napi_value signature_key_value,
+                                     napi_value input_keys_value,
+                                     napi_value input_tensor_ids,
+                                     napi_value output_keys_value) {
+  GraphSession *session = GetGraphSession(env, model_id_value);
+  if (session == nullptr) {
+    return nullptr;
+  }
+
+  std::string signature_key;
+  ENSURE_NAPI_OK_RETVAL(
+      env, GetStringParam(env, signature_key_value, signature_key), nullptr);
+  auto signature = session->signatures().find(signature_key);
+  if (signature == session->signatures().end()) {
+    NAPI_THROW_ERROR(env, "SavedModel has no signature %s",
+                     signature_key.c_str());
+    return nullptr;
+  }
+
+  std::vector<std::string> input_keys;
+  std::vector<std::string> output_keys;
+  if (!GetStringArrayParam(env, input_keys_value, &input_keys) ||
+      !GetStringArrayParam(env, output_keys_value, &output_keys)) {
+    return nullptr;
+  }
+  std::vector<std::string> input_names;
+  std::vector<std::string> output_names;
+  if (!GetSignatureTensorNames(env, signature_key, signature->second.inputs,
+                               input_keys, &input_names) ||
+      !GetSignatureTensorNames(env, signature_key, signature->second.outputs,
+                               output_keys, &output_names)) {
+    return nullptr;
+  }
+  return RunGraphSession(env, session, input_names, input_tensor_ids,
+                         output_names);
+}
+
+bool TFJSBackend::ResolveGraphInputs(napi_env env, napi_value input_tensor_ids,
+                                     size_t num_input_names,
+                                     std::vector<TF_Tensor *> *input_tensors) {
+  if (!EnsureContext(env)) {
+    return false;
+  }
+  // Session runs bypass TFE Ops, so there is nothing to record.
+  if (IsCapturing()) {
+    NAPI_THROW_ERROR(env, "Graph models cannot run while capturing");
+    return false;
+  }
+
+  std::vector<TFE_TensorHandle *> input_handles;
+  if (!GetInputHandles(env, input_tensor_ids, &input_handles)) {
+    return false;
+  }
+  if (input_handles.size() != num_input_names) {
+    NAPI_THROW_ERROR(env, "Graph model got %zu input tensors for %zu names",
+                     input_handles.size(), num_input_names);
+    return false;
+  }
+
+  // Resolving a host tensor shares its buffer, so feeds are not copied.
+  TF_AutoStatus tf_status;
+  for (size_t i = 0; i < input_handles.size(); i++) {
+    TF_Tensor *tensor =
+        TFE_TensorHandleResolve(input_handles[i], tf_status.status);
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      DeleteTFTensors(*input_tensors);
+      input_tensors->clear();
+      ENSURE_TF_OK_RETVAL(env, tf_status, false);
+    }
+    input_tensors->push_back(tensor);
+  }
+  return true;
+}
+
+napi_value TFJSBackend::CreateGraphOutputInfos(
+    napi_env env, std::vector<TF_Tensor *> *output_tensors) {
+  // Handles share the buffers of the fetched tensors, which are released as
+  // soon as they are wrapped.
+  TF_AutoStatus tf_status;
+  std::vector<TFE_TensorHandle *> output_handles;
+  for (size_t i = 0; i < output_tensors->size(); i++) {
+    TFE_TensorHandle *tfe_handle =
+        TFE_NewTensorHandle((*output_tensors)[i], tf_status.status);
+    TF_DeleteTensor((*output_tensors)[i]);
+    (*output_tensors)[i] = nullptr;
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      NAPI_THROW_ERROR(env, "Failed to wrap graph model output: %s",
+                       TF_Message(tf_status.status));
+      tfe_handle = nullptr;
+    } else {
+      tfe_handle = PlaceTensorHandle(env, tfe_handle);
+    }
+    if (tfe_handle == nullptr) {
+      DeleteTFTensors(*output_tensors);
+      output_tensors->clear();
+      for (size_t j = 0; j < output_handles.size(); j++) {
+        TFE_DeleteTensorHandle(output_handles[j]);
+      }
+      return nullptr;
+    }
+    output_handles.push_back(tfe_handle);
+  }
+  output_tensors->clear();
+  return CreateOutputTensorInfos(env, context_, output_handles);
+}
+
+napi_value TFJSBackend::RunGraphSession(
+    napi_env env, GraphSession *session,
+    const std::vector<std::string> &input_names, napi_value input_tensor_ids,
+    const std::vector<std::string> &output_names) {
+  std::vector<TF_Tensor *> input_tensors;
+  if (!ResolveGraphInputs(env, input_tensor_ids, input_names.size(),
+                          &input_tensors)) {
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  std::vector<TF_Tensor *> output_tensors;
+  session->Run(input_names, input_tensors, output_names, &output_tensors,
+               tf_status.status);
+  DeleteTFTensors(input_tensors);
+  if (TF_GetCode(tf_status.status) != TF_OK) {
+    NAPI_THROW_ERROR(env, "Failed to run graph model: %s",
+                     TF_Message(tf_status.status));
+    return nullptr;
+  }
+  return CreateGraphOutputInfos(env, &output_tensors);
+}
+
+// Returns an object that maps the keys of signature tensors to objects with
+// their `name`, `dtype` and, if the rank is known, `shape`.
+static napi_value SignatureTensorsToJS(
+    napi_env env, const std::map<std::string, SignatureTensor> &tensors) {
+  napi_status nstatus;
+
+  napi_value tensors_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_object(env, &tensors_value),
+                        nullptr);
+  for (auto it = tensors.begin(); it != tensors.end(); ++it) {
+    const SignatureTensor &tensor = it->second;
+    napi_value tensor_value;
+    ENSURE_NAPI_OK_RETVAL(env, napi_create_object(env, &tensor_value),
+                          nullptr);
+
+    napi_value name_value;
+    nstatus = napi_create_string_utf8(env, tensor.name.c_str(),
+                                      tensor.name.size(), &name_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_named_property(env, tensor_value, "name", name_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    napi_value dtype_value;
+    nstatus = napi_create_int32(env, tensor.dtype, &dtype_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_named_property(env, tensor_value, "dtype", dtype_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    if (tensor.has_rank) {
+      napi_value shape_value;
+      nstatus = napi_create_array_with_length(env, tensor.shape.size(),
+                                              &shape_value);
+      ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+      for (size_t i = 0; i < tensor.shape.size(); i++) {
+        napi_value dim_value;
+        nstatus = napi_create_int64(env, tensor.shape[i], &dim_value);
+        ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+        nstatus = napi_set_element(env, shape_value, i, dim_value);
+        ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+      }
+      nstatus =
+          napi_set_named_property(env, tensor_value, "shape", shape_value);
+      ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    }
+
+    nstatus = napi_set_named_property(env, tensors_value, it->first.c_str(),
+                                      tensor_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+  return tensors_value;
+}
+
+napi_value TFJSBackend::LoadSavedModel(napi_env env,
+                                       napi_value export_dir_value,
+                                       napi_value tags_value) {
+  napi_status nstatus;
+
+  std::string export_dir;
+  ENSURE_NAPI_OK_RETVAL(env, GetStringParam(env, export_dir_value, export_dir),
+                        nullptr);
+  std::vector<std::string> tags;
+  if (!GetStringArrayParam(env, tags_value, &tags)) {
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  std::unique_ptr<GraphSession> session(GraphSession::LoadSavedModel(
+      export_dir, tags, BuildConfigProto(context_->config), tf_status.status));
+  if (TF_GetCode(tf_status.status) != TF_OK) {
+    NAPI_THROW_ERROR(env, "Failed to load SavedModel from %s: %s",
+                     export_dir.c_str(), TF_Message(tf_status.status));
+    return nullptr;
+  }
+
+  napi_value signatures_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_object(env, &signatures_value),
+                        nullptr);
+  const std::map<std::string, SignatureDef> &signatures =
+      session->signatures();
+  for (auto it = signatures.begin(); it != signatures.end(); ++it) {
+    napi_value signature_value;
+    ENSURE_NAPI_OK_RETVAL(env, napi_create_object(env, &signature_value),
+                          nullptr);
+
+    napi_value method_name_value;
+    nstatus = napi_create_string_utf8(env, it->second.method_name.c_str(),
+                                      it->second.method_name.size(),
+                                      &method_name_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_named_property(env, signature_value, "methodName",
+                                      method_name_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    napi_value inputs_value = SignatureTensorsToJS(env, it->second.inputs);
+    if (inputs_value == nullptr) {
+      return nullptr;
+    }
+    nstatus =
+        napi_set_named_property(env, signature_value, "inputs", inputs_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    napi_value outputs_value = SignatureTensorsToJS(env, it->second.outputs);
+    if (outputs_value == nullptr) {
+      return nullptr;
+    }
+    nstatus = napi_set_named_property(env, signature_value, "outputs",
+                                      outputs_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    nstatus = napi_set_named_property(env, signatures_value, it->first.c_str(),
+                                      signature_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+
+  // The model is only registered once its description could be returned.
+  int32_t model_id = next_graph_session_id_;
+  napi_value result_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_object(env, &result_value), nullptr);
+  napi_value model_id_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_int32(env, model_id, &model_id_value),
+                        nullptr);
+  nstatus = napi_set_named_property(env, result_value, "id", model_id_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  nstatus = napi_set_named_property(env, result_value, "signatures",
+                                    signatures_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  next_graph_session_id_++;
+  graph_sessions_[model_id] = std::move(session);
+  return result_value;
+}
+
+BatchScheduler *TFJSBackend::GetBatchScheduler(napi_env env,
+                                               napi_value model_id_value) {
+  int32_t model_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, model_id_value, &model_id), nullptr);
+  auto session_entry = graph_sessions_.find(model_id);
+  if (session_entry == graph_sessions_.end()) {
+    NAPI_THROW_ERROR(env, "Graph model ID not referenced (model_id: %d)",
+                     model_id);
+    return nullptr;
+  }
+  std::unique_ptr<BatchScheduler> &scheduler = batch_schedulers_[model_id];
+  if (scheduler == nullptr) {
+    scheduler.reset(
+        new BatchScheduler(model_id, session_entry->second, tensor_arena_));
+    napi_status nstatus = scheduler->InitTimer(env, OnBatchTimeout, this);
+    if (nstatus != napi_ok) {
+      batch_schedulers_.erase(model_id);
+    }
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+  return scheduler.get();
+}
+
+void TFJSBackend::ConfigureBatching(napi_env env, napi_value model_id_value,
+                                    napi_value max_batch_size_value,
+                                    napi_value timeout_micros_value) {
+  int64_t max_batch_size;
+  ENSURE_NAPI_OK(
+      env, napi_get_value_int64(env, max_batch_size_value, &max_batch_size));
+  int64_t timeout_micros;
+  ENSURE_NAPI_OK(
+      env, napi_get_value_int64(env, timeout_micros_value, &timeout_micros));
+  if (max_batch_size < 1 || timeout_micros < 0) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid batching options (maxBatchSize: %lld, "
+                     "batchTimeoutMicros: %lld)",
+                     static_cast<long long>(max_batch_size),
+                     static_cast<long long>(timeout_micros));
+    return;
+  }
+
+  BatchScheduler *scheduler = GetBatchScheduler(env, model_id_value);
+  if (scheduler == nullptr) {
+    return;
+  }
+  scheduler->Configure(max_batch_size, timeout_micros);
+
+  // Waiting requests follow the new options.
+  scheduler->StopTimer();
+  if (ScheduleBatch(env, scheduler) != napi_ok) {
+    scheduler->StartTimer();
+  }
+}
+
+// State of a BatchScheduler::RunNextBatch() call on the libuv worker pool.
+// The requests it completes are settled on the main thread.
+struct BatchAsyncWork {
+  TFJSBackend *backend;
+  BatchScheduler *scheduler;
+  std::vector<std::unique_ptr<BatchRequest>> done;
+  napi_async_work work;
+};
+
+// Runs on a worker thread. No N-API calls are allowed here.
+static void BatchAsyncExecute(napi_env env, void *data) {
+  BatchAsyncWork *async_work = static_cast<BatchAsyncWork *>(data);
+  async_work->scheduler->RunNextBatch(&async_work->done);
+}
+
+void TFJSBackend::BatchAsyncComplete(napi_env env, napi_status status,
+                                     void *data) {
+  std::unique_ptr<BatchAsyncWork> async_work(
+      static_cast<BatchAsyncWork *>(data));
+  napi_delete_async_work(env, async_work->work);
+  TFJSBackend *backend = async_work->backend;
+  BatchScheduler *scheduler = async_work->scheduler;
+  scheduler->set_running(false);
+
+  // Outputs are created in the context each request was queued from.
+  ExecutionContext *selected_context = backend->context_;
+  for (size_t i = 0; i < async_work->done.size(); i++) {
+    BatchRequest *request = async_work->done[i].get();
+    napi_value result = nullptr;
+    if (status != napi_ok) {
+      NAPI_THROW_ERROR(env, "Batched graph model run was cancelled");
+    } else if (TF_GetCode(request->status.status) != TF_OK) {
+      NAPI_THROW_ERROR(env, "Failed to run graph model: %s",
+                       TF_Message(request->status.status));
+    } else {
+      backend->context_ = request->context;
+      result = backend->CreateGraphOutputInfos(env, &request->outputs);
+      backend->context_ = selected_context;
+    }
+
+    // Surface any failure as a rejection instead of an uncaught exception.
+    if (IsExceptionPending(env)) {
+      napi_value error;
+      ENSURE_NAPI_OK(env, napi_get_and_clear_last_exception(env, &error));
+      ENSURE_NAPI_OK(env, napi_reject_deferred(env, request->deferred, error));
+    } else {
+      ENSURE_NAPI_OK(env,
+                     napi_resolve_deferred(env, request->deferred, result));
+    }
+  }
+
+  // Requests queued meanwhile wait for the next batch. A deleted model drops
+  // its scheduler, and with it the session, once nothing runs.
+  if (scheduler->is_closed()) {
+    backend->batch_schedulers_.erase(scheduler->model_id());
+  } else if (backend->ScheduleBatch(env, scheduler) != napi_ok) {
+    // Retried once the timer fires.
+    scheduler->StartTimer();
+  }
+}
+
+napi_status TFJSBackend::ScheduleBatch(napi_env env,
+                                       BatchScheduler *scheduler) {
+  if (scheduler->is_running() || scheduler->empty()) {
+    return napi_ok;
+  }
+  if (!scheduler->IsBatchReady()) {
+    scheduler->StartTimer();
+    return napi_ok;
+  }
+
+  std::unique_ptr<BatchAsyncWork> async_work(new BatchAsyncWork());
+  async_work->backend = this;
+  async_work->scheduler = scheduler;
+
+  napi_value resource_name;
+  napi_status nstatus = napi_create_string_latin1(
+      env, "runGraphModelBatched", NAPI_AUTO_LENGTH, &resource_name);
+  if (nstatus == napi_ok) {
+    nstatus = napi_create_async_work(env, nullptr, resource_name,
+                                     BatchAsyncExecute, BatchAsyncComplete,
+                                     async_work.get(), &async_work->work);
+  }
+  if (nstatus == napi_ok) {
+    nstatus = napi_queue_async_work(env, async_work->work);
+    if (nstatus != napi_ok) {
+      napi_delete_async_work(env, async_work->work);
+    }
+  }
+  if (nstatus != napi_ok) {
+    return nstatus;
+  }
+
+  // Ownership of the work state moves to the completion callback.
+  async_work.release();
+  scheduler->StopTimer();
+  scheduler->set_running(true);
+  return napi_ok;
+}
+
+void TFJSBackend::OnBatchTimeout(napi_env env, BatchScheduler *scheduler,
+                                 void *data) {
+  TFJSBackend *backend = static_cast<TFJSBackend *>(data);
+  // Timers run outside of any JS call, so values need their own scope.
+  napi_handle_scope scope;
+  if (napi_open_handle_scope(env, &scope) != napi_ok) {
+    scheduler->StartTimer();
+    return;
+  }
+  if (backend->ScheduleBatch(env, scheduler) != napi_ok) {
+    scheduler->StartTimer();
+  }
+  napi_close_handle_scope(env, scope);
+}
+
+napi_value TFJSBackend::RunGraphModelBatched(napi_env env,
+                                             napi_value model_id_value,
+                                             napi_value input_names_value,
+                                             napi_value input_tensor_ids,
+                                             napi_value output_names_value) {
+  BatchScheduler *scheduler = GetBatchScheduler(env, model_id_value);
+  if (scheduler == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<BatchRequest> request(new BatchRequest());
+  if (!GetStringArrayParam(env, input_names_value, &request->input_names) ||
+      !GetStringArrayParam(env, output_names_value, &request->output_names)) {
+    return nullptr;
+  }
+  if (!ResolveGraphInputs(env, input_tensor_ids, request->input_names.size(),
+                          &request->inputs)) {
+    return nullptr;
+  }
+  request->context = context_;
+
+  napi_value promise;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_create_promise(env, &request->deferred, &promise), nullptr);
+  const BatchRequest *queued_request = request.get();
+  scheduler->Enqueue(std::move(request));
+
+  // A request that cannot be scheduled fails on its own, the rest of the
+  // queue keeps waiting for its timer.
+  napi_status nstatus = ScheduleBatch(env, scheduler);
+  if (nstatus != napi_ok) {
+    request = scheduler->Remove(queued_request);
+    NAPI_THROW_ERROR(env,
+                     "Failed to schedule a batched graph model run "
+                     "(napi_status: %d)",
+                     nstatus);
+    napi_value error;
+    ENSURE_NAPI_OK_RETVAL(env, napi_get_and_clear_last_exception(env, &error),
+                          nullptr);
+    ENSURE_NAPI_OK_RETVAL(
+        env, napi_reject_deferred(env, request->deferred, error), nullptr);
+  }
+  return promise;
+}
+
+// Returns an object with the `count`, `sum` and `max` of a histogram and its
+// `buckets`, where bucket i counts values up to 2^i.
+static napi_value BatchHistogramToJS(napi_env env,
+                                     const BatchHistogram &histogram) {
+  napi_status nstatus;
+
+  napi_value histogram_value;
+  nstatus = napi_create_object(env, &histogram_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  const std::pair<const char *, double> fields[] = {
+      {"count", static_cast<double>(histogram.count)},
+      {"sum", static_cast<double>(histogram.sum)},
+      {"max", static_cast<double>(histogram.max)},
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(fields); i++) {
+    napi_value field_value;
+    nstatus = napi_create_double(env, fields[i].second, &field_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_named_property(env, histogram_value, fields[i].first,
+                                      field_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+
+  napi_value buckets_value;
+  nstatus = napi_create_array_with_length(env, histogram.buckets.size(),
+                                         &buckets_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  for (size_t i = 0; i < histogram.buckets.size(); i++) {
+    napi_value bucket_value;
+    nstatus = napi_create_double(
+        env, static_cast<double>(histogram.buckets[i]), &bucket_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus = napi_set_element(env, buckets_value, i, bucket_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+  nstatus = napi_set_named_property(env, histogram_value, "buckets",
+                                    buckets_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return histogram_value;
+}
+
+napi_value TFJSBackend::GetBatchStats(napi_env env,
+                                      napi_value model_id_value) {
+  BatchScheduler *scheduler = GetBatchScheduler(env, model_id_value);
+  if (scheduler == nullptr) {
+    return nullptr;
+  }
+  const BatchStats stats = scheduler->GetStats();
+
+  napi_value stats_value;
+  ENSURE_NAPI_OK_RETVAL(env, napi_create_object(env, &stats_value), nullptr);
+  const std::pair<const char *, const BatchHistogram *> histograms[] = {
+      {"queueDepth", &stats.queue_depth},
+      {"batchSize", &stats.batch_size},
+      {"batchRequests", &stats.batch_requests},
+  };
+  for (size_t i = 0; i < ARRAY_SIZE(histograms); i++) {
+    napi_value histogram_value = BatchHistogramToJS(env, *histograms[i].second);
+    if (histogram_value == nullptr) {
+      return nullptr;
+    }
+    ENSURE_NAPI_OK_RETVAL(
+        env,
+        napi_set_named_property(env, stats_value, histograms[i].first,
+                                histogram_value),
+        nullptr);
+  }
+  return stats_value;
+}
+
+void TFJSBackend::DeleteGraphModel(napi_env env, napi_value model_id_value) {
+  int32_t model_id;
+  ENSURE_NAPI_OK(env, napi_get_value_int32(env, model_id_value, &model_id));
+
+  auto session_entry = graph_sessions_.find(model_id);
+  if (session_entry == graph_sessions_.end()) {
+    NAPI_THROW_ERROR(
+        env, "Delete called on a graph model not referenced (model_id: %d)",
+        model_id);
+    return;
+  }
+  graph_sessions_.erase(session_entry);
+
+  // A running batch keeps the session alive until it completes, and queued
+  // requests are rejected.
+  auto scheduler_entry = batch_schedulers_.find(model_id);
+  if (scheduler_entry != batch_schedulers_.end()) {
+    std::vector<std::unique_ptr<BatchRequest>> aborted;
+    scheduler_entry->second->Close(&aborted);
+    if (!scheduler_entry->second->is_running()) {
+      batch_schedulers_.erase(scheduler_entry);
+    }
+    for (size_t i = 0; i < aborted.size(); i++) {
+      NAPI_THROW_ERROR(env, "Graph model was deleted (model_id: %d)",
+                       model_id);
+      napi_value error;
+      ENSURE_NAPI_OK(env, napi_get_and_clear_last_exception(env, &error));
+      ENSURE_NAPI_OK(env,
+                     napi_reject_deferred(env, aborted[i]->deferred, error));
+    }
+  }
+}
+
+void TFJSBackend::FinalizeAlignedBuffer(napi_env env, void *data,
+                                        void *hint) {
+  static_cast<AlignedBufferPool *>(hint)->Release(data);
+}
+
+napi_value TFJSBackend::AllocAligned(napi_env env,
+                                     napi_value byte_length_value) {
+  int64_t byte_length;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int64(env, byte_length_value, &byte_length), nullptr);
+  if (byte_length < 0) {
+    NAPI_THROW_ERROR(env, "Invalid byte length: %lld",
+                     static_cast<long long>(byte_length));
+    return nullptr;
+  }
+
+  void *data = aligned_buffer_pool_->Allocate(static_cast<size_t>(byte_length));
+  if (data == nullptr) {
+    NAPI_THROW_ERROR(env, "Failed to allocate %lld aligned bytes",
+                     static_cast<long long>(byte_length));
+    return nullptr;
+  }
+
+  napi_value array_buffer_value;
+  napi_status nstatus = napi_create_external_arraybuffer(
+      env, data, static_cast<size_t>(byte_length), FinalizeAlignedBuffer,
+      aligned_buffer_pool_, &array_buffer_value);
+  if (nstatus != napi_ok) {
+    aligned_buffer_pool_->Release(data);
+  }
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return array_buffer_value;
+}
+
+void TFJSBackend::ConfigureTensorArena(napi_env env,
+                                       napi_value max_cached_bytes_value,
+                                       napi_value max_buffers_per_key_value) {
+  int64_t max_cached_bytes;
+  ENSURE_NAPI_OK(env, napi_get_value_int64(env, max_cached_bytes_value,
+                                           &max_cached_bytes));
+  int64_t max_buffers_per_key;
+  ENSURE_NAPI_OK(env, napi_get_value_int64(env, max_buffers_per_key_value,
+                                           &max_buffers_per_key));
+  if (max_cached_bytes < 0 || max_buffers_per_key < 0) {
+    NAPI_THROW_ERROR(env, "Tensor arena caps must not be negative");
+    return;
+  }
+  tensor_arena_->Configure(static_cast<size_t>(max_cached_bytes),
+                          static_cast<size_t>(max_buffers_per_key));
+}
+
+void TFJSBackend::DeleteTensor(napi_env env, napi_value tensor_id_value) {
+  int32_t tensor_id;
+  ENSURE_NAPI_OK(env, napi_get_value_int32(env, tensor_id_value, &tensor_id));
+
+  size_t num_bytes;
+  if (!RemoveHandle(tensor_id, &num_bytes)) {
+    NAPI_THROW_ERROR(env,
+                     "Delete called on a Tensor not referenced (tensor_id: %d)",
+                     tensor_id);
+    return;
+  }
+  AdjustTensorBytes(env, -static_cast<int64_t>(num_bytes));
+}
+
+void TFJSBackend::DeleteTensors(napi_env env, napi_value tensor_ids_value) {
+  void *tensor_ids_data;
+  size_t num_tensor_ids;
+  if (!GetTypedArrayData(env, tensor_ids_value, napi_int32_array,
+                         &tensor_ids_data, &num_tensor_ids)) {
+    return;
+  }
+  const int32_t *tensor_ids = static_cast<int32_t *>(tensor_ids_data);
+
+  int32_t missing_tensor_id = -1;
+  size_t num_missing = 0;
+  int64_t num_deleted_bytes = 0;
+  for (size_t i = 0; i < num_tensor_ids; i++) {
+    size_t num_bytes;
+    if (!RemoveHandle(tensor_ids[i], &num_bytes)) {
+      if (num_missing++ == 0) {
+        missing_tensor_id = tensor_ids[i];
+      }
+      continue;
+    }
+    num_deleted_bytes += num_bytes;
+  }
+  AdjustTensorBytes(env, -num_deleted_bytes);
+
+  if (num_missing > 0) {
+    NAPI_THROW_ERROR(env,
+                     "Delete called on %zu Tensors not referenced (first "
+                     "tensor_id: %d)",
+                     num_missing, missing_tensor_id);
+  }
+}
+
+napi_value TFJSBackend::GetStats(napi_env env) {
+  napi_status nstatus;
+
+  ReleaseGCTensors(env);
+
+  napi_value stats_value;
+  nstatus = napi_create_object(env, &stats_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  // Byte counts include async Op outputs, which means waiting for them.
+  for (size_t i = 0; i < contexts_.size(); i++) {
+    AccountUnsizedTensors(env, contexts_[i].get());
+  }
+  const size_t num_tensors = handle_table_.size();
+
+  const std::pair<const char *, double> stats[] = {
+      {"numTensors", static_cast<double>(num_tensors)},
+      {"numBytes", static_cast<double>(num_tensor_bytes_)},
+      {"peakBytes", static_cast<double>(peak_tensor_bytes_)},
+      {"numDisposedTensors", static_cast<double>(num_disposed_tensors_)},
+      {"numReclaimedTensors", static_cast<double>(num_reclaimed_tensors_)},
+      {"numReleasedRefs",
+       static_cast<double>(ref_release_queue_->num_released())},
+      {"numMisalignedCopies", static_cast<double>(num_misaligned_copies_)},
+      {"alignedPoolCachedBytes",
+       static_cast<double>(aligned_buffer_pool_->cached_bytes())},
+      {"tensorArenaHits", static_cast<double>(tensor_arena_->num_hits())},
+      {"tensorArenaMisses", static_cast<double>(tensor_arena_->num_misses())},
+      {"tensorArenaCachedBytes",
+       static_cast<double>(tensor_arena_->cached_bytes())},
+      {"numSkippedDeviceCopies",
+       static_cast<double>(num_skipped_device_copies_)},
+  };
+  for (size_t i = 0; i < sizeof(stats) / sizeof(stats[0]); i++) {
+    napi_value stat_value;
+    nstatus = napi_create_double(env, stats[i].second, &stat_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    nstatus =
+        napi_set_named_property(env, stats_value, stats[i].first, stat_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+
+  // Uploads copied to a device, keyed by device name.
+  napi_value device_copies_value;
+  nstatus = napi_create_object(env, &device_copies_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  for (auto &kv : device_copy_stats_) {
+    napi_value device_value;
+    nstatus = napi_create_object(env, &device_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    const std::pair<const char *, double> device_stats[] = {
+        {"numCopies", static_cast<double>(kv.second.num_copies)},
+        {"numBytes", static_cast<double>(kv.second.num_bytes)},
+    };
+    for (size_t i = 0; i < ARRAY_SIZE(device_stats); i++) {
+      napi_value stat_value;
+      nstatus = napi_create_double(env, device_stats[i].second, &stat_value);
+      ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+      nstatus = napi_set_named_property(env, device_value,
+                                        device_stats[i].first, stat_value);
+      ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    }
+    nstatus = napi_set_named_property(env, device_copies_value,
+                                      kv.first.c_str(), device_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+  nstatus = napi_set_named_property(env, stats_value, "deviceCopies",
+                                    device_copies_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return stats_value;
+}
+
+napi_value TFJSBackend::GetTensorData(napi_env env,
+                                      napi_value tensor_id_value,
+                                      bool share_buffer) {
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  ExecutionContext *context = GetTensorContext(tensor_id);
+  TFE_TensorHandle *tfe_handle =
+      context == nullptr ? nullptr : handle_table_.Get(tensor_id);
+  if (tfe_handle == nullptr) {
+    NAPI_THROW_ERROR(
+        env, "Get data called on a Tensor not referenced (tensor_id: %d)",
+        tensor_id);
+    return nullptr;
+  }
+
+  napi_value js_value;
+  CopyTFE_TensorHandleDataToJSData(env, context->tfe_context, tfe_handle,
+                                   share_buffer, &js_value);
+  return js_value;
+}
+
+void TFJSBackend::AddOpInputs(
+    napi_env env, TFE_Op *tfe_op, napi_value input_tensor_ids,
+    std::vector<TFE_TensorHandle *> *input_handles) {
+  napi_status nstatus;
+
+  bool is_typed_array;
+  nstatus = napi_is_typedarray(env, input_tensor_ids, &is_typed_array);
+  ENSURE_NAPI_OK(env, nstatus);
+
+  if (is_typed_array) {
+    void *ids_data;
+    size_t num_input_ids;
+    if (!GetTypedArrayData(env, input_tensor_ids, napi_int32_array, &ids_data,
+                           &num_input_ids)) {
+      return;
+    }
+    AddOpInputs(env, tfe_op, static_cast<int32_t *>(ids_data), num_input_ids,
+                input_handles);
+    return;
+  }
+
+  uint32_t num_input_ids;
+  nstatus = napi_get_array_length(env, input_tensor_ids, &num_input_ids);
+  ENSURE_NAPI_OK(env, nstatus);
+
+  std::vector<int32_t> ids(num_input_ids);
+  for (uint32_t i = 0; i < num_input_ids; i++) {
+    napi_value cur_input_id;
+    nstatus = napi_get_element(env, input_tensor_ids, i, &cur_input_id);
+    ENSURE_NAPI_OK(env, nstatus);
+
+    nstatus = napi_get_value_int32(env, cur_input_id, &ids[i]);
+    ENSURE_NAPI_OK(env, nstatus);
+  }
+  AddOpInputs(env, tfe_op, ids.data(), ids.size(), input_handles);
+}
+
+void TFJSBackend::AddOpInputs(
+    napi_env env, TFE_Op *tfe_op, const int32_t *input_tensor_ids,
+    size_t num_input_ids, std::vector<TFE_TensorHandle *> *input_handles) {
+  TF_AutoStatus tf_status;
+  for (size_t i = 0; i < num_input_ids; i++) {
+    TFE_TensorHandle *input_handle = GetInputHandle(env, input_tensor_ids[i]);
+    if (input_handle == nullptr) {
+      return;
+    }
+
+    TFE_OpAddInput(tfe_op, input_handle, tf_status.status);
+    ENSURE_TF_OK(env, tf_status);
+    if (input_handles != nullptr) {
+      input_handles->push_back(input_handle);
+    }
+  }
+}
+
+void TFJSBackend::RunTFEOp(napi_env env, TFE_Op *tfe_op, int32_t num_outputs,
+                           std::vector<TFE_TensorHandle *> *result_handles,
+                           OpRecord *record) {
+  // Push `nullptr` to get a valid pointer in the call to `TFE_Execute()`
+  // below.
+  result_handles->assign(num_outputs, nullptr);
+
+  TF_AutoStatus tf_status;
+  int size = result_handles->size();
+  TFE_Execute(tfe_op, result_handles->data(), &size, tf_status.status);
+  ENSURE_TF_OK(env, tf_status);
+  result_handles->resize(size);
+
+  if (record != nullptr) {
+    capture_->AddOp(record->op_name, *record->attrs, record->inputs,
+                    *result_handles);
+  }
+}
+
+void TFJSBackend::DeleteHandle(TFE_TensorHandle *tfe_handle) {
+  if (capture_ != nullptr) {
+    capture_->RemoveHandle(tfe_handle);
+  }
+  TFE_DeleteTensorHandle(tfe_handle);
+}
+
+napi_value TFJSBackend::CreateOutputTensorInfos(
+    napi_env env, ExecutionContext *context,
+    const std::vector<TFE_TensorHandle *> &handles) {
+  napi_status nstatus;
+
+  if (!ReserveHandles(env, handles)) {
+    return nullptr;
+  }
+
+  napi_value output_tensor_infos;
+  nstatus =
+      napi_create_array_with_length(env, handles.size(), &output_tensor_infos);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  for (size_t i = 0; i < handles.size(); i++) {
+    // Output tensor info object:
+    napi_value tensor_info_value;
+    nstatus = napi_create_object(env, &tensor_info_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    TFE_TensorHandle *handle = handles[i];
+
+    // Output tensor ID:
+    napi_value output_tensor_id_value;
+    nstatus = napi_create_int32(env, InsertHandle(env, context, handle),
+                                &output_tensor_id_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    nstatus = napi_set_named_property(env, tensor_info_value, "id",
+                                      output_tensor_id_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    // Output tensor shape. Async Ops may still be running, so their shape is
+    // only resolved when it is read:
+    if (context->is_async) {
+      napi_property_descriptor shape_property = {
+          "shape", nullptr, nullptr, GetLazyTensorShape, nullptr,
+          nullptr, napi_enumerable, this};
+      nstatus = napi_define_properties(env, tensor_info_value, 1,
+                                       &shape_property);
+      ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    } else {
+      napi_value shape_value;
+      GetTFE_TensorHandleShape(env, handle, &shape_value);
+
+      nstatus = napi_set_named_property(env, tensor_info_value, "shape",
+                                        shape_value);
+      ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+    }
+
+    // Output tensor dtype:
+    napi_value type_value;
+    GetTFE_TensorHandleType(env, handle, &type_value);
+
+    nstatus =
+        napi_set_named_property(env, tensor_info_value, "dtype", type_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+    // Push into output array
+    nstatus = napi_set_element(env, output_tensor_infos, i, tensor_info_value);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  }
+
+  return output_tensor_infos;
+}
+
+napi_value TFJSBackend::ExecuteTFEOp(napi_env env, TFE_Op *tfe_op,
+                                     napi_value num_output_values,
+                                     OpRecord *record) {
+  napi_status nstatus;
+
+  int32_t num_outputs;
+  nstatus = napi_get_value_int32(env, num_output_values, &num_outputs);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  std::vector<TFE_TensorHandle *> result_handles;
+  RunTFEOp(env, tfe_op, num_outputs, &result_handles, record);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  return CreateOutputTensorInfos(env, context_, result_handles);
+}
+
+napi_value TFJSBackend::WritePackedOutputs(
+    napi_env env, const std::vector<TFE_TensorHandle *> &handles,
+    napi_value output_metadata_value) {
+  napi_status nstatus;
+
+  void *metadata_data;
+  size_t metadata_length;
+  bool is_valid_buffer =
+      GetTypedArrayData(env, output_metadata_value, napi_int32_array,
+                        &metadata_data, &metadata_length);
+
+  // Each output is written as [id, dtype, rank, dim_0, ..., dim_n]. Outputs of
+  // async Ops may still be running, so they are written with a rank of -1
+  // and no dimensions, and their shape is read with GetTensorShape().
+  TF_AutoStatus tf_status;
+  std::vector<int32_t> packed;
+  for (size_t i = 0; is_valid_buffer && i < handles.size(); i++) {
+    TFE_TensorHandle *handle = handles[i];
+    if (context_->is_async) {
+      packed.push_back(-1);
+      packed.push_back(TFE_TensorHandleDataType(handle));
+      packed.push_back(-1);
+      continue;
+    }
+    int num_dims = TFE_TensorHandleNumDims(handle, tf_status.status);
+    if (TF_GetCode(tf_status.status) != TF_OK) {
+      break;
+    }
+    packed.push_back(-1);
+    packed.push_back(TFE_TensorHandleDataType(handle));
+    packed.push_back(num_dims);
+    for (int j = 0; j < num_dims; j++) {
+      packed.push_back(static_cast<int32_t>(
+          TFE_TensorHandleDim(handle, j, tf_status.status)));
+    }
+  }
+
+  // Validate before any handle is registered so that failures do not leak
+  // output tensors.
+  if (!is_valid_buffer || TF_GetCode(tf_status.status) != TF_OK ||
+      packed.size() > metadata_length) {
+    for (size_t i = 0; i < handles.size(); i++) {
+      DeleteHandle(handles[i]);
+    }
+    if (!is_valid_buffer) {
+      return nullptr;
+    }
+    ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+    NAPI_THROW_ERROR(env,
+                     "Output metadata buffer is too small (required: %zu, "
+                     "length: %zu)",
+                     packed.size(), metadata_length);
+    return nullptr;
+  }
+  if (!ReserveHandles(env, handles)) {
+    return nullptr;
+  }
+
+  size_t offset = 0;
+  for (size_t i = 0; i < handles.size(); i++) {
+    packed[offset] = InsertHandle(env, context_, handles[i]);
+    offset += 3 + std::max(packed[offset + 2], 0);
+  }
+  memcpy(metadata_data, packed.data(), packed.size() * sizeof(int32_t));
+
+  napi_value num_outputs_value;
+  nstatus = napi_create_int32(env, static_cast<int32_t>(handles.size()),
+                              &num_outputs_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return num_outputs_value;
+}
+
+napi_value TFJSBackend::ExecuteTFEOpPacked(napi_env env, TFE_Op *tfe_op,
+                                           napi_value num_output_values,
+                                           napi_value output_metadata_value,
+                                           OpRecord *record) {
+  napi_status nstatus;
+
+  int32_t num_outputs;
+  nstatus = napi_get_value_int32(env, num_output_values, &num_outputs);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  std::vector<TFE_TensorHandle *> result_handles;
+  RunTFEOp(env, tfe_op, num_outputs, &result_handles, record);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  return WritePackedOutputs(env, result_handles, output_metadata_value);
+}
+
+napi_value TFJSBackend::GetTensorDataInto(napi_env env,
+                                          napi_value tensor_id_value,
+                                          napi_value target_value,
+                                          napi_value offset_value) {
+  napi_status nstatus;
+
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  TFE_TensorHandle *tfe_handle = GetHandle(tensor_id);
+  if (tfe_handle == nullptr) {
+    NAPI_THROW_ERROR(
+        env, "Get data called on a Tensor not referenced (tensor_id: %d)",
+        tensor_id);
+    return nullptr;
+  }
+
+  napi_typedarray_type expected_array_type;
+  TF_DataType dtype = TFE_TensorHandleDataType(tfe_handle);
+  switch (dtype) {
+    case TF_COMPLEX64:
+    case TF_FLOAT:
+      expected_array_type = napi_float32_array;
+      break;
+    case TF_INT32:
+      expected_array_type = napi_int32_array;
+      break;
+    case TF_BOOL:
+      expected_array_type = napi_uint8_array;
+      break;
+    default:
+      NAPI_THROW_ERROR(env, "Reading into a typed array is not supported for "
+                            "tensors of this dtype");
+      return nullptr;
+  }
+
+  int32_t offset;
+  ENSURE_NAPI_OK_RETVAL(env, napi_get_value_int32(env, offset_value, &offset),
+                        nullptr);
+  if (offset < 0) {
+    NAPI_THROW_ERROR(env, "Invalid offset: %d", offset);
+    return nullptr;
+  }
+
+  void *target_data;
+  size_t target_length;
+  if (!GetTypedArrayData(env, target_value, expected_array_type, &target_data,
+                         &target_length)) {
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  TF_AutoTensor tensor(
+      TFE_TensorHandleResolve(tfe_handle, tf_status.status));
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  size_t num_elements = GetTensorNumElements(tensor.tensor);
+  if (dtype == TF_COMPLEX64) {
+    // Dimension length will be double for Complex 64.
+    num_elements *= 2;
+  }
+  if (static_cast<size_t>(offset) + num_elements > target_length) {
+    NAPI_THROW_ERROR(env,
+                     "Target typed array is too small: %zu tensor elements "
+                     "at offset %d do not fit in %zu elements",
+                     num_elements, offset, target_length);
+    return nullptr;
+  }
+
+  size_t element_size = expected_array_type == napi_uint8_array ? 1 : 4;
+  size_t byte_length = TF_TensorByteSize(tensor.tensor);
+  if (byte_length > 0) {
+    memcpy(static_cast<char *>(target_data) + offset * element_size,
+           TF_TensorData(tensor.tensor), byte_length);
+  }
+
+  napi_value num_elements_value;
+  nstatus = napi_create_uint32(env, static_cast<uint32_t>(num_elements),
+                               &num_elements_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return num_elements_value;
+}
+
+// State for reading tensor data on the libuv worker pool. The work owns a
+// handle sharing the tensor so that the tensor can be deleted from JS while
+// the read is in flight.
+struct TensorDataAsyncWork {
+  TFE_Context *tfe_context;
+  TFE_TensorHandle *tfe_tensor_handle;
+  TF_DataType dtype;
+  void *data;
+  size_t byte_length;
+  size_t num_elements;
+  TF_AutoStatus tf_status;
+  napi_deferred deferred;
+  napi_async_work work;
+};
+
+// Runs on a worker thread. No N-API calls are allowed here.
+static void TensorDataAsyncExecute(napi_env env, void *data) {
+  TensorDataAsyncWork *async_work = static_cast<TensorDataAsyncWork *>(data);
+  if (async_work->dtype == TF_STRING || async_work->dtype == TF_RESOURCE) {
+    // Strings and resources are converted to JS values on the main thread.
+    return;
+  }
+
+  TF_AutoTensor tensor(TFE_TensorHandleResolve(async_work->tfe_tensor_handle,
+                                               async_work->tf_status.status));
+  if (TF_GetCode(async_work->tf_status.status) != TF_OK) {
+    return;
+  }
+
+  async_work->num_elements = GetTensorNumElements(tensor.tensor);
+  if (async_work->dtype == TF_COMPLEX64) {
+    // Dimension length will be double for Complex 64.
+    async_work->num_elements *= 2;
+  }
+  async_work->byte_length = TF_TensorByteSize(tensor.tensor);
+  if (async_work->byte_length > 0) {
+    async_work->data = malloc(async_work->byte_length);
+    if (async_work->data == nullptr) {
+      TF_SetStatus(async_work->tf_status.status, TF_INTERNAL,
+                   "Failed to allocate tensor data buffer");
+      return;
+    }
+    memcpy(async_work->data, TF_TensorData(tensor.tensor),
+           async_work->byte_length);
+  }
+}
+
+static void FreeTensorData(napi_env env, void *data, void *hint) { free(data); }
+
+static void TensorDataAsyncComplete(napi_env env, napi_status status,
+                                    void *data) {
+  std::unique_ptr<TensorDataAsyncWork> async_work(
+      static_cast<TensorDataAsyncWork *>(data));
+  napi_delete_async_work(env, async_work->work);
+
+  napi_value result = nullptr;
+  if (status != napi_ok) {
+    NAPI_THROW_ERROR(env, "Async tensor data read was cancelled");
+  } else if (TF_GetCode(async_work->tf_status.status) != TF_OK) {
+    NAPI_THROW_ERROR(env, "Invalid TF_Status: %u\nMessage: %s",
+                     TF_GetCode(async_work->tf_status.status),
+                     TF_Message(async_work->tf_status.status));
+  } else if (async_work->dtype == TF_STRING ||
+             async_work->dtype == TF_RESOURCE) {
+    CopyTFE_TensorHandleDataToJSData(env, async_work->tfe_context,
+                                     async_work->tfe_tensor_handle, false,
+                                     &result);
+  } else {
+    napi_typedarray_type array_type = async_work->dtype == TF_INT32
+                                          ? napi_int32_array
+                                          : async_work->dtype == TF_BOOL
+                                                ? napi_uint8_array
+                                                : napi_float32_array;
+    napi_value array_buffer_value;
+    napi_status nstatus;
+    if (async_work->data == nullptr) {
+      void *array_buffer_data;
+      nstatus = napi_create_arraybuffer(env, 0, &array_buffer_data,
+                                        &array_buffer_value);
+    } else {
+      // The buffer filled on the worker thread is handed to JS without
+      // another copy.
+      nstatus = napi_create_external_arraybuffer(
+          env, async_work->data, async_work->byte_length, FreeTensorData,
+          nullptr, &array_buffer_value);
+      if (nstatus != napi_ok) {
+        free(async_work->data);
+      }
+    }
+    async_work->data = nullptr;
+    if (nstatus == napi_ok) {
+      nstatus = napi_create_typedarray(env, array_type,
+                                       async_work->num_elements,
+                                       array_buffer_value, 0, &result);
+    }
+    EnsureNapiOK(env, nstatus, __FILE__, __LINE__);
+  }
+  free(async_work->data);
+  TFE_DeleteTensorHandle(async_work->tfe_tensor_handle);
+
+  // Surface any failure as a rejection instead of an uncaught exception.
+  if (IsExceptionPending(env)) {
+    napi_value error;
+    ENSURE_NAPI_OK(env, napi_get_and_clear_last_exception(env, &error));
+    ENSURE_NAPI_OK(env, napi_reject_deferred(env, async_work->deferred, error));
+    return;
+  }
+  ENSURE_NAPI_OK(env,
+                 napi_resolve_deferred(env, async_work->deferred, result));
+}
 
-  napi_value js_value;
-  CopyTFE_TensorHandleDataToJSData(env, tfe_context_, tensor_entry->second,
-                                   &js_value);
-  return js_value;
+napi_value TFJSBackend::GetTensorDataAsync(napi_env env,
+                                           napi_value tensor_id_value) {
+  napi_status nstatus;
+
+  int32_t tensor_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, tensor_id_value, &tensor_id), nullptr);
+
+  ExecutionContext *context = GetTensorContext(tensor_id);
+  TFE_TensorHandle *tfe_handle =
+      context == nullptr ? nullptr : handle_table_.Get(tensor_id);
+  if (tfe_handle == nullptr) {
+    NAPI_THROW_ERROR(
+        env, "Get data called on a Tensor not referenced (tensor_id: %d)",
+        tensor_id);
+    return nullptr;
+  }
+
+  TF_DataType dtype = TFE_TensorHandleDataType(tfe_handle);
+  switch (dtype) {
+    case TF_COMPLEX64:
+    case TF_FLOAT:
+    case TF_INT32:
+    case TF_BOOL:
+    case TF_STRING:
+    case TF_RESOURCE:
+      break;
+    default:
+      REPORT_UNKNOWN_TF_DATA_TYPE(env, dtype);
+      return nullptr;
+  }
+
+  std::unique_ptr<TensorDataAsyncWork> async_work(new TensorDataAsyncWork());
+  async_work->tfe_context = context->tfe_context;
+  async_work->dtype = dtype;
+  async_work->data = nullptr;
+  async_work->byte_length = 0;
+  async_work->num_elements = 0;
+
+  TF_AutoStatus tf_status;
+  async_work->tfe_tensor_handle =
+      TFE_TensorHandleCopySharingTensor(tfe_handle, tf_status.status);
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  napi_value promise;
+  nstatus = napi_create_promise(env, &async_work->deferred, &promise);
+  if (nstatus != napi_ok) {
+    TFE_DeleteTensorHandle(async_work->tfe_tensor_handle);
+  }
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  napi_value resource_name;
+  nstatus = napi_create_string_latin1(env, "tensorDataAsync", NAPI_AUTO_LENGTH,
+                                      &resource_name);
+  if (nstatus == napi_ok) {
+    nstatus = napi_create_async_work(
+        env, nullptr, resource_name, TensorDataAsyncExecute,
+        TensorDataAsyncComplete, async_work.get(), &async_work->work);
+  }
+  if (nstatus == napi_ok) {
+    nstatus = napi_queue_async_work(env, async_work->work);
+    if (nstatus != napi_ok) {
+      napi_delete_async_work(env, async_work->work);
+    }
+  }
+  if (nstatus != napi_ok) {
+    TFE_DeleteTensorHandle(async_work->tfe_tensor_handle);
+  }
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  // Ownership of the work state moves to the completion callback.
+  async_work.release();
+  return promise;
 }
 
 napi_value TFJSBackend::ExecuteOp(napi_env env, napi_value op_name_value,
@@ -840,111 +3655,473 @@ napi_value TFJSBackend::ExecuteOp(napi_env env, napi_value op_name_value,
                                   napi_value num_output_values) {
   napi_status nstatus;
 
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
   std::string op_name;
   nstatus = GetStringParam(env, op_name_value, op_name);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
   TF_AutoStatus tf_status;
-  TFE_AutoOp tfe_op(TFE_NewOp(tfe_context_, op_name.c_str(), tf_status.status));
+  TFE_AutoOp tfe_op(
+      NewOp(op_name.c_str(), context_->op_device_name, tf_status.status));
   ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
 
-  uint32_t num_input_ids;
-  nstatus = napi_get_array_length(env, input_tensor_ids, &num_input_ids);
+  std::vector<OpAttr> attrs;
+  OpRecord record(op_name.c_str(), &attrs);
+  OpRecord *capture_record = IsCapturing() ? &record : nullptr;
+
+  AddOpInputs(env, tfe_op.op, input_tensor_ids,
+              capture_record ? &record.inputs : nullptr);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  ParseOpAttrs(env, op_attr_inputs, &attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  ApplyOpAttrs(env, tfe_op.op, attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  return ExecuteTFEOp(env, tfe_op.op, num_output_values, capture_record);
+}
+
+napi_value TFJSBackend::ExecuteOpPacked(napi_env env,
+                                        napi_value op_name_value,
+                                        napi_value op_attrs_value,
+                                        napi_value input_tensor_ids,
+                                        napi_value num_output_values,
+                                        napi_value output_metadata_value) {
+  napi_status nstatus;
+
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
+  std::string op_name;
+  nstatus = GetStringParam(env, op_name_value, op_name);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-  for (uint32_t i = 0; i < num_input_ids; i++) {
-    napi_value cur_input_id;
-    nstatus = napi_get_element(env, input_tensor_ids, i, &cur_input_id);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  void *attrs_data;
+  size_t attrs_length;
+  if (!GetTypedArrayData(env, op_attrs_value, napi_uint8_array, &attrs_data,
+                         &attrs_length)) {
+    return nullptr;
+  }
 
-    int32_t cur_input_tensor_id;
-    nstatus = napi_get_value_int32(env, cur_input_id, &cur_input_tensor_id);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  std::vector<OpAttr> attrs;
+  ParseOpAttrsFromBuffer(env, static_cast<uint8_t *>(attrs_data), attrs_length,
+                         &attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  TF_AutoStatus tf_status;
+  TFE_AutoOp tfe_op(
+      NewOp(op_name.c_str(), context_->op_device_name, tf_status.status));
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  OpRecord record(op_name.c_str(), &attrs);
+  OpRecord *capture_record = IsCapturing() ? &record : nullptr;
+  AddOpInputs(env, tfe_op.op, input_tensor_ids,
+              capture_record ? &record.inputs : nullptr);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  ApplyOpAttrs(env, tfe_op.op, attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  return ExecuteTFEOpPacked(env, tfe_op.op, num_output_values,
+                            output_metadata_value, capture_record);
+}
+
+napi_value TFJSBackend::ExecuteProgram(napi_env env, napi_value program_value,
+                                       napi_value input_tensor_ids,
+                                       napi_value output_refs_value,
+                                       napi_value output_metadata_value) {
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
+  void *program_data;
+  size_t program_length;
+  if (!GetTypedArrayData(env, program_value, napi_uint8_array, &program_data,
+                         &program_length)) {
+    return nullptr;
+  }
+
+  void *input_ids_data;
+  size_t num_inputs;
+  if (!GetTypedArrayData(env, input_tensor_ids, napi_int32_array,
+                         &input_ids_data, &num_inputs)) {
+    return nullptr;
+  }
+  const int32_t *input_ids = static_cast<int32_t *>(input_ids_data);
 
-    auto input_tensor_entry = tfe_handle_map_.find(cur_input_tensor_id);
-    if (input_tensor_entry == tfe_handle_map_.end()) {
-      NAPI_THROW_ERROR(env, "Input Tensor ID not referenced (tensor_id: %d)",
-                       cur_input_tensor_id);
+  void *output_refs_data;
+  size_t num_output_refs;
+  if (!GetTypedArrayData(env, output_refs_value, napi_int32_array,
+                         &output_refs_data, &num_output_refs)) {
+    return nullptr;
+  }
+  const int32_t *output_refs = static_cast<int32_t *>(output_refs_data);
+
+  // Program values are the program inputs followed by the outputs of every
+  // op in execution order. Only op outputs are owned by the program.
+  std::vector<TFE_TensorHandle *> values;
+  for (size_t i = 0; i < num_inputs; i++) {
+    TFE_TensorHandle *input_handle = GetInputHandle(env, input_ids[i]);
+    if (input_handle == nullptr) {
       return nullptr;
     }
-
-    TFE_OpAddInput(tfe_op.op, input_tensor_entry->second, tf_status.status);
-    ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+    values.push_back(input_handle);
   }
 
-  uint32_t op_attrs_length;
-  nstatus = napi_get_array_length(env, op_attr_inputs, &op_attrs_length);
-  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  PackedBufferReader reader(static_cast<uint8_t *>(program_data),
+                            program_length);
+  int32_t num_ops;
+  bool ok = reader.Read(&num_ops) && num_ops >= 0;
 
-  for (uint32_t i = 0; i < op_attrs_length; i++) {
-    napi_value cur_op_attr;
-    nstatus = napi_get_element(env, op_attr_inputs, i, &cur_op_attr);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  TF_AutoStatus tf_status;
+  for (int32_t i = 0; ok && i < num_ops; i++) {
+    int32_t name_length;
+    const char *name;
+    int32_t attrs_length;
+    const char *attrs_data;
+    int32_t num_op_inputs;
+    if (!reader.Read(&name_length) || name_length < 0 ||
+        !reader.ReadBytes(name_length, &name) || !reader.Read(&attrs_length) ||
+        attrs_length < 0 || !reader.ReadBytes(attrs_length, &attrs_data) ||
+        !reader.Read(&num_op_inputs) || num_op_inputs < 0) {
+      NAPI_THROW_ERROR(env, "Invalid program op at index %d", i);
+      break;
+    }
 
-    AssignOpAttr(env, tfe_op.op, cur_op_attr);
+    std::vector<OpAttr> attrs;
+    ParseOpAttrsFromBuffer(env, reinterpret_cast<const uint8_t *>(attrs_data),
+                           attrs_length, &attrs);
+    if (IsExceptionPending(env)) {
+      break;
+    }
 
-    // Check to see if an exception exists, if so return a failure.
+    const std::string op_name(name, name_length);
+    TFE_AutoOp tfe_op(
+        NewOp(op_name.c_str(), context_->op_device_name, tf_status.status));
+    if (!EnsureTFOK(env, tf_status, __FILE__, __LINE__)) {
+      break;
+    }
+    OpRecord record(op_name.c_str(), &attrs);
+    OpRecord *capture_record = IsCapturing() ? &record : nullptr;
+
+    for (int32_t j = 0; ok && j < num_op_inputs; j++) {
+      int32_t ref;
+      if (!reader.Read(&ref) || ref < 0 ||
+          static_cast<size_t>(ref) >= values.size()) {
+        NAPI_THROW_ERROR(env, "Invalid input reference for program op %d", i);
+        ok = false;
+        break;
+      }
+      TFE_OpAddInput(tfe_op.op, values[ref], tf_status.status);
+      ok = EnsureTFOK(env, tf_status, __FILE__, __LINE__);
+      if (capture_record != nullptr) {
+        record.inputs.push_back(values[ref]);
+      }
+    }
+    if (!ok) {
+      break;
+    }
+
+    ApplyOpAttrs(env, tfe_op.op, attrs);
     if (IsExceptionPending(env)) {
-      return nullptr;
+      break;
     }
+
+    int32_t num_op_outputs;
+    if (!reader.Read(&num_op_outputs) || num_op_outputs < 0) {
+      NAPI_THROW_ERROR(env, "Invalid output count for program op %d", i);
+      break;
+    }
+
+    std::vector<TFE_TensorHandle *> result_handles;
+    RunTFEOp(env, tfe_op.op, num_op_outputs, &result_handles, capture_record);
+    if (IsExceptionPending(env)) {
+      break;
+    }
+    values.insert(values.end(), result_handles.begin(), result_handles.end());
+  }
+
+  // Collect the requested outputs. Every other op output is an intermediate
+  // and is released before returning.
+  std::vector<TFE_TensorHandle *> outputs;
+  std::vector<bool> is_output(values.size(), false);
+  if (!IsExceptionPending(env)) {
+    for (size_t i = 0; i < num_output_refs; i++) {
+      int32_t ref = output_refs[i];
+      if (ref < static_cast<int32_t>(num_inputs) ||
+          static_cast<size_t>(ref) >= values.size() || is_output[ref]) {
+        NAPI_THROW_ERROR(env, "Invalid program output reference: %d", ref);
+        outputs.clear();
+        is_output.assign(values.size(), false);
+        break;
+      }
+      is_output[ref] = true;
+      outputs.push_back(values[ref]);
+    }
+  }
+  for (size_t i = num_inputs; i < values.size(); i++) {
+    if (!is_output[i]) {
+      DeleteHandle(values[i]);
+    }
+  }
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  return WritePackedOutputs(env, outputs, output_metadata_value);
+}
+
+// State for an Op executed on the libuv worker pool. The TFE_Op is fully
+// built on the main thread and holds references to its input handles, so
+// deleting an input tensor while the Op is in flight is safe. Output handles
+// are only inserted into the handle map on the main thread.
+struct ExecuteOpAsyncWork {
+  TFJSBackend *backend;
+  // Context the outputs are inserted into.
+  ExecutionContext *context;
+  TFE_Op *tfe_op;
+  std::vector<TFE_TensorHandle *> result_handles;
+  TF_AutoStatus tf_status;
+  napi_deferred deferred;
+  napi_async_work work;
+};
+
+// Runs on a worker thread. No N-API calls are allowed here.
+static void ExecuteOpAsyncExecute(napi_env env, void *data) {
+  ExecuteOpAsyncWork *async_work = static_cast<ExecuteOpAsyncWork *>(data);
+  int size = async_work->result_handles.size();
+  TFE_Execute(async_work->tfe_op, async_work->result_handles.data(), &size,
+              async_work->tf_status.status);
+  async_work->result_handles.resize(
+      TF_GetCode(async_work->tf_status.status) == TF_OK ? size : 0);
+}
+
+void TFJSBackend::ExecuteOpAsyncComplete(napi_env env, napi_status status,
+                                         void *data) {
+  std::unique_ptr<ExecuteOpAsyncWork> async_work(
+      static_cast<ExecuteOpAsyncWork *>(data));
+  TFE_DeleteOp(async_work->tfe_op);
+  napi_delete_async_work(env, async_work->work);
+
+  napi_value result = nullptr;
+  if (status != napi_ok) {
+    NAPI_THROW_ERROR(env, "Async Op execution was cancelled");
+  } else if (TF_GetCode(async_work->tf_status.status) != TF_OK) {
+    NAPI_THROW_ERROR(env, "Invalid TF_Status: %u\nMessage: %s",
+                     TF_GetCode(async_work->tf_status.status),
+                     TF_Message(async_work->tf_status.status));
+  } else {
+    result = async_work->backend->CreateOutputTensorInfos(
+        env, async_work->context, async_work->result_handles);
+  }
+
+  // Surface any failure as a rejection instead of an uncaught exception.
+  if (IsExceptionPending(env)) {
+    napi_value error;
+    ENSURE_NAPI_OK(env, napi_get_and_clear_last_exception(env, &error));
+    ENSURE_NAPI_OK(env, napi_reject_deferred(env, async_work->deferred, error));
+    return;
+  }
+  ENSURE_NAPI_OK(env,
+                 napi_resolve_deferred(env, async_work->deferred, result));
+}
+
+napi_value TFJSBackend::ExecuteOpAsync(napi_env env, napi_value op_name_value,
+                                       napi_value op_attr_inputs,
+                                       napi_value input_tensor_ids,
+                                       napi_value num_output_values) {
+  napi_status nstatus;
+
+  if (!EnsureContext(env)) {
+    return nullptr;
   }
 
+  std::string op_name;
+  nstatus = GetStringParam(env, op_name_value, op_name);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
   int32_t num_outputs;
   nstatus = napi_get_value_int32(env, num_output_values, &num_outputs);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-  // Push `nullptr` to get a valid pointer in the call to `TFE_Execute()`
-  // below.
-  std::vector<TFE_TensorHandle *> result_handles(num_outputs, nullptr);
+  // Outputs would only exist after the capture may have ended.
+  if (IsCapturing()) {
+    NAPI_THROW_ERROR(env, "executeOpAsync() cannot be used while capturing");
+    return nullptr;
+  }
 
-  int size = result_handles.size();
-  TFE_Execute(tfe_op.op, result_handles.data(), &size, tf_status.status);
+  TF_AutoStatus tf_status;
+  TFE_AutoOp tfe_op(
+      NewOp(op_name.c_str(), context_->op_device_name, tf_status.status));
   ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
 
-  napi_value output_tensor_infos;
-  nstatus = napi_create_array_with_length(env, size, &output_tensor_infos);
+  AddOpInputs(env, tfe_op.op, input_tensor_ids);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  std::vector<OpAttr> attrs;
+  ParseOpAttrs(env, op_attr_inputs, &attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  ApplyOpAttrs(env, tfe_op.op, attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  std::unique_ptr<ExecuteOpAsyncWork> async_work(new ExecuteOpAsyncWork());
+  async_work->backend = this;
+  async_work->context = context_;
+  async_work->result_handles.assign(num_outputs, nullptr);
+
+  napi_value promise;
+  nstatus = napi_create_promise(env, &async_work->deferred, &promise);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-  for (int32_t i = 0; i < num_outputs; i++) {
-    // Output tensor info object:
-    napi_value tensor_info_value;
-    nstatus = napi_create_object(env, &tensor_info_value);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  napi_value resource_name;
+  nstatus = napi_create_string_latin1(env, "executeOpAsync", NAPI_AUTO_LENGTH,
+                                      &resource_name);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-    TFE_TensorHandle *handle = result_handles[i];
+  nstatus = napi_create_async_work(
+      env, nullptr, resource_name, ExecuteOpAsyncExecute,
+      ExecuteOpAsyncComplete, async_work.get(), &async_work->work);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-    // Output tensor ID:
-    napi_value output_tensor_id_value;
-    nstatus =
-        napi_create_int32(env, InsertHandle(handle), &output_tensor_id_value);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  nstatus = napi_queue_async_work(env, async_work->work);
+  if (nstatus != napi_ok) {
+    napi_delete_async_work(env, async_work->work);
+  }
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
-    nstatus = napi_set_named_property(env, tensor_info_value, "id",
-                                      output_tensor_id_value);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  // Ownership of the Op and work state moves to the completion callback.
+  async_work->tfe_op = tfe_op.op;
+  tfe_op.op = nullptr;
+  async_work.release();
+  return promise;
+}
 
-    // Output tensor shape:
-    napi_value shape_value;
-    GetTFE_TensorHandleShape(env, handle, &shape_value);
+napi_value TFJSBackend::PrepareOp(napi_env env, napi_value op_name_value,
+                                  napi_value op_attr_inputs) {
+  napi_status nstatus;
 
-    nstatus =
-        napi_set_named_property(env, tensor_info_value, "shape", shape_value);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
 
-    // Output tensor dtype:
-    napi_value type_value;
-    GetTFE_TensorHandleType(env, handle, &type_value);
+  PreparedOp prepared_op;
+  nstatus = GetStringParam(env, op_name_value, prepared_op.op_name);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  prepared_op.device_name = context_->op_device_name;
 
-    nstatus =
-        napi_set_named_property(env, tensor_info_value, "dtype", type_value);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  ParseOpAttrs(env, op_attr_inputs, &prepared_op.attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
 
-    // Push into output array
-    nstatus = napi_set_element(env, output_tensor_infos, i, tensor_info_value);
-    ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  // Validate the op name and attributes once up front so that errors surface
+  // at prepare time instead of on the first execution.
+  TF_AutoStatus tf_status;
+  TFE_AutoOp tfe_op(
+      NewOp(prepared_op.op_name.c_str(), prepared_op.device_name,
+            tf_status.status));
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  ApplyOpAttrs(env, tfe_op.op, prepared_op.attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
   }
 
-  return output_tensor_infos;
+  int32_t prepared_op_id = next_prepared_op_id_++;
+  prepared_op_map_[prepared_op_id] = std::move(prepared_op);
+
+  napi_value prepared_op_id_value;
+  nstatus = napi_create_int32(env, prepared_op_id, &prepared_op_id_value);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+  return prepared_op_id_value;
+}
+
+napi_value TFJSBackend::ExecutePrepared(napi_env env,
+                                        napi_value prepared_op_id_value,
+                                        napi_value input_tensor_ids,
+                                        napi_value num_output_values,
+                                        napi_value output_metadata_value) {
+  if (!EnsureContext(env)) {
+    return nullptr;
+  }
+
+  int32_t prepared_op_id;
+  ENSURE_NAPI_OK_RETVAL(
+      env, napi_get_value_int32(env, prepared_op_id_value, &prepared_op_id),
+      nullptr);
+
+  auto prepared_op_entry = prepared_op_map_.find(prepared_op_id);
+  if (prepared_op_entry == prepared_op_map_.end()) {
+    NAPI_THROW_ERROR(env, "Prepared Op ID not referenced (prepared_op_id: %d)",
+                     prepared_op_id);
+    return nullptr;
+  }
+  const PreparedOp &prepared_op = prepared_op_entry->second;
+
+  TF_AutoStatus tf_status;
+  TFE_AutoOp tfe_op(
+      NewOp(prepared_op.op_name.c_str(), prepared_op.device_name,
+            tf_status.status));
+  ENSURE_TF_OK_RETVAL(env, tf_status, nullptr);
+
+  OpRecord record(prepared_op.op_name.c_str(), &prepared_op.attrs);
+  OpRecord *capture_record = IsCapturing() ? &record : nullptr;
+  AddOpInputs(env, tfe_op.op, input_tensor_ids,
+              capture_record ? &record.inputs : nullptr);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  ApplyOpAttrs(env, tfe_op.op, prepared_op.attrs);
+  if (IsExceptionPending(env)) {
+    return nullptr;
+  }
+
+  if (output_metadata_value != nullptr) {
+    return ExecuteTFEOpPacked(env, tfe_op.op, num_output_values,
+                              output_metadata_value, capture_record);
+  }
+  return ExecuteTFEOp(env, tfe_op.op, num_output_values, capture_record);
+}
+
+void TFJSBackend::ReleasePreparedOp(napi_env env,
+                                    napi_value prepared_op_id_value) {
+  int32_t prepared_op_id;
+  ENSURE_NAPI_OK(
+      env, napi_get_value_int32(env, prepared_op_id_value, &prepared_op_id));
+
+  auto prepared_op_entry = prepared_op_map_.find(prepared_op_id);
+  if (prepared_op_entry == prepared_op_map_.end()) {
+    NAPI_THROW_ERROR(
+        env, "Release called on a Prepared Op not referenced (id: %d)",
+        prepared_op_id);
+    return;
+  }
+  prepared_op_map_.erase(prepared_op_entry);
 }
 
 }  // namespace tfnodejs
@@ -22,16 +22,154 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
+#include "aligned_buffer_pool.h"
+#include "batch_scheduler.h"
+#include "graph_capture.h"
+#include "graph_session.h"
+#include "napi_ref_release_queue.h"
+#include "tensor_arena.h"
 #include "tensorflow/c/eager/c_api.h"
+#include "tfe_handle_table.h"
 
 namespace tfnodejs {
 
+// Native copy of a TFE Op attribute. Values are converted from JS once so that
+// they can be applied to new TFE_Op instances without any N-API calls.
+struct OpAttr {
+  const char* name;
+  TF_AttrType type;
+  bool is_list;
+  std::string string_value;
+  // Holds TF_ATTR_INT, TF_ATTR_TYPE and TF_ATTR_SHAPE values.
+  std::vector<int64_t> int_values;
+  std::vector<float> float_values;
+  std::vector<unsigned char> bool_values;
+};
+
+// An Op name and fully-specified attribute set that can be executed many
+// times with different inputs.
+struct PreparedOp {
+  std::string op_name;
+  std::vector<OpAttr> attrs;
+  // Device selected when the Op was prepared, or empty for TF placement.
+  std::string device_name;
+};
+
+// An Op executed while capturing, recorded once its outputs exist.
+struct OpRecord {
+  OpRecord(const char* op_name, const std::vector<OpAttr>* attrs)
+      : op_name(op_name), attrs(attrs) {}
+
+  const char* op_name;
+  const std::vector<OpAttr>* attrs;
+  std::vector<TFE_TensorHandle*> inputs;
+};
+
+// Options applied to the TFE_Context when it is created. Negative values are
+// unset and fall back to environment variables, then to TensorFlow defaults.
+struct ContextConfig {
+  int32_t intra_op_parallelism_threads;
+  int32_t inter_op_parallelism_threads;
+  int32_t allow_soft_placement;
+  // Whether to use the TFE_Context shared by all envs of the process instead
+  // of a private one.
+  int32_t share_context;
+  // Whether TFE_Execute() only enqueues kernels instead of running them to
+  // completion. Output shapes then resolve on demand.
+  int32_t async_execution;
+  // Serialized ConfigProto that the fields above are merged into.
+  std::string config_proto;
+};
+
+// A TFE_Context with its own thread pools and default device. The handle
+// table of the backend records the context that owns each tensor.
+struct ExecutionContext {
+  explicit ExecutionContext(uint32_t id);
+  ~ExecutionContext();
+
+  uint32_t id;
+  std::string name;
+  ContextConfig config;
+  // Created on first use from `config`.
+  TFE_Context* tfe_context;
+  // Whether `tfe_context` is the process-wide shared context.
+  bool is_shared;
+  // Whether `tfe_context` executes Ops asynchronously.
+  bool is_async;
+  // IDs of tensors of an async context whose bytes are not accounted yet,
+  // because their size is only known once their Op completes.
+  std::vector<int32_t> unsized_tensor_ids;
+  // Default device of new tensors, picked when `tfe_context` is created.
+  std::string device_name;
+  // Device selected with SetDevice() for Ops and new tensors. Empty leaves Op
+  // placement to TensorFlow and tensors on `device_name`.
+  std::string op_device_name;
+};
+
+// Counts uploads copied to a device.
+struct DeviceCopyStats {
+  DeviceCopyStats() : num_copies(0), num_bytes(0) {}
+
+  uint64_t num_copies;
+  uint64_t num_bytes;
+};
+
 class TFJSBackend {
  public:
   // Creates, initializes, and returns a TFJSBackend instance. If initialization
   // fails, a nullptr is returned.
   static TFJSBackend* Create(napi_env env);
 
+  // Deletes a TFJSBackend instance. Used as env cleanup hook, so that every
+  // env (e.g. a worker thread) releases its backend when it is torn down.
+  static void Destroy(void* backend);
+
+  // Sets the options of the default TFE_Context. The context is created on
+  // first use, so this must be called before any tensor is created or Op is
+  // executed in it.
+  // - config_value (object): intraOpParallelismThreads (number),
+  //   interOpParallelismThreads (number), allowSoftPlacement (boolean),
+  //   shareContext (boolean), asyncExecution (boolean) and configProto
+  //   (Uint8Array), all optional.
+  void ConfigureContext(napi_env env, napi_value config_value);
+
+  // Adds a named execution context with its own TFE_Context and returns its
+  // ID. The default context has ID 0.
+  // - name_value (string)
+  // - config_value (object): same options as ConfigureContext().
+  napi_value CreateContext(napi_env env, napi_value name_value,
+                           napi_value config_value);
+
+  // Selects the context that new tensors are created in and Ops execute in.
+  // Op inputs must belong to the selected context.
+  // - context_id_value (number)
+  void SetContext(napi_env env, napi_value context_id_value);
+
+  // Returns the devices of the selected context as an array of objects with
+  // `name` and `type` fields.
+  napi_value ListDevices(napi_env env);
+
+  // Selects the device that Ops and new tensors of the selected context are
+  // placed on. Accepts a full device name or its `TYPE:N` suffix. An empty
+  // name restores the default placement. Int32 and string tensors stay in
+  // host memory either way.
+  // - device_name_value (string)
+  void SetDevice(napi_env env, napi_value device_name_value);
+
+  // Waits for all Ops enqueued in the selected context and throws the first
+  // error an async Op raised since the last call.
+  void Sync(napi_env env);
+
+  // Returns the shape of a tensor, waiting for the Op that produces it if it
+  // was executed asynchronously.
+  // - tensor_id_value (number)
+  napi_value GetTensorShape(napi_env env, napi_value tensor_id_value);
+
+  // Returns the name of the device a tensor lives on.
+  // - tensor_id_value (number)
+  napi_value GetTensorDevice(napi_env env, napi_value tensor_id_value);
+
   // Creates a new Tensor with given shape and data and returns an ID that
   // refernces the new Tensor.
   // - shape_value (number[])
@@ -44,10 +182,33 @@ class TFJSBackend {
   // - tensor_id_value (number)
   void DeleteTensor(napi_env env, napi_value tensor_id_value);
 
+  // Deletes a batch of created Tensors. Every referenced ID is deleted even
+  // if some IDs are unknown, in which case an exception is thrown afterwards.
+  // - tensor_ids_value (Int32Array)
+  void DeleteTensors(napi_env env, napi_value tensor_ids_value);
+
   // Returns a typed-array as a `napi_value` with the data associated with the
   // TF/TFE pointers.
   // - tensor_id_value (number)
-  napi_value GetTensorData(napi_env env, napi_value tensor_id_value);
+  // - share_buffer (bool): when true, numeric data is returned as a view over
+  //   the TF_Tensor buffer instead of a copy. Buffers that are memory of a JS
+  //   typed array are still copied.
+  napi_value GetTensorData(napi_env env, napi_value tensor_id_value,
+                           bool share_buffer);
+
+  // Copies the data associated with the TF/TFE pointers into an existing
+  // typed-array and returns the number of elements written.
+  // - tensor_id_value (number)
+  // - target_value (Float32Array|Int32Array|Uint8Array matching the dtype)
+  // - offset_value (number): element offset into the target.
+  napi_value GetTensorDataInto(napi_env env, napi_value tensor_id_value,
+                               napi_value target_value,
+                               napi_value offset_value);
+
+  // Returns a Promise that resolves with the same value as GetTensorData().
+  // The tensor is resolved and copied on a worker thread.
+  // - tensor_id_value (number)
+  napi_value GetTensorDataAsync(napi_env env, napi_value tensor_id_value);
 
   // Executes a TFE Op and returns an array of objects containing tensor
   // attributes (id, dtype, shape).
@@ -59,16 +220,404 @@ class TFJSBackend {
                        napi_value op_attr_inputs, napi_value input_tensor_ids,
                        napi_value num_output_values);
 
+  // Executes a TFE Op on a worker thread and returns a Promise that resolves
+  // with an array of objects containing tensor attributes (id, dtype, shape).
+  // - op_name_value (string)
+  // - op_attr_inputs (array of TFE Op attributes)
+  // - input_tensor_ids (array of input tensor IDs)
+  // - num_output_values (number)
+  napi_value ExecuteOpAsync(napi_env env, napi_value op_name_value,
+                            napi_value op_attr_inputs,
+                            napi_value input_tensor_ids,
+                            napi_value num_output_values);
+
+  // Executes a TFE Op with packed inputs and attributes. Output metadata is
+  // written into a caller supplied Int32Array as [id, dtype, rank, ...dims]
+  // for each output, and the number of outputs is returned. Async contexts
+  // write a rank of -1 and no dims.
+  // - op_name_value (string)
+  // - op_attrs_value (Uint8Array of packed TFE Op attributes)
+  // - input_tensor_ids (Int32Array of input tensor IDs)
+  // - num_output_values (number)
+  // - output_metadata_value (Int32Array)
+  napi_value ExecuteOpPacked(napi_env env, napi_value op_name_value,
+                             napi_value op_attrs_value,
+                             napi_value input_tensor_ids,
+                             napi_value num_output_values,
+                             napi_value output_metadata_value);
+
+  // Executes a serialized list of Ops in one call. Op inputs reference the
+  // program inputs or outputs of earlier Ops. Only the referenced program
+  // outputs are kept, intermediate tensors are released. Output metadata is
+  // written in the packed format used by ExecuteOpPacked().
+  // - program_value (Uint8Array of the serialized program)
+  // - input_tensor_ids (Int32Array of program input tensor IDs)
+  // - output_refs_value (Int32Array of program value indices to return)
+  // - output_metadata_value (Int32Array)
+  napi_value ExecuteProgram(napi_env env, napi_value program_value,
+                            napi_value input_tensor_ids,
+                            napi_value output_refs_value,
+                            napi_value output_metadata_value);
+
+  // Parses an Op name and attributes once and returns an ID that references
+  // the prepared Op.
+  // - op_name_value (string)
+  // - op_attr_inputs (array of TFE Op attributes)
+  napi_value PrepareOp(napi_env env, napi_value op_name_value,
+                       napi_value op_attr_inputs);
+
+  // Executes a prepared Op and returns an array of objects containing tensor
+  // attributes (id, dtype, shape). When an output metadata buffer is supplied,
+  // outputs are written in the packed format used by ExecuteOpPacked().
+  // - prepared_op_id_value (number)
+  // - input_tensor_ids (array or Int32Array of input tensor IDs)
+  // - num_output_values (number)
+  // - output_metadata_value (optional Int32Array)
+  napi_value ExecutePrepared(napi_env env, napi_value prepared_op_id_value,
+                             napi_value input_tensor_ids,
+                             napi_value num_output_values,
+                             napi_value output_metadata_value);
+
+  // Releases a prepared Op.
+  // - prepared_op_id_value (number)
+  void ReleasePreparedOp(napi_env env, napi_value prepared_op_id_value);
+
+  // Returns an object with native memory statistics: the number of live
+  // tensors, the bytes they hold, the peak of that byte count and how many
+  // tensors were deleted explicitly or reclaimed after garbage collection, and
+  // how many shared JS typed arrays were released.
+  napi_value GetStats(napi_env env);
+
+  // Returns an ArrayBuffer whose memory is aligned so that TensorFlow can
+  // share it without a copy when it backs a tensor created by CreateTensor().
+  // The memory returns to a pool when the ArrayBuffer is garbage collected.
+  // - byte_length_value (number)
+  napi_value AllocAligned(napi_env env, napi_value byte_length_value);
+
+  // Sets the caps of the arena that recycles buffers for tensors created from
+  // misaligned typed arrays. A zero byte cap disables the arena.
+  // - max_cached_bytes_value (number)
+  // - max_buffers_per_key_value (number): buffers kept per (dtype, size).
+  void ConfigureTensorArena(napi_env env, napi_value max_cached_bytes_value,
+                            napi_value max_buffers_per_key_value);
+
+  // Exports the data of a tensor to any env in the process and returns a
+  // token that ImportTensor() accepts once. Host data owned by TensorFlow is
+  // shared, not copied. Memory of a typed array of this env is copied, so the
+  // import does not depend on this env staying alive.
+  // - tensor_id_value (number)
+  napi_value ExportTensor(napi_env env, napi_value tensor_id_value);
+
+  // Creates a tensor in the selected context from an exported tensor and
+  // returns an object containing tensor attributes (id, dtype, shape).
+  // - token_value (number)
+  napi_value ImportTensor(napi_env env, napi_value token_value);
+
+  // Drops an exported tensor that will not be imported.
+  // - token_value (number)
+  void ReleaseTensorExport(napi_env env, napi_value token_value);
+
+  // Returns an external value that releases the tensor when it is garbage
+  // collected, unless the tensor is deleted explicitly first.
+  // - tensor_id_value (number)
+  napi_value TrackTensor(napi_env env, napi_value tensor_id_value);
+
+  // Starts recording the Ops executed in the selected context into a graph.
+  // Ops still execute eagerly. The given tensors become the function
+  // arguments, other tensors that Ops read are captured as constants.
+  // - input_tensor_ids (number[]|Int32Array)
+  void BeginCapture(napi_env env, napi_value input_tensor_ids);
+
+  // Stops recording and registers the recorded Ops as a function that
+  // returns the given tensors. The function runs as an Op named `name` in the
+  // selected context. Returns the number of recorded Ops.
+  // - name_value (string)
+  // - output_tensor_ids (number[]|Int32Array)
+  napi_value EndCapture(napi_env env, napi_value name_value,
+                        napi_value output_tensor_ids);
+
+  // Stops recording and drops the recorded Ops.
+  void CancelCapture(napi_env env);
+
+  // Imports a serialized GraphDef into a graph run by its own TF_Session and
+  // returns an ID that references the graph model. The session uses the
+  // thread and placement options of the selected context.
+  // - graph_def_value (Uint8Array)
+  napi_value LoadGraphModel(napi_env env, napi_value graph_def_value);
+
+  // Runs a graph model with tensors of the selected context as feeds and
+  // returns an array of objects containing the attributes (id, dtype, shape)
+  // of the fetched tensors, which are created in the selected context.
+  // - model_id_value (number)
+  // - input_names_value (string[] of `node` or `node:index` tensor names)
+  // - input_tensor_ids (Int32Array of the fed tensor IDs)
+  // - output_names_value (string[] of the fetched tensor names)
+  napi_value RunGraphModel(napi_env env, napi_value model_id_value,
+                           napi_value input_names_value,
+                           napi_value input_tensor_ids,
+                           napi_value output_names_value);
+
+  // Loads a SavedModel into a graph run by its own TF_Session, like
+  // LoadGraphModel(). Returns an object with the model `id` and its
+  // `signatures` by key. A signature has a `methodName` and `inputs` and
+  // `outputs` that map names to the `name`, `dtype` and optional `shape` of
+  // graph tensors.
+  // - export_dir_value (string)
+  // - tags_value (string[] selecting the MetaGraph to load)
+  napi_value LoadSavedModel(napi_env env, napi_value export_dir_value,
+                            napi_value tags_value);
+
+  // Runs a signature of a SavedModel, like RunGraphModel() but with tensors
+  // named by their signature input and output names.
+  // - model_id_value (number)
+  // - signature_key_value (string)
+  // - input_keys_value (string[])
+  // - input_tensor_ids (Int32Array of the fed tensor IDs)
+  // - output_keys_value (string[])
+  napi_value RunSignature(napi_env env, napi_value model_id_value,
+                          napi_value signature_key_value,
+                          napi_value input_keys_value,
+                          napi_value input_tensor_ids,
+                          napi_value output_keys_value);
+
+  // Sets how concurrent RunGraphModelBatched() calls of a model are batched.
+  // Batches start with a cap of 1 row, which runs every call alone.
+  // - model_id_value (number)
+  // - max_batch_size_value (number): rows, i.e. the sum of the first input
+  //   dimensions, of a batch.
+  // - timeout_micros_value (number): how long the oldest queued call waits
+  //   for a batch to fill.
+  void ConfigureBatching(napi_env env, napi_value model_id_value,
+                         napi_value max_batch_size_value,
+                         napi_value timeout_micros_value);
+
+  // Queues a graph model run, like RunGraphModel(), and returns a Promise
+  // that resolves with the tensor infos of the fetched tensors. Calls with
+  // the same input and output names, dtypes and trailing input dimensions
+  // have their inputs concatenated along the first dimension and run as one
+  // session call on a worker thread. Calls wait for a batch on the main
+  // loop, so worker threads only run full or timed out batches. The fetched
+  // tensors are split back into per-call tensors, so they must have the batch
+  // as first dimension.
+  // - model_id_value (number)
+  // - input_names_value (string[])
+  // - input_tensor_ids (Int32Array of the fed tensor IDs)
+  // - output_names_value (string[])
+  napi_value RunGraphModelBatched(napi_env env, napi_value model_id_value,
+                                  napi_value input_names_value,
+                                  napi_value input_tensor_ids,
+                                  napi_value output_names_value);
+
+  // Returns the `queueDepth`, `batchSize` and `batchRequests` histograms of
+  // the batched runs of a model, see BatchHistogram.
+  // - model_id_value (number)
+  napi_value GetBatchStats(napi_env env, napi_value model_id_value);
+
+  // Closes the session of a graph model or SavedModel and releases its
+  // graph.
+  // - model_id_value (number)
+  void DeleteGraphModel(napi_env env, napi_value model_id_value);
+
  private:
   TFJSBackend(napi_env env);
   ~TFJSBackend();
 
-  int32_t InsertHandle(TFE_TensorHandle* tfe_handle);
+  // Creates the TFE_Context of the selected context from its config if it
+  // does not exist yet and picks the default device. Throws and returns false
+  // on failure.
+  bool EnsureContext(napi_env env);
 
-  TFE_Context* tfe_context_;
-  std::map<int32_t, TFE_TensorHandle*> tfe_handle_map_;
-  int32_t next_tensor_id_;
-  std::string device_name;
+  // Reads context options from a JS object into `config`. Throws and returns
+  // false on invalid options.
+  bool ParseContextConfig(napi_env env, napi_value config_value,
+                          ContextConfig* config);
+
+  // Creates an Op in the selected context, placed on its selected device.
+  // Returns nullptr with `status` set on failure.
+  TFE_Op* NewOp(const char* op_name, const std::string& device_name,
+                TF_Status* status);
+
+  // Getter of the lazy `shape` property of output tensor infos of async
+  // contexts. The backend is passed as callback data.
+  static napi_value GetLazyTensorShape(napi_env env, napi_callback_info info);
+
+  // Accounts the bytes of a tensor inserted without them, waiting for its Op
+  // if needed.
+  void AccountTensorBytes(napi_env env, int32_t tensor_id);
+
+  // Accounts the bytes of every unsized tensor of an async context.
+  void AccountUnsizedTensors(napi_env env, ExecutionContext* context);
+
+  // Returns the context that issued a tensor ID, or nullptr.
+  ExecutionContext* GetTensorContext(int32_t tensor_id);
+
+  // Returns the handle for a tensor ID in any context, or nullptr.
+  TFE_TensorHandle* GetHandle(int32_t tensor_id);
+
+  // Returns the handle of an Op input in the selected context. Throws and
+  // returns nullptr if the ID is unknown or belongs to another context.
+  TFE_TensorHandle* GetInputHandle(napi_env env, int32_t tensor_id);
+
+  // Registers a handle owned by a context and returns its tensor ID. If the
+  // handle table is full, the handle is deleted, an exception is thrown and
+  // -1 is returned.
+  int32_t InsertHandle(napi_env env, ExecutionContext* context,
+                       TFE_TensorHandle* tfe_handle);
+
+  // Ensures the handle table has room for every handle in `handles`.
+  // Otherwise all handles are deleted, an exception is thrown and false is
+  // returned.
+  bool ReserveHandles(napi_env env,
+                      const std::vector<TFE_TensorHandle*>& handles);
+
+  // Removes and deletes a handle on explicit deletion. Returns false if the
+  // ID is not referenced.
+  bool RemoveHandle(int32_t tensor_id, size_t* num_bytes);
+
+  // Moves a new host tensor handle to the device of the selected context,
+  // unless it already lives there or is expected in host memory. Takes
+  // ownership of `tfe_handle` and returns the placed handle, or nullptr after
+  // throwing if the copy fails.
+  TFE_TensorHandle* PlaceTensorHandle(napi_env env,
+                                      TFE_TensorHandle* tfe_handle);
+
+  // Finalizer for ArrayBuffers returned by AllocAligned().
+  static void FinalizeAlignedBuffer(napi_env env, void* data, void* hint);
+
+  // Finalizer for values returned by TrackTensor().
+  static void FinalizeTensorReleaser(napi_env env, void* data, void* hint);
+
+  // Deletes the tensors queued by garbage collected TrackTensor() values.
+  void ReleaseGCTensors(napi_env env);
+
+  // Updates the live tensor byte count and reports the change to V8.
+  void AdjustTensorBytes(napi_env env, int64_t change_in_bytes);
+
+  // Looks up each input tensor ID and adds the handle as an Op input. The
+  // handles are also appended to `input_handles` if given.
+  void AddOpInputs(napi_env env, TFE_Op* tfe_op, napi_value input_tensor_ids,
+                   std::vector<TFE_TensorHandle*>* input_handles = nullptr);
+  void AddOpInputs(napi_env env, TFE_Op* tfe_op,
+                   const int32_t* input_tensor_ids, size_t num_input_ids,
+                   std::vector<TFE_TensorHandle*>* input_handles = nullptr);
+
+  // Executes a fully-specified TFE_Op and returns the output handles. The Op
+  // is recorded into the active capture if `record` is given.
+  void RunTFEOp(napi_env env, TFE_Op* tfe_op, int32_t num_outputs,
+                std::vector<TFE_TensorHandle*>* result_handles,
+                OpRecord* record = nullptr);
+
+  // Looks up the handles of an Int32Array of tensor IDs in the selected
+  // context. Throws and returns false if an ID is unknown.
+  bool GetInputHandles(napi_env env, napi_value tensor_ids_value,
+                       std::vector<TFE_TensorHandle*>* handles);
+
+  // Returns whether Ops of the selected context are being captured.
+  bool IsCapturing() const {
+    return capture_ != nullptr && capture_context_ == context_;
+  }
+
+  // Deletes a handle that may have been seen by the active capture.
+  void DeleteHandle(TFE_TensorHandle* tfe_handle);
+
+  // Returns the graph session of a model ID. Throws and returns nullptr if the
+  // ID is not referenced.
+  GraphSession* GetGraphSession(napi_env env, napi_value model_id_value);
+
+  // Resolves the tensors of the selected context fed to a graph model. Throws
+  // and returns false if an ID is unknown, the count does not match the
+  // number of input names or Ops are being captured.
+  bool ResolveGraphInputs(napi_env env, napi_value input_tensor_ids,
+                          size_t num_input_names,
+                          std::vector<TF_Tensor*>* input_tensors);
+
+  // Wraps the tensors fetched from a graph model into handles of the selected
+  // context and returns their tensor infos. Takes ownership of the tensors.
+  napi_value CreateGraphOutputInfos(napi_env env,
+                                    std::vector<TF_Tensor*>* output_tensors);
+
+  // Runs a graph session with tensors of the selected context as feeds and
+  // returns the tensor infos of the fetched tensors.
+  napi_value RunGraphSession(napi_env env, GraphSession* session,
+                             const std::vector<std::string>& input_names,
+                             napi_value input_tensor_ids,
+                             const std::vector<std::string>& output_names);
+
+  // Returns the batch scheduler of a model ID, created on first use. Throws
+  // and returns nullptr if the ID is not referenced.
+  BatchScheduler* GetBatchScheduler(napi_env env, napi_value model_id_value);
+
+  // Runs the next batch of a scheduler on the libuv worker pool once it is
+  // ready, or starts the timer of its oldest request. Does not throw, so it
+  // can run outside of a JS call.
+  napi_status ScheduleBatch(napi_env env, BatchScheduler* scheduler);
+
+  // Schedules the batch of a timed out request on the main loop.
+  static void OnBatchTimeout(napi_env env, BatchScheduler* scheduler,
+                             void* data);
+
+  // Settles the requests of a batch on the main thread.
+  static void BatchAsyncComplete(napi_env env, napi_status status, void* data);
+
+  // Inserts output handles into a context and returns an array of objects
+  // containing tensor attributes (id, dtype, shape).
+  napi_value CreateOutputTensorInfos(
+      napi_env env, ExecutionContext* context,
+      const std::vector<TFE_TensorHandle*>& handles);
+
+  // Completes an ExecuteOpAsync() call on the main thread.
+  static void ExecuteOpAsyncComplete(napi_env env, napi_status status,
+                                     void* data);
+
+  // Executes a fully-specified TFE_Op and returns the output tensor metadata.
+  napi_value ExecuteTFEOp(napi_env env, TFE_Op* tfe_op,
+                          napi_value num_output_values,
+                          OpRecord* record = nullptr);
+
+  // Registers output handles and writes their packed metadata. All handles are
+  // released if the metadata does not fit.
+  napi_value WritePackedOutputs(napi_env env,
+                                const std::vector<TFE_TensorHandle*>& handles,
+                                napi_value output_metadata_value);
+
+  // Executes a fully-specified TFE_Op and writes packed output metadata.
+  napi_value ExecuteTFEOpPacked(napi_env env, TFE_Op* tfe_op,
+                                napi_value num_output_values,
+                                napi_value output_metadata_value,
+                                OpRecord* record = nullptr);
+
+  // Contexts indexed by ID. Contexts are never removed, so pointers to them
+  // stay valid for the lifetime of the backend.
+  std::vector<std::unique_ptr<ExecutionContext>> contexts_;
+  // The selected context.
+  ExecutionContext* context_;
+  // Live tensors of every context, indexed by tensor ID.
+  TFEHandleTable handle_table_;
+  int64_t num_tensor_bytes_;
+  int64_t peak_tensor_bytes_;
+  uint64_t num_disposed_tensors_;
+  uint64_t num_reclaimed_tensors_;
+  std::vector<int32_t> gc_released_tensor_ids_;
+  // Releases references to JS typed arrays shared with TF_Tensors. The
+  // queue, the pool and the arena outlive the backend, see ~TFJSBackend().
+  NapiRefReleaseQueue* ref_release_queue_;
+  AlignedBufferPool* aligned_buffer_pool_;
+  uint64_t num_misaligned_copies_;
+  // Uploads that needed no device copy, and device copies by device name.
+  uint64_t num_skipped_device_copies_;
+  std::map<std::string, DeviceCopyStats> device_copy_stats_;
+  TensorArena* tensor_arena_;
+  std::map<int32_t, PreparedOp> prepared_op_map_;
+  int32_t next_prepared_op_id_;
+  // Active graph capture and the context it records.
+  std::unique_ptr<GraphCapture> capture_;
+  ExecutionContext* capture_context_;
+  // Graph models and SavedModels, indexed by ID. Sessions are shared with
+  // batch schedulers, which keep them alive while a batch runs.
+  std::map<int32_t, std::shared_ptr<GraphSession>> graph_sessions_;
+  int32_t next_graph_session_id_;
+  // Batch schedulers of graph models, indexed by model ID.
+  std::map<int32_t, std::unique_ptr<BatchScheduler>> batch_schedulers_;
 };
 
 }  // namespace tfnodejs
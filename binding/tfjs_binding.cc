@@ -21,8 +21,6 @@
 
 namespace tfnodejs {
 
-TFJSBackend* gBackend = nullptr;
-
 static void AssignIntProperty(napi_env env, napi_value exports,
                               const char* name, int32_t value) {
   napi_value js_value;
@@ -36,6 +34,166 @@ static void AssignIntProperty(napi_env env, napi_value exports,
   ENSURE_NAPI_OK(env, nstatus);
 }
 
+static napi_value ConfigureContext(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Configure context takes 1 param: config object;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to configureContext()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_OBJECT_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->ConfigureContext(env, args[0]);
+  return js_this;
+}
+
+static napi_value CreateContext(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Create context takes 2 params: name, config object;
+  size_t argc = 2;
+  napi_value args[2];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 2) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to createContext()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_OBJECT_RETVAL(env, args[1], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->CreateContext(env, args[0], args[1]);
+}
+
+static napi_value SetContext(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Set context takes 1 param: context ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to setContext()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->SetContext(env, args[0]);
+  return js_this;
+}
+
+static napi_value ListDevices(napi_env env, napi_callback_info info) {
+  void* data;
+  napi_status nstatus =
+      napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ListDevices(env);
+}
+
+static napi_value SetDevice(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Set device takes 1 param: device name;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to setDevice()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->SetDevice(env, args[0]);
+  return js_this;
+}
+
+static napi_value Sync(napi_env env, napi_callback_info info) {
+  void* data;
+  napi_value js_this;
+  napi_status nstatus =
+      napi_get_cb_info(env, info, nullptr, nullptr, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->Sync(env);
+  return js_this;
+}
+
+static napi_value GetTensorShape(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Get tensor shape takes 1 param: tensor ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to getTensorShape()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetTensorShape(env, args[0]);
+}
+
+static napi_value GetTensorDevice(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Get tensor device takes 1 param: tensor ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to getTensorDevice()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetTensorDevice(env, args[0]);
+}
+
 static napi_value CreateTensor(napi_env env, napi_callback_info info) {
   napi_status nstatus;
 
@@ -43,7 +201,8 @@ static napi_value CreateTensor(napi_env env, napi_callback_info info) {
   size_t argc = 3;
   napi_value args[3];
   napi_value js_this;
-  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, nullptr);
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
   if (argc < 3) {
@@ -62,7 +221,8 @@ static napi_value CreateTensor(napi_env env, napi_callback_info info) {
     ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[2], nullptr);
   }
 
-  return gBackend->CreateTensor(env, args[0], args[1], args[2]);
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->CreateTensor(env, args[0], args[1], args[2]);
 }
 
 static napi_value DeleteTensor(napi_env env, napi_callback_info info) {
@@ -72,7 +232,8 @@ static napi_value DeleteTensor(napi_env env, napi_callback_info info) {
   size_t argc = 1;
   napi_value args[1];
   napi_value js_this;
-  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, nullptr);
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
 
   if (argc < 1) {
@@ -82,18 +243,453 @@ static napi_value DeleteTensor(napi_env env, napi_callback_info info) {
 
   ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
 
-  gBackend->DeleteTensor(env, args[0]);
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->DeleteTensor(env, args[0]);
   return js_this;
 }
 
-static napi_value TensorDataSync(napi_env env, napi_callback_info info) {
+static napi_value BeginCapture(napi_env env, napi_callback_info info) {
   napi_status nstatus;
 
-  // Tensor data-sync takes 1 param: tensor ID;
+  // Begin capture takes 1 param: input tensor IDs (Int32Array);
   size_t argc = 1;
   napi_value args[1];
   napi_value js_this;
-  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, nullptr);
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to beginCapture()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->BeginCapture(env, args[0]);
+  return js_this;
+}
+
+static napi_value EndCapture(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // End capture takes 2 params: function name, output tensor IDs
+  // (Int32Array);
+  size_t argc = 2;
+  napi_value args[2];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 2) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to endCapture()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[1], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->EndCapture(env, args[0], args[1]);
+}
+
+static napi_value CancelCapture(napi_env env, napi_callback_info info) {
+  void* data;
+  napi_value js_this;
+  napi_status nstatus =
+      napi_get_cb_info(env, info, nullptr, nullptr, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->CancelCapture(env);
+  return js_this;
+}
+
+static napi_value LoadGraphModel(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Load graph model takes 1 param: serialized GraphDef (Uint8Array);
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to loadGraphModel()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->LoadGraphModel(env, args[0]);
+}
+
+static napi_value RunGraphModel(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Run graph model takes 4 params: model ID, input names, input tensor IDs
+  // (Int32Array), output names;
+  size_t argc = 4;
+  napi_value args[4];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 4) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to runGraphModel()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[3], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->RunGraphModel(env, args[0], args[1], args[2], args[3]);
+}
+
+static napi_value LoadSavedModel(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Load SavedModel takes 2 params: export directory, tags;
+  size_t argc = 2;
+  napi_value args[2];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 2) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to loadSavedModel()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[1], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->LoadSavedModel(env, args[0], args[1]);
+}
+
+static napi_value RunSignature(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Run signature takes 5 params: model ID, signature key, input names, input
+  // tensor IDs (Int32Array), output names;
+  size_t argc = 5;
+  napi_value args[5];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 5) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to runSignature()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[3], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[4], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->RunSignature(env, args[0], args[1], args[2], args[3],
+                               args[4]);
+}
+
+static napi_value ConfigureBatching(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Configure batching takes 3 params: model ID, max batch size, batch
+  // timeout in microseconds;
+  size_t argc = 3;
+  napi_value args[3];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 3) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to configureBatching()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[1], js_this);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[2], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->ConfigureBatching(env, args[0], args[1], args[2]);
+  return js_this;
+}
+
+static napi_value RunGraphModelBatched(napi_env env,
+                                       napi_callback_info info) {
+  napi_status nstatus;
+
+  // Run graph model batched takes 4 params: model ID, input names, input
+  // tensor IDs (Int32Array), output names;
+  size_t argc = 4;
+  napi_value args[4];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 4) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to runGraphModelBatched()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[3], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->RunGraphModelBatched(env, args[0], args[1], args[2],
+                                       args[3]);
+}
+
+static napi_value GetBatchStats(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Get batch stats takes 1 param: model ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to getBatchStats()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetBatchStats(env, args[0]);
+}
+
+static napi_value DeleteGraphModel(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Delete graph model takes 1 param: model ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to deleteGraphModel()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->DeleteGraphModel(env, args[0]);
+  return js_this;
+}
+
+static napi_value DeleteTensors(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Delete tensors takes 1 param: tensor IDs (Int32Array);
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to deleteTensors()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->DeleteTensors(env, args[0]);
+  return js_this;
+}
+
+static napi_value GetStats(napi_env env, napi_callback_info info) {
+  void* data;
+  napi_status nstatus =
+      napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetStats(env);
+}
+
+static napi_value AllocAligned(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Alloc aligned takes 1 param: byte length;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to allocAligned()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->AllocAligned(env, args[0]);
+}
+
+static napi_value ConfigureTensorArena(napi_env env,
+                                       napi_callback_info info) {
+  napi_status nstatus;
+
+  // Configure tensor arena takes 2 params: max cached bytes, max buffers per
+  // key;
+  size_t argc = 2;
+  napi_value args[2];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 2) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to configureTensorArena()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[1], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->ConfigureTensorArena(env, args[0], args[1]);
+  return js_this;
+}
+
+static napi_value TrackTensor(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Track tensor takes 1 param: tensor ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to trackTensor()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->TrackTensor(env, args[0]);
+}
+
+static napi_value ExportTensor(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Export tensor takes 1 param: tensor ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to exportTensor()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ExportTensor(env, args[0]);
+}
+
+static napi_value ImportTensor(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Import tensor takes 1 param: export token;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to importTensor()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ImportTensor(env, args[0]);
+}
+
+static napi_value ReleaseTensorExport(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Release tensor export takes 1 param: export token;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to releaseTensorExport()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->ReleaseTensorExport(env, args[0]);
+  return js_this;
+}
+
+static napi_value TensorDataSync(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Tensor data-sync takes 1 param: tensor ID and an optional param: whether
+  // to share the tensor buffer instead of copying it;
+  size_t argc = 2;
+  napi_value args[2];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
 
   if (argc < 1) {
@@ -103,7 +699,60 @@ static napi_value TensorDataSync(napi_env env, napi_callback_info info) {
 
   ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
 
-  return gBackend->GetTensorData(env, args[0]);
+  bool share_buffer = false;
+  if (argc > 1) {
+    nstatus = napi_get_value_bool(env, args[1], &share_buffer);
+    ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+  }
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetTensorData(env, args[0], share_buffer);
+}
+
+static napi_value TensorDataInto(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Tensor data-into takes 3 params: tensor ID, target typed-array, offset;
+  size_t argc = 3;
+  napi_value args[3];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 3) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to tensorDataInto()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[2], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetTensorDataInto(env, args[0], args[1], args[2]);
+}
+
+static napi_value TensorDataAsync(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Tensor data-async takes 1 param: tensor ID;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to tensorDataAsync()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->GetTensorDataAsync(env, args[0]);
 }
 
 static napi_value ExecuteOp(napi_env env, napi_callback_info info) {
@@ -114,7 +763,8 @@ static napi_value ExecuteOp(napi_env env, napi_callback_info info) {
   size_t argc = 4;
   napi_value args[4];
   napi_value js_this;
-  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, nullptr);
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
 
   if (argc < 4) {
@@ -124,17 +774,185 @@ static napi_value ExecuteOp(napi_env env, napi_callback_info info) {
 
   ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
   ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[1], nullptr);
-  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_ARRAY_OR_TYPED_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[3], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ExecuteOp(env, args[0], args[1], args[2], args[3]);
+}
+
+static napi_value ExecuteOpAsync(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Execute op async takes 4 params: op-name, op-attrs, input-tensor-ids,
+  // num-outputs:
+  size_t argc = 4;
+  napi_value args[4];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 4) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to executeOpAsync()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_ARRAY_OR_TYPED_ARRAY_RETVAL(env, args[2], nullptr);
   ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[3], nullptr);
 
-  return gBackend->ExecuteOp(env, args[0], args[1], args[2], args[3]);
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ExecuteOpAsync(env, args[0], args[1], args[2], args[3]);
+}
+
+static napi_value ExecuteOpPacked(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Execute op packed takes 5 params: op-name, packed-op-attrs,
+  // input-tensor-ids, num-outputs, output-metadata:
+  size_t argc = 5;
+  napi_value args[5];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 5) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to executeOpPacked()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[3], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[4], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ExecuteOpPacked(env, args[0], args[1], args[2], args[3],
+                                  args[4]);
+}
+
+static napi_value ExecuteProgram(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Execute program takes 4 params: program, input-tensor-ids, output-refs,
+  // output-metadata:
+  size_t argc = 4;
+  napi_value args[4];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 4) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to executeProgram()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[2], nullptr);
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[3], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ExecuteProgram(env, args[0], args[1], args[2], args[3]);
+}
+
+static napi_value PrepareOp(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Prepare op takes 2 params: op-name, op-attrs:
+  size_t argc = 2;
+  napi_value args[2];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 2) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to prepareOp()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_STRING_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_ARRAY_RETVAL(env, args[1], nullptr);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->PrepareOp(env, args[0], args[1]);
+}
+
+static napi_value ExecutePrepared(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Execute prepared takes 3 params: prepared-op-id, input-tensor-ids,
+  // num-outputs and an optional 4th param: output-metadata:
+  size_t argc = 4;
+  napi_value args[4];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, nullptr);
+
+  if (argc < 3) {
+    NAPI_THROW_ERROR(env, "Invalid number of args passed to executePrepared()");
+    return nullptr;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], nullptr);
+  ENSURE_VALUE_IS_ARRAY_OR_TYPED_ARRAY_RETVAL(env, args[1], nullptr);
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[2], nullptr);
+
+  napi_value output_metadata = nullptr;
+  if (argc > 3) {
+    ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, args[3], nullptr);
+    output_metadata = args[3];
+  }
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  return backend->ExecutePrepared(env, args[0], args[1], args[2],
+                                  output_metadata);
+}
+
+static napi_value ReleasePreparedOp(napi_env env, napi_callback_info info) {
+  napi_status nstatus;
+
+  // Release prepared op takes 1 param: prepared-op-id;
+  size_t argc = 1;
+  napi_value args[1];
+  napi_value js_this;
+  void* data;
+  nstatus = napi_get_cb_info(env, info, &argc, args, &js_this, &data);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, js_this);
+
+  if (argc < 1) {
+    NAPI_THROW_ERROR(env,
+                     "Invalid number of args passed to releasePreparedOp()");
+    return js_this;
+  }
+
+  ENSURE_VALUE_IS_NUMBER_RETVAL(env, args[0], js_this);
+
+  TFJSBackend* backend = static_cast<TFJSBackend*>(data);
+  backend->ReleasePreparedOp(env, args[0]);
+  return js_this;
 }
 
 static napi_value InitTFNodeJSBinding(napi_env env, napi_value exports) {
   napi_status nstatus;
 
-  gBackend = TFJSBackend::Create(env);
-  ENSURE_VALUE_IS_NOT_NULL_RETVAL(env, gBackend, nullptr);
+  // Every env (the main thread and each worker thread) loading the addon gets
+  // its own backend. It is handed to the binding functions as callback data
+  // and deleted when the env is torn down.
+  TFJSBackend* backend = TFJSBackend::Create(env);
+  ENSURE_VALUE_IS_NOT_NULL_RETVAL(env, backend, nullptr);
+  nstatus = napi_add_env_cleanup_hook(env, TFJSBackend::Destroy, backend);
+  if (nstatus != napi_ok) {
+    TFJSBackend::Destroy(backend);
+  }
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, exports);
 
   // TF version
   napi_value tf_version;
@@ -143,17 +961,90 @@ static napi_value InitTFNodeJSBinding(napi_env env, napi_value exports) {
 
   // Set all export values list here.
   napi_property_descriptor exports_properties[] = {
+      {"configureContext", nullptr, ConfigureContext, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
+      {"createContext", nullptr, CreateContext, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"setContext", nullptr, SetContext, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"listDevices", nullptr, ListDevices, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"setDevice", nullptr, SetDevice, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"getTensorDevice", nullptr, GetTensorDevice, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"sync", nullptr, Sync, nullptr, nullptr, nullptr, napi_default,
+       nullptr},
+      {"getTensorShape", nullptr, GetTensorShape, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
       {"createTensor", nullptr, CreateTensor, nullptr, nullptr, nullptr,
        napi_default, nullptr},
       {"deleteTensor", nullptr, DeleteTensor, nullptr, nullptr, nullptr,
        napi_default, nullptr},
+      {"deleteTensors", nullptr, DeleteTensors, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"getStats", nullptr, GetStats, nullptr, nullptr, nullptr, napi_default,
+       nullptr},
+      {"allocAligned", nullptr, AllocAligned, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"configureTensorArena", nullptr, ConfigureTensorArena, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
+      {"trackTensor", nullptr, TrackTensor, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"exportTensor", nullptr, ExportTensor, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"importTensor", nullptr, ImportTensor, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"releaseTensorExport", nullptr, ReleaseTensorExport, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
       {"tensorDataSync", nullptr, TensorDataSync, nullptr, nullptr, nullptr,
        napi_default, nullptr},
+      {"tensorDataInto", nullptr, TensorDataInto, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"tensorDataAsync", nullptr, TensorDataAsync, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
       {"executeOp", nullptr, ExecuteOp, nullptr, nullptr, nullptr, napi_default,
        nullptr},
+      {"executeOpAsync", nullptr, ExecuteOpAsync, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"executeOpPacked", nullptr, ExecuteOpPacked, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"executeProgram", nullptr, ExecuteProgram, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"prepareOp", nullptr, PrepareOp, nullptr, nullptr, nullptr, napi_default,
+       nullptr},
+      {"executePrepared", nullptr, ExecutePrepared, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"releasePreparedOp", nullptr, ReleasePreparedOp, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
+      {"beginCapture", nullptr, BeginCapture, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"endCapture", nullptr, EndCapture, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"cancelCapture", nullptr, CancelCapture, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"loadGraphModel", nullptr, LoadGraphModel, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"runGraphModel", nullptr, RunGraphModel, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"loadSavedModel", nullptr, LoadSavedModel, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"runSignature", nullptr, RunSignature, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"configureBatching", nullptr, ConfigureBatching, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
+      {"runGraphModelBatched", nullptr, RunGraphModelBatched, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
+      {"getBatchStats", nullptr, GetBatchStats, nullptr, nullptr, nullptr,
+       napi_default, nullptr},
+      {"deleteGraphModel", nullptr, DeleteGraphModel, nullptr, nullptr,
+       nullptr, napi_default, nullptr},
       {"TF_Version", nullptr, nullptr, nullptr, nullptr, tf_version,
        napi_default, nullptr},
   };
+  for (size_t i = 0; i < ARRAY_SIZE(exports_properties); i++) {
+    exports_properties[i].data = backend;
+  }
   nstatus = napi_define_properties(env, exports, ARRAY_SIZE(exports_properties),
                                    exports_properties);
   ENSURE_NAPI_OK_RETVAL(env, nstatus, exports);
@@ -21,7 +21,9 @@
 #include <node_api.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <cstdio>
 #include <cstdlib>
+#include <string>
 #include <vector>
 #include "tensorflow/c/c_api.h"
 #include "tf_auto_status.h"
@@ -185,6 +187,28 @@ inline bool EnsureValueIsTypedArray(napi_env env, napi_value value,
   return is_array;
 }
 
+#define ENSURE_VALUE_IS_ARRAY_OR_TYPED_ARRAY(env, value) \
+  if (!EnsureValueIsArrayOrTypedArray(env, value, __FILE__, __LINE__)) return;
+#define ENSURE_VALUE_IS_ARRAY_OR_TYPED_ARRAY_RETVAL(env, value, retval) \
+  if (!EnsureValueIsArrayOrTypedArray(env, value, __FILE__, __LINE__))  \
+    return retval;
+
+inline bool EnsureValueIsArrayOrTypedArray(napi_env env, napi_value value,
+                                           const char* file,
+                                           const size_t line_number) {
+  bool is_array;
+  ENSURE_NAPI_OK_RETVAL(env, napi_is_array(env, value, &is_array), false);
+  if (!is_array) {
+    ENSURE_NAPI_OK_RETVAL(env, napi_is_typedarray(env, value, &is_array),
+                          false);
+  }
+  if (!is_array) {
+    NapiThrowError(env, file, line_number,
+                   "Argument is not an array or typed-array!");
+  }
+  return is_array;
+}
+
 #define ENSURE_VALUE_IS_LESS_THAN(env, value, max) \
   if (!EnsureValueIsLessThan(env, value, max, __FILE__, __LINE__)) return;
 #define ENSURE_VALUE_IS_LESS_THAN_RETVAL(env, value, max, retval)  \
@@ -296,6 +320,27 @@ inline napi_status GetStringParam(napi_env env, napi_value string_value,
   return napi_ok;
 }
 
+// Returns the data pointer and element length of a typed-array, ensuring the
+// array is of the expected type.
+inline bool GetTypedArrayData(napi_env env, napi_value typed_array_value,
+                              napi_typedarray_type expected_type, void** data,
+                              size_t* length) {
+  ENSURE_VALUE_IS_TYPED_ARRAY_RETVAL(env, typed_array_value, false);
+
+  napi_typedarray_type array_type;
+  napi_status nstatus =
+      napi_get_typedarray_info(env, typed_array_value, &array_type, length,
+                               data, nullptr, nullptr);
+  ENSURE_NAPI_OK_RETVAL(env, nstatus, false);
+
+  if (array_type != expected_type) {
+    NAPI_THROW_ERROR(env, "Unexpected typed-array type: %u (expected %u)",
+                     array_type, expected_type);
+    return false;
+  }
+  return true;
+}
+
 // Returns the number of elements in a Tensor.
 inline size_t GetTensorNumElements(TF_Tensor* tensor) {
   size_t ret = 1;
@@ -0,0 +1,71 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import {NodeJSKernelBackend} from './nodejs_kernel_backend';
+import {ensureTensorflowBackend, nodeBackend} from './ops/op_utils';
+import {ContextConfig} from './tfjs_binding';
+
+// tslint:disable-next-line:no-require-imports
+const pjson = require('../package.json');
+
+/**
+ * Configures the thread pools and placement of the TensorFlow context.
+ *
+ * The context is created when the first tensor is created or the first Op
+ * runs, so this must be called before any tensor work. Options that are not
+ * given fall back to the `TFJS_INTRA_OP_PARALLELISM_THREADS`,
+ * `TFJS_INTER_OP_PARALLELISM_THREADS`, `TFJS_ALLOW_SOFT_PLACEMENT`,
+ * `TFJS_SHARE_CONTEXT` and `TFJS_ASYNC_EXECUTION` environment variables, then
+ * to the TensorFlow defaults.
+ *
+ * With `asyncExecution`, Ops are only enqueued so that long chains of Ops
+ * pipeline instead of waiting for each kernel. Reading tensor data or calling
+ * `sync()` on the backend waits for them, and errors of enqueued Ops surface
+ * there.
+ *
+ * Every worker thread that loads tfjs-node has its own context. Set
+ * `shareContext` in each worker to run them all on one process-wide context
+ * instead, e.g. to size a single set of thread pools for the whole process.
+ * All of them must pass the same options.
+ *
+ * @param config The context options.
+ */
+export function configureContext(config: ContextConfig): void {
+  ensureTensorflowBackend();
+  nodeBackend().binding.configureContext(config);
+}
+
+/**
+ * Creates a backend whose tensors and Ops live in a separate TensorFlow
+ * context with its own thread pools.
+ *
+ * Register the returned backend with `tf.registerBackend()` and make it
+ * current with `tf.setBackend()` to run a model in isolation from models on
+ * other backends, e.g. to keep a latency critical model from being starved by
+ * a heavy one.
+ *
+ * @param name Unique name of the context.
+ * @param config The context options. Options that are not given fall back to
+ *     the environment variables read by `configureContext()`.
+ */
+export function createContextBackend(
+    name: string, config: ContextConfig = {}): NodeJSKernelBackend {
+  ensureTensorflowBackend();
+  const backend = nodeBackend();
+  const contextId = backend.binding.createContext(name, config);
+  return new NodeJSKernelBackend(backend.binding, pjson.name, contextId);
+}
@@ -0,0 +1,66 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import * as tf from './index';
+
+describe('configureContext', () => {
+  it('throws once the context is created', () => {
+    tf.scalar(1).dispose();
+    expect(() => tf.node.configureContext({intraOpParallelismThreads: 1}))
+        .toThrowError(/already created/);
+  });
+});
+
+describe('createContextBackend', () => {
+  it('runs Ops in a separate context', () => {
+    const backend = tf.node.createContextBackend('context_test');
+    tf.registerBackend('tensorflow-context-test', () => backend);
+    const previousBackend = tf.getBackend();
+    try {
+      tf.setBackend('tensorflow-context-test');
+      const result = tf.add(tf.tensor1d([1, 2]), tf.tensor1d([3, 4]));
+      expect(tf.backend()).toBe(backend);
+      expect(Array.from(result.dataSync())).toEqual([4, 6]);
+    } finally {
+      tf.setBackend(previousBackend);
+      tf.removeBackend('tensorflow-context-test');
+    }
+  });
+
+  it('runs Ops asynchronously', () => {
+    const backend = tf.node.createContextBackend(
+        'context_test_async', {asyncExecution: true});
+    tf.registerBackend('tensorflow-context-test-async', () => backend);
+    const previousBackend = tf.getBackend();
+    try {
+      tf.setBackend('tensorflow-context-test-async');
+      const result = tf.exp(tf.neg(tf.tensor2d([0, 0], [1, 2])));
+      expect(result.shape).toEqual([1, 2]);
+      backend.sync();
+      expect(Array.from(result.dataSync())).toEqual([1, 1]);
+    } finally {
+      tf.setBackend(previousBackend);
+      tf.removeBackend('tensorflow-context-test-async');
+    }
+  });
+
+  it('rejects duplicate context names', () => {
+    tf.node.createContextBackend('context_test_duplicate');
+    expect(() => tf.node.createContextBackend('context_test_duplicate'))
+        .toThrowError(/already exists/);
+  });
+});
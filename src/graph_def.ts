@@ -0,0 +1,478 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+/**
+ * Serializes the JSON GraphDef of a tfjs-converter `model.json` back into a
+ * binary tensorflow.GraphDef protocol buffer. The JSON follows the protobuf
+ * JSON mapping: camelCase field names, int64 values as strings, bytes as
+ * base64 and enums by name.
+ */
+
+import {NamedTensorMap, Tensor} from '@tensorflow/tfjs-core';
+
+export declare interface TensorShapeJSON {
+  dim?: Array<{size?: string|number, name?: string}>;
+  unknownRank?: boolean;
+}
+
+export declare interface TensorJSON {
+  dtype?: string|number;
+  tensorShape?: TensorShapeJSON;
+  versionNumber?: number;
+  tensorContent?: string;
+  halfVal?: number[];
+  floatVal?: Array<number|string>;
+  doubleVal?: Array<number|string>;
+  intVal?: number[];
+  stringVal?: string[];
+  scomplexVal?: Array<number|string>;
+  int64Val?: Array<string|number>;
+  boolVal?: boolean[];
+  dcomplexVal?: Array<number|string>;
+  uint32Val?: number[];
+  uint64Val?: Array<string|number>;
+}
+
+export declare interface NameAttrListJSON {
+  name?: string;
+  attr?: {[key: string]: AttrValueJSON};
+}
+
+export declare interface ListValueJSON {
+  s?: string[];
+  i?: Array<string|number>;
+  f?: Array<number|string>;
+  b?: boolean[];
+  type?: Array<string|number>;
+  shape?: TensorShapeJSON[];
+  tensor?: TensorJSON[];
+  func?: NameAttrListJSON[];
+}
+
+export declare interface AttrValueJSON {
+  list?: ListValueJSON;
+  s?: string;
+  i?: string|number;
+  f?: number|string;
+  b?: boolean;
+  type?: string|number;
+  shape?: TensorShapeJSON;
+  tensor?: TensorJSON;
+  placeholder?: string;
+  func?: NameAttrListJSON;
+}
+
+export declare interface NodeDefJSON {
+  name: string;
+  op: string;
+  input?: string[];
+  device?: string;
+  attr?: {[key: string]: AttrValueJSON};
+}
+
+export declare interface GraphDefJSON {
+  node?: NodeDefJSON[];
+  versions?: {producer?: number, minConsumer?: number, badConsumers?: number[]};
+  library?: {function?: object[], gradient?: object[]};
+}
+
+// Values of the tensorflow.DataType enum.
+const DATA_TYPES: {[name: string]: number} = {
+  'DT_FLOAT': 1,
+  'DT_DOUBLE': 2,
+  'DT_INT32': 3,
+  'DT_UINT8': 4,
+  'DT_INT16': 5,
+  'DT_INT8': 6,
+  'DT_STRING': 7,
+  'DT_COMPLEX64': 8,
+  'DT_INT64': 9,
+  'DT_BOOL': 10,
+  'DT_QINT8': 11,
+  'DT_QUINT8': 12,
+  'DT_QINT32': 13,
+  'DT_BFLOAT16': 14,
+  'DT_QINT16': 15,
+  'DT_QUINT16': 16,
+  'DT_UINT16': 17,
+  'DT_COMPLEX128': 18,
+  'DT_HALF': 19,
+  'DT_RESOURCE': 20,
+  'DT_VARIANT': 21,
+  'DT_UINT32': 22,
+  'DT_UINT64': 23
+};
+
+const WIRE_TYPE_VARINT = 0;
+const WIRE_TYPE_64BIT = 1;
+const WIRE_TYPE_LENGTH_DELIMITED = 2;
+const WIRE_TYPE_32BIT = 5;
+
+/**
+ * Writes a protocol buffer message. Bytes fields and nested messages are kept
+ * by reference, so large tensor contents are only copied once by `finish()`.
+ */
+export class ProtoWriter {
+  private chunks: Uint8Array[] = [];
+  private chunkBytes = 0;
+  private pending: number[] = [];
+  private scratch = new DataView(new ArrayBuffer(8));
+
+  varint(field: number, value: number) {
+    this.tag(field, WIRE_TYPE_VARINT);
+    this.rawVarint(value);
+  }
+
+  bool(field: number, value: boolean) {
+    this.varint(field, value ? 1 : 0);
+  }
+
+  float(field: number, value: number) {
+    this.tag(field, WIRE_TYPE_32BIT);
+    this.rawFloat(value);
+  }
+
+  double(field: number, value: number) {
+    this.tag(field, WIRE_TYPE_64BIT);
+    this.rawDouble(value);
+  }
+
+  bytes(field: number, value: Uint8Array) {
+    this.tag(field, WIRE_TYPE_LENGTH_DELIMITED);
+    this.rawVarint(value.length);
+    this.flushPending();
+    this.chunks.push(value);
+    this.chunkBytes += value.length;
+  }
+
+  string(field: number, value: string) {
+    this.bytes(field, Buffer.from(value, 'utf8'));
+  }
+
+  message(field: number, write: (writer: ProtoWriter) => void) {
+    const child = new ProtoWriter();
+    write(child);
+    child.flushPending();
+    this.tag(field, WIRE_TYPE_LENGTH_DELIMITED);
+    this.rawVarint(child.chunkBytes);
+    this.flushPending();
+    this.chunks.push(...child.chunks);
+    this.chunkBytes += child.chunkBytes;
+  }
+
+  packedVarints(field: number, values: number[]) {
+    if (values.length > 0) {
+      this.message(field, w => values.forEach(value => w.rawVarint(value)));
+    }
+  }
+
+  packedFloats(field: number, values: number[]) {
+    if (values.length > 0) {
+      this.message(field, w => values.forEach(value => w.rawFloat(value)));
+    }
+  }
+
+  packedDoubles(field: number, values: number[]) {
+    if (values.length > 0) {
+      this.message(field, w => values.forEach(value => w.rawDouble(value)));
+    }
+  }
+
+  finish(): Uint8Array {
+    this.flushPending();
+    const bytes = new Uint8Array(this.chunkBytes);
+    let offset = 0;
+    for (let i = 0; i < this.chunks.length; i++) {
+      bytes.set(this.chunks[i], offset);
+      offset += this.chunks[i].length;
+    }
+    return bytes;
+  }
+
+  private tag(field: number, wireType: number) {
+    this.rawVarint(field * 8 + wireType);
+  }
+
+  // Negative values are written as 64-bit two's complement, like protobuf
+  // does for int32 and int64 fields.
+  private rawVarint(value: number) {
+    let high = Math.floor(value / 4294967296);
+    let low = value - high * 4294967296;
+    high = high >>> 0;
+    while (high > 0 || low > 127) {
+      this.pending.push((low & 0x7f) | 0x80);
+      low = ((low >>> 7) | (high << 25)) >>> 0;
+      high = high >>> 7;
+    }
+    this.pending.push(low);
+  }
+
+  private rawFloat(value: number) {
+    this.scratch.setFloat32(0, value, true);
+    for (let i = 0; i < 4; i++) {
+      this.pending.push(this.scratch.getUint8(i));
+    }
+  }
+
+  private rawDouble(value: number) {
+    this.scratch.setFloat64(0, value, true);
+    for (let i = 0; i < 8; i++) {
+      this.pending.push(this.scratch.getUint8(i));
+    }
+  }
+
+  private flushPending() {
+    if (this.pending.length > 0) {
+      this.chunks.push(new Uint8Array(this.pending));
+      this.chunkBytes += this.pending.length;
+      this.pending = [];
+    }
+  }
+}
+
+/** Returns the tensorflow.DataType enum value of a JSON dtype. */
+export function getDataTypeEnum(type: string|number): number {
+  if (typeof type === 'number') {
+    return type;
+  }
+  if (!(type in DATA_TYPES)) {
+    throw new Error(`Unknown TensorFlow dtype ${type}`);
+  }
+  return DATA_TYPES[type];
+}
+
+function base64(value: string): Uint8Array {
+  return Buffer.from(value, 'base64');
+}
+
+function writeTensorShape(w: ProtoWriter, shape: TensorShapeJSON) {
+  (shape.dim || []).forEach(dim => w.message(2, d => {
+    if (dim.size != null) {
+      d.varint(1, Number(dim.size));
+    }
+    if (dim.name != null) {
+      d.string(2, dim.name);
+    }
+  }));
+  if (shape.unknownRank) {
+    w.bool(3, true);
+  }
+}
+
+function writeTensor(w: ProtoWriter, tensor: TensorJSON) {
+  if (tensor.dtype != null) {
+    w.varint(1, getDataTypeEnum(tensor.dtype));
+  }
+  if (tensor.tensorShape != null) {
+    w.message(2, s => writeTensorShape(s, tensor.tensorShape));
+  }
+  if (tensor.versionNumber != null) {
+    w.varint(3, tensor.versionNumber);
+  }
+  if (tensor.tensorContent != null) {
+    w.bytes(4, base64(tensor.tensorContent));
+  }
+  w.packedFloats(5, (tensor.floatVal || []).map(Number));
+  w.packedDoubles(6, (tensor.doubleVal || []).map(Number));
+  w.packedVarints(7, tensor.intVal || []);
+  (tensor.stringVal || []).forEach(value => w.bytes(8, base64(value)));
+  w.packedFloats(9, (tensor.scomplexVal || []).map(Number));
+  w.packedVarints(10, (tensor.int64Val || []).map(Number));
+  w.packedVarints(11, (tensor.boolVal || []).map(Number));
+  w.packedDoubles(12, (tensor.dcomplexVal || []).map(Number));
+  w.packedVarints(13, tensor.halfVal || []);
+  w.packedVarints(16, tensor.uint32Val || []);
+  w.packedVarints(17, (tensor.uint64Val || []).map(Number));
+}
+
+function writeNameAttrList(w: ProtoWriter, func: NameAttrListJSON) {
+  if (func.name != null) {
+    w.string(1, func.name);
+  }
+  writeAttrMap(w, 2, func.attr);
+}
+
+function writeListValue(w: ProtoWriter, list: ListValueJSON) {
+  (list.s || []).forEach(value => w.bytes(2, base64(value)));
+  w.packedVarints(3, (list.i || []).map(Number));
+  w.packedFloats(4, (list.f || []).map(Number));
+  w.packedVarints(5, (list.b || []).map(Number));
+  w.packedVarints(6, (list.type || []).map(getDataTypeEnum));
+  (list.shape || []).forEach(shape => w.message(7, s => {
+    writeTensorShape(s, shape);
+  }));
+  (list.tensor || []).forEach(tensor => w.message(8, t => {
+    writeTensor(t, tensor);
+  }));
+  (list.func || []).forEach(func => w.message(9, f => {
+    writeNameAttrList(f, func);
+  }));
+}
+
+// AttrValue is a oneof, so a set field is written even if it holds its
+// default value.
+function writeAttrValue(w: ProtoWriter, attr: AttrValueJSON) {
+  if (attr.list != null) {
+    w.message(1, l => writeListValue(l, attr.list));
+  } else if (attr.s != null) {
+    w.bytes(2, base64(attr.s));
+  } else if (attr.i != null) {
+    w.varint(3, Number(attr.i));
+  } else if (attr.f != null) {
+    w.float(4, Number(attr.f));
+  } else if (attr.b != null) {
+    w.bool(5, attr.b);
+  } else if (attr.type != null) {
+    w.varint(6, getDataTypeEnum(attr.type));
+  } else if (attr.shape != null) {
+    w.message(7, s => writeTensorShape(s, attr.shape));
+  } else if (attr.tensor != null) {
+    w.message(8, t => writeTensor(t, attr.tensor));
+  } else if (attr.placeholder != null) {
+    w.string(9, attr.placeholder);
+  } else if (attr.func != null) {
+    w.message(10, f => writeNameAttrList(f, attr.func));
+  }
+}
+
+function writeAttrMap(
+    w: ProtoWriter, field: number, attrs: {[key: string]: AttrValueJSON}) {
+  for (const key in attrs) {
+    w.message(field, entry => {
+      entry.string(1, key);
+      entry.message(2, value => writeAttrValue(value, attrs[key]));
+    });
+  }
+}
+
+// Returns the little-endian tensor_content bytes of a weight for a dtype.
+function getWeightContent(
+    name: string, dtype: number, weight: Tensor): Uint8Array {
+  const values = weight.dataSync() as ArrayLike<number>;
+  let typedArray: ArrayBufferView;
+  switch (dtype) {
+    case DATA_TYPES['DT_FLOAT']:
+      typedArray = values instanceof Float32Array ? values :
+                                                    new Float32Array(values);
+      break;
+    case DATA_TYPES['DT_DOUBLE']:
+      typedArray = new Float64Array(values);
+      break;
+    case DATA_TYPES['DT_INT32']:
+      typedArray =
+          values instanceof Int32Array ? values : new Int32Array(values);
+      break;
+    case DATA_TYPES['DT_INT16']:
+      typedArray = new Int16Array(values);
+      break;
+    case DATA_TYPES['DT_INT8']:
+      typedArray = new Int8Array(values);
+      break;
+    case DATA_TYPES['DT_UINT16']:
+      typedArray = new Uint16Array(values);
+      break;
+    case DATA_TYPES['DT_UINT8']:
+    case DATA_TYPES['DT_BOOL']:
+      typedArray = new Uint8Array(values);
+      break;
+    case DATA_TYPES['DT_INT64']: {
+      // The converter stores int64 weights as int32, so each value is sign
+      // extended into a low and a high word.
+      const words = new Int32Array(values.length * 2);
+      for (let i = 0; i < values.length; i++) {
+        words[2 * i] = values[i];
+        words[2 * i + 1] = values[i] < 0 ? -1 : 0;
+      }
+      typedArray = words;
+      break;
+    }
+    default:
+      throw new Error(`Unsupported dtype ${dtype} of weight ${name}`);
+  }
+  return new Uint8Array(
+      typedArray.buffer, typedArray.byteOffset, typedArray.byteLength);
+}
+
+// Writes a weight as the value of its Const node.
+function writeWeight(w: ProtoWriter, node: NodeDefJSON, weight: Tensor) {
+  const dtypeAttr = node.attr != null ? node.attr['dtype'] : null;
+  if (dtypeAttr == null || dtypeAttr.type == null) {
+    throw new Error(`Const node ${node.name} has no dtype`);
+  }
+  const dtype = getDataTypeEnum(dtypeAttr.type);
+  w.varint(1, dtype);
+  w.message(2, s => weight.shape.forEach(size => s.message(2, d => {
+    d.varint(1, size);
+  })));
+  w.bytes(4, getWeightContent(node.name, dtype, weight));
+}
+
+function writeNodeDef(
+    w: ProtoWriter, node: NodeDefJSON, weights: NamedTensorMap) {
+  w.string(1, node.name);
+  w.string(2, node.op);
+  (node.input || []).forEach(input => w.string(3, input));
+  // The device of the converted graph is dropped, nodes are placed on the
+  // devices of the session instead.
+  const weight = node.op === 'Const' ? weights[node.name] : null;
+  const attrs = {...node.attr};
+  if (weight != null) {
+    delete attrs['value'];
+  }
+  writeAttrMap(w, 5, attrs);
+  if (weight != null) {
+    w.message(5, entry => {
+      entry.string(1, 'value');
+      entry.message(2, value => value.message(8, tensor => {
+        writeWeight(tensor, node, weight);
+      }));
+    });
+  }
+}
+
+/**
+ * Encodes a JSON GraphDef into a binary tensorflow.GraphDef. The values of
+ * Const nodes that have a weight of the same name are taken from `weights`,
+ * since the converter moves them out of the graph.
+ */
+export function encodeGraphDef(
+    graph: GraphDefJSON, weights: NamedTensorMap): Uint8Array {
+  const library = graph.library;
+  if (library != null &&
+      ((library.function || []).length > 0 ||
+       (library.gradient || []).length > 0)) {
+    throw new Error('GraphDefs with a function library are not supported');
+  }
+
+  const w = new ProtoWriter();
+  (graph.node || []).forEach(node => w.message(1, n => {
+    writeNodeDef(n, node, weights);
+  }));
+  const versions = graph.versions;
+  if (versions != null) {
+    w.message(4, v => {
+      if (versions.producer != null) {
+        v.varint(1, versions.producer);
+      }
+      if (versions.minConsumer != null) {
+        v.varint(2, versions.minConsumer);
+      }
+      v.packedVarints(3, versions.badConsumers || []);
+    });
+  }
+  return w.finish();
+}
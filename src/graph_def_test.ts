@@ -0,0 +1,57 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import {encodeGraphDef, getDataTypeEnum, ProtoWriter} from './graph_def';
+
+describe('encodeGraphDef', () => {
+  it('writes varints like protobuf', () => {
+    const w = new ProtoWriter();
+    w.varint(1, 300);
+    w.varint(2, -1);
+    expect(Array.from(w.finish())).toEqual([
+      0x08, 0xac, 0x02, 0x10, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+      0xff, 0x01
+    ]);
+  });
+
+  it('encodes nodes and attributes', () => {
+    const bytes = encodeGraphDef(
+        {node: [{name: 'a', op: 'NoOp', attr: {T: {type: 'DT_INT32'}}}]}, {});
+    // NodeDef {name: 'a', op: 'NoOp', attr {key: 'T', value {type: 3}}}.
+    expect(Array.from(bytes)).toEqual([
+      0x0a, 0x12, 0x0a, 0x01, 0x61, 0x12, 0x04, 0x4e, 0x6f, 0x4f, 0x70, 0x2a,
+      0x07, 0x0a, 0x01, 0x54, 0x12, 0x02, 0x30, 0x03
+    ]);
+  });
+
+  it('writes set oneof fields with default values', () => {
+    const bytes = encodeGraphDef(
+        {node: [{name: 'a', op: 'NoOp', attr: {b: {b: false}}}]}, {});
+    expect(Array.from(bytes.slice(bytes.length - 2))).toEqual([0x28, 0x00]);
+  });
+
+  it('rejects function libraries', () => {
+    expect(() => encodeGraphDef({library: {function: [{}]}}, {}))
+        .toThrowError(/function library/);
+  });
+
+  it('maps dtype names', () => {
+    expect(getDataTypeEnum('DT_FLOAT')).toBe(1);
+    expect(getDataTypeEnum(9)).toBe(9);
+    expect(() => getDataTypeEnum('DT_BOGUS')).toThrowError(/DT_BOGUS/);
+  });
+});
@@ -0,0 +1,263 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import * as tfc from '@tensorflow/tfjs-core';
+import {NamedTensorMap, Tensor} from '@tensorflow/tfjs-core';
+
+import {encodeGraphDef, GraphDefJSON, NodeDefJSON} from './graph_def';
+import {NodeFileSystem, nodeFileSystemRouter} from './io/file_system';
+import {NodeJSKernelBackend} from './nodejs_kernel_backend';
+import {ensureTensorflowBackend, nodeBackend} from './ops/op_utils';
+import {BatchStats} from './tfjs_binding';
+
+const DEFAULT_BATCH_TIMEOUT_MICROS = 1000;
+
+// Ops whose nodes are never model outputs, even if no node consumes them.
+const NON_OUTPUT_OPS = ['Const', 'NoOp', 'Placeholder'];
+
+// Returns the node name of a node input such as `^node` or `node:1`.
+function getInputNodeName(input: string): string {
+  const name = input.charAt(0) === '^' ? input.slice(1) : input;
+  const colon = name.lastIndexOf(':');
+  return colon >= 0 && /^\d+$/.test(name.slice(colon + 1)) ?
+      name.slice(0, colon) :
+      name;
+}
+
+/** Options of the native batching of `NativeGraphModel.executeAsync()`. */
+export declare interface BatchingOptions {
+  /** Rows of a batch, summed over the first dimension of the inputs. */
+  maxBatchSize: number;
+  /**
+   * How long the oldest queued call waits for a batch to fill, in
+   * microseconds. Defaults to 1000. The wait is timed by the event loop and
+   * rounds up to whole milliseconds.
+   */
+  batchTimeoutMicros?: number;
+}
+
+/**
+ * A tfjs-converter GraphModel that runs as one TensorFlow graph in a native
+ * session, instead of node by node from JS. TensorFlow optimizes the whole
+ * graph when it is first run, e.g. by folding constants.
+ */
+export class NativeGraphModel {
+  private disposed = false;
+
+  constructor(
+      private readonly backend: NodeJSKernelBackend,
+      private readonly modelId: number,
+      /** Names of the Placeholder nodes that `predict()` feeds. */
+      readonly inputNodes: string[],
+      /** Names of the nodes that no other node consumes. */
+      readonly outputNodes: string[]) {}
+
+  /**
+   * Runs the model and returns the values of `outputNodes`.
+   *
+   * @param inputs A tensor or an array of tensors in the order of
+   *   `inputNodes`, or a map from input tensor names to tensors.
+   */
+  predict(inputs: Tensor|Tensor[]|NamedTensorMap): Tensor|Tensor[] {
+    return this.execute(inputs);
+  }
+
+  /**
+   * Runs the model and returns the values of the named tensors.
+   *
+   * @param inputs A tensor or an array of tensors in the order of
+   *   `inputNodes`, or a map from input tensor names to tensors.
+   * @param outputs Names of the tensors to fetch, as `node` or `node:index`.
+   *   Defaults to `outputNodes`.
+   */
+  execute(
+      inputs: Tensor|Tensor[]|NamedTensorMap,
+      outputs?: string|string[]): Tensor|Tensor[] {
+    if (this.disposed) {
+      throw new Error('Cannot execute a disposed graph model');
+    }
+    const inputMap = this.getInputMap(inputs);
+    const inputNames = Object.keys(inputMap);
+    const outputNames = this.getOutputNames(outputs);
+    const result = this.backend.runGraphModel(
+        this.modelId, inputNames, inputNames.map(name => inputMap[name]),
+        outputNames);
+    const returnsArray =
+        Array.isArray(outputs) || (outputs == null && result.length !== 1);
+    return returnsArray ? result : result[0];
+  }
+
+  /**
+   * Batches concurrent `executeAsync()` and `predictAsync()` calls natively.
+   * Calls with the same input and output names, dtypes and trailing input
+   * dimensions have their inputs concatenated along the first dimension and
+   * run as one session call, and the outputs are split back per call. Every
+   * output must therefore keep the batch as its first dimension.
+   *
+   * ```js
+   * model.enableBatching({maxBatchSize: 32, batchTimeoutMicros: 2000});
+   * const outputs = await Promise.all(
+   *     requests.map(x => model.predictAsync(x)));
+   * ```
+   */
+  enableBatching(options: BatchingOptions): void {
+    const timeoutMicros = options.batchTimeoutMicros == null ?
+        DEFAULT_BATCH_TIMEOUT_MICROS :
+        options.batchTimeoutMicros;
+    this.backend.configureBatching(
+        this.modelId, options.maxBatchSize, timeoutMicros);
+  }
+
+  /**
+   * Runs the model on a worker thread like `predict()`, batched with
+   * concurrent calls if `enableBatching()` was called.
+   */
+  predictAsync(inputs: Tensor|Tensor[]|NamedTensorMap):
+      Promise<Tensor|Tensor[]> {
+    return this.executeAsync(inputs);
+  }
+
+  /**
+   * Runs the model on a worker thread like `execute()`, batched with
+   * concurrent calls if `enableBatching()` was called.
+   */
+  async executeAsync(
+      inputs: Tensor|Tensor[]|NamedTensorMap,
+      outputs?: string|string[]): Promise<Tensor|Tensor[]> {
+    if (this.disposed) {
+      throw new Error('Cannot execute a disposed graph model');
+    }
+    const inputMap = this.getInputMap(inputs);
+    const inputNames = Object.keys(inputMap);
+    const outputNames = this.getOutputNames(outputs);
+    const result = await this.backend.runGraphModelBatched(
+        this.modelId, inputNames, inputNames.map(name => inputMap[name]),
+        outputNames);
+    const returnsArray =
+        Array.isArray(outputs) || (outputs == null && result.length !== 1);
+    return returnsArray ? result : result[0];
+  }
+
+  /**
+   * Returns histograms of the queue depth seen by each `executeAsync()` call
+   * and of the rows and calls of each batch run.
+   */
+  getBatchStats(): BatchStats {
+    return this.backend.getBatchStats(this.modelId);
+  }
+
+  /** Closes the native session of the model. */
+  dispose(): void {
+    if (!this.disposed) {
+      this.disposed = true;
+      this.backend.deleteGraphModel(this.modelId);
+    }
+  }
+
+  private getOutputNames(outputs?: string|string[]): string[] {
+    return outputs == null ? this.outputNodes :
+                             (Array.isArray(outputs) ? outputs : [outputs]);
+  }
+
+  private getInputMap(inputs: Tensor|Tensor[]|NamedTensorMap):
+      NamedTensorMap {
+    if (!(inputs instanceof Tensor) && !Array.isArray(inputs)) {
+      return inputs as NamedTensorMap;
+    }
+    const inputArray = Array.isArray(inputs) ? inputs : [inputs];
+    if (inputArray.length !== this.inputNodes.length) {
+      throw new Error(
+          `Graph model has ${this.inputNodes.length} inputs, got ` +
+          `${inputArray.length} tensors`);
+    }
+    const inputMap: NamedTensorMap = {};
+    this.inputNodes.forEach((name, i) => {
+      inputMap[name] = inputArray[i];
+    });
+    return inputMap;
+  }
+}
+
+/**
+ * Loads a tfjs-converter GraphModel and runs it natively as a TensorFlow
+ * graph. Weights are written into the Const nodes of the graph, so that
+ * TensorFlow can fold them.
+ *
+ * ```js
+ * const model = await tf.node.loadGraphModel('file://path/to/model.json');
+ * const output = model.predict(tf.zeros([1, 224, 224, 3]));
+ * ```
+ *
+ * Only models with a JSON topology (`model.json`) are supported.
+ *
+ * @param pathOrIOHandler A path to `model.json`, optionally with a `file://`
+ *   scheme, or an IOHandler that loads the model artifacts.
+ */
+/**
+ * @doc {heading: 'Models', namespace: 'node'}
+ */
+export async function loadGraphModel(
+    pathOrIOHandler: string|tfc.io.IOHandler): Promise<NativeGraphModel> {
+  ensureTensorflowBackend();
+  const handler = typeof pathOrIOHandler === 'string' ?
+      (nodeFileSystemRouter(pathOrIOHandler) ||
+       new NodeFileSystem(pathOrIOHandler)) :
+      pathOrIOHandler;
+  if (handler.load == null) {
+    throw new Error('The IOHandler does not implement load()');
+  }
+
+  const artifacts = await handler.load();
+  const topology = artifacts.modelTopology;
+  if (topology == null || topology instanceof ArrayBuffer ||
+      ArrayBuffer.isView(topology)) {
+    throw new Error(
+        'Only graph models with a JSON topology can be loaded natively');
+  }
+  const graph = topology as GraphDefJSON;
+  if (!Array.isArray(graph.node)) {
+    throw new Error('The model topology is not a GraphDef');
+  }
+
+  const weights = artifacts.weightSpecs != null ?
+      tfc.io.decodeWeights(artifacts.weightData, artifacts.weightSpecs) :
+      {};
+  let graphDef: Uint8Array;
+  try {
+    graphDef = encodeGraphDef(graph, weights);
+  } finally {
+    tfc.dispose(Object.keys(weights).map(name => weights[name]));
+  }
+
+  const nodes: NodeDefJSON[] = graph.node;
+  const consumed: {[name: string]: boolean} = {};
+  nodes.forEach(node => (node.input || []).forEach(input => {
+    consumed[getInputNodeName(input)] = true;
+  }));
+  const inputNodes =
+      nodes.filter(node => node.op === 'Placeholder').map(node => node.name);
+  const outputNodes =
+      nodes
+          .filter(
+              node => !consumed[node.name] &&
+                  NON_OUTPUT_OPS.indexOf(node.op) === -1)
+          .map(node => node.name);
+
+  const backend = nodeBackend();
+  return new NativeGraphModel(
+      backend, backend.loadGraphModel(graphDef), inputNodes, outputNodes);
+}
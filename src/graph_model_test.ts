@@ -0,0 +1,167 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import * as tfc from '@tensorflow/tfjs-core';
+import {Tensor} from '@tensorflow/tfjs-core';
+import {expectArraysClose} from '@tensorflow/tfjs-core/dist/test_util';
+import * as fs from 'fs';
+import * as path from 'path';
+import {promisify} from 'util';
+
+import {GraphDefJSON} from './graph_def';
+import * as tfn from './index';
+
+// tslint:disable-next-line:no-require-imports
+const rimraf = require('rimraf');
+// tslint:disable-next-line:no-require-imports
+const tmp = require('tmp');
+
+const rimrafPromise = promisify(rimraf);
+const writeFile = promisify(fs.writeFile);
+
+describe('loadGraphModel', () => {
+  // output = reshape(matmul(x, w) + b, [-1]), with w, b and the int64 shape
+  // loaded from the weights.
+  const floatAttr = {'type': 'DT_FLOAT'};
+  const modelTopology: GraphDefJSON = {
+    node: [
+      {
+        name: 'x',
+        op: 'Placeholder',
+        attr: {
+          dtype: floatAttr,
+          shape: {shape: {dim: [{size: '-1'}, {size: '2'}]}}
+        }
+      },
+      {name: 'w', op: 'Const', attr: {dtype: floatAttr, value: {tensor: {}}}},
+      {name: 'b', op: 'Const', attr: {dtype: floatAttr, value: {tensor: {}}}},
+      {
+        name: 'shape',
+        op: 'Const',
+        attr: {dtype: {type: 'DT_INT64'}, value: {tensor: {}}}
+      },
+      {
+        name: 'matmul',
+        op: 'MatMul',
+        input: ['x', 'w'],
+        attr: {T: floatAttr, transpose_a: {b: false}, transpose_b: {b: false}}
+      },
+      {name: 'add', op: 'Add', input: ['matmul', 'b'], attr: {T: floatAttr}},
+      {
+        name: 'output',
+        op: 'Reshape',
+        input: ['add', 'shape'],
+        attr: {T: floatAttr, Tshape: {type: 'DT_INT64'}}
+      }
+    ],
+    versions: {producer: 27}
+  };
+  const weightSpecs: tfc.io.WeightsManifestEntry[] = [
+    {name: 'w', shape: [2, 1], dtype: 'float32'},
+    {name: 'b', shape: [1], dtype: 'float32'},
+    {name: 'shape', shape: [1], dtype: 'int32'}
+  ];
+  const weightBytes = Buffer.concat([
+    Buffer.from(new Float32Array([1, 2, 0.5]).buffer),
+    Buffer.from(new Int32Array([-1]).buffer)
+  ]);
+  const weightData = new Uint8Array(weightBytes).buffer;
+
+  let tmpDir: string;
+
+  beforeEach(() => {
+    tmpDir = tmp.dirSync().name;
+  });
+
+  afterEach(async () => {
+    if (tmpDir != null) {
+      await rimrafPromise(tmpDir);
+    }
+  });
+
+  it('runs a model.json from the file system', async () => {
+    const modelPath = path.join(tmpDir, 'model.json');
+    await writeFile(
+        modelPath,
+        JSON.stringify({
+          modelTopology,
+          weightsManifest: [{paths: ['weights.bin'], weights: weightSpecs}]
+        }),
+        'utf8');
+    await writeFile(path.join(tmpDir, 'weights.bin'), weightBytes);
+
+    const model = await tfn.node.loadGraphModel(`file://${modelPath}`);
+    expect(model.inputNodes).toEqual(['x']);
+    expect(model.outputNodes).toEqual(['output']);
+
+    const output = model.predict(tfc.tensor2d([[1, 1], [2, 3]])) as Tensor;
+    expect(output.shape).toEqual([2]);
+    expectArraysClose(await output.data(), [3.5, 8.5]);
+    model.dispose();
+  });
+
+  it('fetches named tensors', async () => {
+    const model = await tfn.node.loadGraphModel(
+        tfc.io.fromMemory(modelTopology, weightSpecs, weightData));
+    const x = tfc.tensor2d([[1, 0], [0, 1]]);
+
+    const [matmul, add] =
+        model.execute({'x:0': x}, ['matmul', 'add:0']) as Tensor[];
+    expect(matmul.shape).toEqual([2, 1]);
+    expectArraysClose(await matmul.data(), [1, 2]);
+    expectArraysClose(await add.data(), [1.5, 2.5]);
+
+    expect(() => model.execute(x, 'missing'))
+        .toThrowError(/no tensor named missing/);
+    model.dispose();
+    expect(() => model.predict(x)).toThrowError(/disposed/);
+  });
+
+  it('batches concurrent async runs', async () => {
+    const model = await tfn.node.loadGraphModel(
+        tfc.io.fromMemory(modelTopology, weightSpecs, weightData));
+    model.enableBatching({maxBatchSize: 3, batchTimeoutMicros: 100000});
+
+    // The second call fills the batch, so both run as one session call.
+    const [a, b] = await Promise.all([
+      model.predictAsync(tfc.tensor2d([[1, 1]])),
+      model.predictAsync(tfc.tensor2d([[2, 3], [0, 0]]))
+    ]) as Tensor[];
+    expect(a.shape).toEqual([1]);
+    expectArraysClose(await a.data(), [3.5]);
+    expect(b.shape).toEqual([2]);
+    expectArraysClose(await b.data(), [8.5, 0.5]);
+
+    const stats = model.getBatchStats();
+    expect(stats.queueDepth.buckets).toEqual([1, 1]);
+    expect(stats.batchSize.count).toBe(1);
+    expect(stats.batchSize.max).toBe(3);
+    expect(stats.batchRequests.sum).toBe(2);
+    model.dispose();
+  });
+
+  it('rejects models without a GraphDef topology', async done => {
+    const layersTopology = {'class_name': 'Sequential', 'config': []};
+    try {
+      await tfn.node.loadGraphModel(tfc.io.fromMemory(layersTopology));
+      done.fail('Loading a layers model should fail');
+    } catch (e) {
+      expect(e.message).toMatch(/not a GraphDef/);
+      done();
+    }
+  });
+});
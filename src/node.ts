@@ -20,16 +20,23 @@
  */
 
 import {tensorBoard} from './callbacks';
+import {configureContext, createContextBackend} from './context';
 // tslint:disable-next-line:max-line-length
 import {decodeBmp, decodeGif, decodeImage, decodeJpeg, decodePng} from './decode_image';
+import {loadGraphModel} from './graph_model';
+import {loadSavedModel} from './saved_model';
 import {summaryFileWriter} from './tensorboard';
 
 export const node = {
+  configureContext,
+  createContextBackend,
   decodeImage,
   decodeBmp,
   decodeGif,
   decodePng,
   decodeJpeg,
+  loadGraphModel,
+  loadSavedModel,
   summaryFileWriter,
   tensorBoard
 };
@@ -25,33 +25,187 @@ import {BackendValues, upcastType} from '@tensorflow/tfjs-core/dist/types';
 import {isNullOrUndefined} from 'util';
 import {Int64Scalar} from './int64_tensors';
 // tslint:disable-next-line:max-line-length
-import {createTensorsTypeOpAttr, createTypeOpAttr, getTFDType} from './ops/op_utils';
-import {TensorMetadata, TFEOpAttr, TFJSBinding} from './tfjs_binding';
+import {createTensorsTypeOpAttr, createTypeOpAttr, encodeOpAttrs, encodeProgram, getTFDType, ProgramOp} from './ops/op_utils';
+// tslint:disable-next-line:max-line-length
+import {BatchStats, DeviceInfo, SavedModelInfo, TensorMetadata, TFEOpAttr, TFJSBinding} from './tfjs_binding';
 
 type TensorInfo = {
   shape: number[],
   dtype: number,
   values: BackendValues,
-  id: number
+  id: number,
+  // Releases the native tensor when this info is garbage collected. Only set
+  // when GC release is enabled.
+  releaser?: object
 };
 
 interface DataId {}
 
+// Maximum number of (op name, attributes) combinations kept prepared in the
+// binding. The least recently used entry is released once this is exceeded.
+const PREPARED_OP_CACHE_SIZE = 1024;
+
+// Maximum number of encoded programs kept for reuse by executeProgram().
+const ENCODED_PROGRAM_CACHE_SIZE = 256;
+
+// Number of int32 slots reserved per output in the packed output metadata
+// buffer: id, dtype, rank and up to 16 dimensions.
+const PACKED_OUTPUT_METADATA_SIZE = 3 + 16;
+
+// Number of pending tensor disposals that forces a flush to the binding.
+const DISPOSAL_BATCH_SIZE = 1024;
+
+// Context most recently selected in the binding, shared by all backend
+// instances so that switching only costs a binding call when it changes.
+let activeContextId = 0;
+
+// Number of functions captured by captureFunction(), used for unique names.
+let numCapturedFunctions = 0;
+
+// Returns the ID of the current worker thread, or 0 on the main thread. It
+// keeps captured function names unique across workers that share a context.
+function getThreadId(): number {
+  try {
+    // tslint:disable-next-line:no-require-imports
+    return require('worker_threads').threadId;
+  } catch (e) {
+    return 0;
+  }
+}
+
+// Returns a key that identifies the names, types and values of Op attributes.
+function getOpAttrsKey(opAttrs: TFEOpAttr[]): string {
+  let key = '';
+  for (let i = 0; i < opAttrs.length; i++) {
+    const value = opAttrs[i].value;
+    key += `|${opAttrs[i].name}:${opAttrs[i].type}=${
+        typeof value === 'string' ? JSON.stringify(value) : value}`;
+  }
+  return key;
+}
+
 export class NodeJSKernelBackend extends KernelBackend {
   binding: TFJSBinding;
   isGPUPackage: boolean;
+  // Binding context that tensors of this backend live in and Ops run in.
+  readonly contextId: number;
+  // Device selected with withDevice(), or '' for the default placement.
+  private device = '';
   private tensorMap = new WeakMap<DataId, TensorInfo>();
-
-  constructor(binding: TFJSBinding, packageName: string) {
+  // Maps an Op name, device and attribute key to a prepared Op ID. Map
+  // iteration order is insertion order, so the first key is always the least
+  // recently used.
+  private preparedOps = new Map<string, number>();
+  // Maps a program key to its packed encoding, in least recently used first
+  // order like `preparedOps`.
+  private encodedPrograms = new Map<string, Uint8Array>();
+  // Scratch buffer the binding writes packed output metadata into.
+  private outputMetadata = new Int32Array(PACKED_OUTPUT_METADATA_SIZE);
+  // When set, readSync() returns views over the native tensor buffers instead
+  // of copies.
+  private zeroCopyReads = false;
+  // Tensor IDs disposed from JS but not yet deleted in the binding. They are
+  // deleted in one call when the batch fills up or on the next tick.
+  private pendingDisposals = new Int32Array(DISPOSAL_BATCH_SIZE);
+  private numPendingDisposals = 0;
+  // Releasers of pending disposals, kept alive so that garbage collection
+  // cannot release a tensor that is about to be deleted explicitly.
+  private pendingReleasers: object[] = [];
+  // When set, native tensors are released once their JS tensors are garbage
+  // collected, even if they were never disposed.
+  private gcRelease = false;
+  private disposalFlushScheduled = false;
+
+  constructor(binding: TFJSBinding, packageName: string, contextId = 0) {
     super();
     this.binding = binding;
     this.isGPUPackage = packageName === '@tensorflow/tfjs-node-gpu';
+    this.contextId = contextId;
+  }
+
+  // Selects the context of this backend in the binding.
+  private activateContext() {
+    if (activeContextId !== this.contextId) {
+      this.binding.setContext(this.contextId);
+      activeContextId = this.contextId;
+    }
+  }
+
+  /**
+   * Waits for the Ops of this backend to complete. With `asyncExecution`
+   * enabled in the context config, this throws the first error an Op raised
+   * since the last call. Reading tensor data also waits for its Op.
+   */
+  sync(): void {
+    this.activateContext();
+    this.binding.sync();
+  }
+
+  /** Lists the devices that Ops of this backend can be placed on. */
+  listDevices(): DeviceInfo[] {
+    this.activateContext();
+    return this.binding.listDevices();
+  }
+
+  /**
+   * Runs `f` with the Ops of this backend and the tensors they upload placed
+   * on a device, given its full name or a 'TYPE:N' suffix such as 'CPU:1'.
+   * The previous placement is restored when `f` returns or throws. Int32 and
+   * string tensors always stay in host memory.
+   */
+  withDevice<T>(deviceName: string, f: () => T): T {
+    const previousDevice = this.device;
+    this.setDevice(deviceName);
+    try {
+      return f();
+    } finally {
+      this.setDevice(previousDevice);
+    }
+  }
+
+  /** Returns the full name of the device a tensor lives on. */
+  getTensorDevice(tensor: Tensor): string {
+    return this.binding.getTensorDevice(this.getInputTensorIds([tensor])[0]);
+  }
+
+  private setDevice(deviceName: string) {
+    this.activateContext();
+    this.binding.setDevice(deviceName);
+    this.device = deviceName;
   }
 
   setDataMover(dataMover: DataMover): void {
     // TODO(kreeger, smilkov): Implement this.
   }
 
+  /**
+   * Enables or disables zero-copy reads. When enabled, `dataSync()` on
+   * numeric tensors returns a view over the native tensor buffer, which is
+   * kept alive until the returned array is garbage collected. The returned
+   * array must be treated as read-only.
+   */
+  setZeroCopyReads(enabled: boolean): void {
+    this.zeroCopyReads = enabled;
+  }
+
+  /**
+   * Enables or disables releasing native tensors of JS tensors that are
+   * garbage collected without being disposed. Only tensors created while
+   * enabled are affected. The number of tensors released this way is
+   * reported as `numReclaimedTensors` by `binding.getStats()`.
+   */
+  setGCRelease(enabled: boolean): void {
+    this.gcRelease = enabled;
+  }
+
+  // Stores the native tensor ID of a tensor.
+  private setTensorId(info: TensorInfo, id: number) {
+    info.id = id;
+    if (this.gcRelease) {
+      info.releaser = this.binding.trackTensor(id);
+    }
+  }
+
   private getDTypeInteger(dtype: DataType): number {
     switch (dtype) {
       case 'float32':
@@ -77,12 +231,10 @@ export class NodeJSKernelBackend extends KernelBackend {
   private createOutputTensor(metadata: TensorMetadata): Tensor {
     const newId = {};
 
-    this.tensorMap.set(newId, {
-      shape: metadata.shape,
-      dtype: metadata.dtype,
-      id: metadata.id,
-      values: null
-    });
+    const info: TensorInfo =
+        {shape: metadata.shape, dtype: metadata.dtype, id: -1, values: null};
+    this.setTensorId(info, metadata.id);
+    this.tensorMap.set(newId, info);
 
     let dtype: DataType;
     switch (metadata.dtype) {
@@ -117,9 +269,47 @@ export class NodeJSKernelBackend extends KernelBackend {
     return Tensor.make(metadata.shape, {dataId: newId}, dtype);
   }
 
+  // Creates output Tensors from the packed metadata written by the binding.
+  // Outputs of async contexts come without a shape. They use `outputShape`
+  // when the caller knows it, so that the Op does not have to complete.
+  private createOutputTensors(numOutputs: number, outputShape?: number[]):
+      Tensor[] {
+    const metadata = this.outputMetadata;
+    const tensors: Tensor[] = [];
+    let offset = 0;
+    for (let i = 0; i < numOutputs; i++) {
+      const id = metadata[offset];
+      const rank = metadata[offset + 2];
+      let shape: number[];
+      if (rank < 0) {
+        shape = outputShape != null ? outputShape :
+                                      this.binding.getTensorShape(id);
+      } else {
+        shape = [];
+        for (let j = 0; j < rank; j++) {
+          shape.push(metadata[offset + 3 + j]);
+        }
+      }
+      tensors.push(
+          this.createOutputTensor({id, dtype: metadata[offset + 1], shape}));
+      offset += 3 + Math.max(rank, 0);
+    }
+    return tensors;
+  }
+
+  // Returns the scratch output metadata buffer, grown to fit `numOutputs`.
+  private getOutputMetadata(numOutputs: number): Int32Array {
+    const size = numOutputs * PACKED_OUTPUT_METADATA_SIZE;
+    if (this.outputMetadata.length < size) {
+      this.outputMetadata = new Int32Array(size);
+    }
+    return this.outputMetadata;
+  }
+
   // Prepares Tensor instances for Op execution.
-  private getInputTensorIds(tensors: Array<Tensor|Int64Scalar>): number[] {
-    const ids: number[] = [];
+  private getInputTensorIds(tensors: Array<Tensor|Int64Scalar>): Int32Array {
+    this.activateContext();
+    const ids = new Int32Array(tensors.length);
     for (let i = 0; i < tensors.length; i++) {
       if (tensors[i] instanceof Tensor) {
         const info = this.tensorMap.get((tensors[i] as Tensor).dataId);
@@ -127,18 +317,18 @@ export class NodeJSKernelBackend extends KernelBackend {
         if (info.values != null) {
           // Values were delayed to write into the TensorHandle. Do that before
           // Op execution and clear stored values.
-          info.id =
-              this.binding.createTensor(info.shape, info.dtype, info.values);
+          this.setTensorId(
+              info,
+              this.binding.createTensor(info.shape, info.dtype, info.values));
           info.values = null;
           this.tensorMap.set((tensors[i] as Tensor).dataId, info);
         }
-        ids.push(info.id);
+        ids[i] = info.id;
       } else if (tensors[i] instanceof Int64Scalar) {
         // Then `tensors[i]` is a Int64Scalar, which we currently represent
         // using an `Int32Array`.
         const value = (tensors[i] as Int64Scalar).valueArray;
-        const id = this.binding.createTensor([], this.binding.TF_INT64, value);
-        ids.push(id);
+        ids[i] = this.binding.createTensor([], this.binding.TF_INT64, value);
       } else {
         throw new Error(`Invalid Tensor type: ${typeof tensors[i]}`);
       }
@@ -153,9 +343,31 @@ export class NodeJSKernelBackend extends KernelBackend {
     ];
   }
 
+  // Executes an element-wise Op, whose output has the shape of its input.
   private executeSingleInput(name: string, input: Tensor): Tensor {
     const opAttrs = [createTypeOpAttr('T', input.dtype)];
-    return this.executeSingleOutput(name, opAttrs, [input]);
+    return this.executeSingleOutput(name, opAttrs, [input], input.shape);
+  }
+
+  // Returns the prepared Op ID for a name and attribute set, preparing and
+  // caching a new one when needed.
+  private getPreparedOp(name: string, opAttrs: TFEOpAttr[]): number {
+    this.activateContext();
+    const key = `${name}@${this.device}${getOpAttrsKey(opAttrs)}`;
+    let preparedOpId = this.preparedOps.get(key);
+    if (preparedOpId !== undefined) {
+      // Move the entry to the most recently used position.
+      this.preparedOps.delete(key);
+    } else {
+      preparedOpId = this.binding.prepareOp(name, opAttrs);
+      if (this.preparedOps.size >= PREPARED_OP_CACHE_SIZE) {
+        const lruKey = this.preparedOps.keys().next().value;
+        this.binding.releasePreparedOp(this.preparedOps.get(lruKey));
+        this.preparedOps.delete(lruKey);
+      }
+    }
+    this.preparedOps.set(key, preparedOpId);
+    return preparedOpId;
   }
 
   floatPrecision(): 16|32 {
@@ -171,13 +383,17 @@ export class NodeJSKernelBackend extends KernelBackend {
    * @param name The name of the Op to execute.
    * @param opAttrs The list of Op attributes required to execute.
    * @param inputs The list of input Tensors for the Op.
+   * @param outputShape The shape of the output, if known. Saves waiting for
+   *     the Op in async contexts.
    * @return A resulting Tensor from Op execution.
    */
-  executeSingleOutput(name: string, opAttrs: TFEOpAttr[], inputs: Tensor[]):
-      Tensor {
-    const outputMetadata = this.binding.executeOp(
-        name, opAttrs, this.getInputTensorIds(inputs), 1);
-    return this.createOutputTensor(outputMetadata[0]);
+  executeSingleOutput(
+      name: string, opAttrs: TFEOpAttr[], inputs: Tensor[],
+      outputShape?: number[]): Tensor {
+    this.binding.executePrepared(
+        this.getPreparedOp(name, opAttrs), this.getInputTensorIds(inputs), 1,
+        this.getOutputMetadata(1));
+    return this.createOutputTensors(1, outputShape)[0];
   }
 
   /**
@@ -191,15 +407,122 @@ export class NodeJSKernelBackend extends KernelBackend {
   executeMultipleOutputs(
       name: string, opAttrs: TFEOpAttr[], inputs: Tensor[],
       numOutputs: number): Tensor[] {
-    const outputMetadata = this.binding.executeOp(
+    const numResults = this.binding.executePrepared(
+        this.getPreparedOp(name, opAttrs), this.getInputTensorIds(inputs),
+        numOutputs, this.getOutputMetadata(numOutputs));
+    return this.createOutputTensors(numResults);
+  }
+
+  /**
+   * Executes a TensorFlow Eager Op on a worker thread so that the Node.js
+   * event loop is not blocked while the kernel runs.
+   * @param name The name of the Op to execute.
+   * @param opAttrs The list of Op attributes required to execute.
+   * @param inputs The list of input Tensors for the Op.
+   * @param numOutputs The number of output Tensors for Op execution.
+   * @return A Promise of the resulting Tensor array from Op execution.
+   */
+  async executeAsync(
+      name: string, opAttrs: TFEOpAttr[], inputs: Tensor[],
+      numOutputs: number): Promise<Tensor[]> {
+    const outputMetadata = await this.binding.executeOpAsync(
         name, opAttrs, this.getInputTensorIds(inputs), numOutputs);
     return outputMetadata.map(m => this.createOutputTensor(m));
   }
 
-  dispose(): void {}
+  /**
+   * Executes a list of TensorFlow Eager Ops in a single binding call.
+   * Intermediate outputs stay in the binding and are released natively.
+   * @param ops The Ops to execute in order. Op inputs are indices into the
+   *     program values: `inputs` followed by the outputs of each Op.
+   * @param inputs The list of input Tensors for the program.
+   * @param outputs Indices of the program values to return.
+   * @return The requested Tensors from program execution.
+   */
+  executeProgram(ops: ProgramOp[], inputs: Tensor[], outputs: number[]):
+      Tensor[] {
+    const numResults = this.binding.executeProgram(
+        this.getEncodedProgram(ops), this.getInputTensorIds(inputs),
+        new Int32Array(outputs), this.getOutputMetadata(outputs.length));
+    return this.createOutputTensors(numResults);
+  }
+
+  // Returns the packed encoding of a program, encoding and caching it when
+  // needed.
+  private getEncodedProgram(ops: ProgramOp[]): Uint8Array {
+    let key = '';
+    for (let i = 0; i < ops.length; i++) {
+      key += `;${ops[i].name}${getOpAttrsKey(ops[i].opAttrs)}>${
+          ops[i].inputs.join(',')}>${ops[i].numOutputs}`;
+    }
+
+    let encoded = this.encodedPrograms.get(key);
+    if (encoded !== undefined) {
+      // Move the entry to the most recently used position.
+      this.encodedPrograms.delete(key);
+    } else {
+      encoded = encodeProgram(ops);
+      if (this.encodedPrograms.size >= ENCODED_PROGRAM_CACHE_SIZE) {
+        this.encodedPrograms.delete(this.encodedPrograms.keys().next().value);
+      }
+    }
+    this.encodedPrograms.set(key, encoded);
+    return encoded;
+  }
+
+  // Executes an Op followed by an optional bias add and activation as a single
+  // program. Returns null when the activation needs the generic code path.
+  private executeFusedOp(
+      name: string, opAttrs: TFEOpAttr[], inputs: Tensor[], bias: Tensor,
+      activation: Activation): Tensor {
+    if (activation != null && activation !== 'linear' &&
+        activation !== 'relu') {
+      return null;
+    }
+    const programInputs = bias != null ? inputs.concat([bias]) : inputs;
+    const ops: ProgramOp[] =
+        [{name, opAttrs, inputs: inputs.map((_, i) => i), numOutputs: 1}];
+    let result = programInputs.length;
+    let dtype = inputs[0].dtype;
+    if (bias != null) {
+      dtype = upcastType(dtype, bias.dtype);
+      ops.push({
+        name: 'Add',
+        opAttrs: [createTypeOpAttr('T', dtype)],
+        inputs: [result, inputs.length],
+        numOutputs: 1
+      });
+      result++;
+    }
+    if (activation === 'relu') {
+      ops.push({
+        name: 'Relu',
+        opAttrs: [createTypeOpAttr('T', dtype)],
+        inputs: [result],
+        numOutputs: 1
+      });
+      result++;
+    }
+    return this.executeProgram(ops, programInputs, [result])[0];
+  }
+
+  dispose(): void {
+    this.flushDisposals();
+    this.preparedOps.forEach(id => this.binding.releasePreparedOp(id));
+    this.preparedOps.clear();
+    this.encodedPrograms.clear();
+  }
 
   async read(dataId: object): Promise<BackendValues> {
-    return this.readSync(dataId);
+    if (!this.tensorMap.has(dataId)) {
+      throw new Error(`Tensor ${dataId} was not registered!`);
+    }
+    const info = this.tensorMap.get(dataId);
+    if (info.values != null) {
+      return info.values;
+    } else {
+      return this.binding.tensorDataAsync(info.id);
+    }
   }
 
   readSync(dataId: object): BackendValues {
@@ -210,18 +533,246 @@ export class NodeJSKernelBackend extends KernelBackend {
     if (info.values != null) {
       return info.values;
     } else {
-      return this.binding.tensorDataSync(info.id);
+      return this.binding.tensorDataSync(info.id, this.zeroCopyReads);
+    }
+  }
+
+  /**
+   * Copies the values of a tensor into `target` starting at `offset`, so that
+   * callers reading same-shaped tensors repeatedly can recycle one buffer.
+   * The typed array type must match the tensor dtype (Float32Array for
+   * float32 and complex64, Int32Array for int32 and Uint8Array for bool).
+   */
+  readInto(
+      dataId: object, target: Float32Array|Int32Array|Uint8Array,
+      offset = 0): void {
+    if (!this.tensorMap.has(dataId)) {
+      throw new Error(`Tensor ${dataId} was not registered!`);
+    }
+    const info = this.tensorMap.get(dataId);
+    if (info.values == null) {
+      this.binding.tensorDataInto(info.id, target, offset);
+      return;
+    }
+    if (info.dtype === this.binding.TF_STRING) {
+      throw new Error('readInto() is not supported for string tensors');
+    }
+    const values = info.values as Float32Array | Int32Array | Uint8Array;
+    if (values.constructor !== target.constructor) {
+      throw new Error(
+          `Expected a ${values.constructor.name} target for this tensor`);
+    }
+    if (offset < 0 || offset + values.length > target.length) {
+      throw new Error(
+          `Target of length ${target.length} is too small for ` +
+          `${values.length} values at offset ${offset}`);
+    }
+    target.set(values, offset);
+  }
+
+  /**
+   * Returns the values of a tensor in a typed array over a new
+   * SharedArrayBuffer, which can be handed to other worker threads without a
+   * copy.
+   */
+  readShared(dataId: object): Float32Array|Int32Array|Uint8Array {
+    if (!this.tensorMap.has(dataId)) {
+      throw new Error(`Tensor ${dataId} was not registered!`);
     }
+    const info = this.tensorMap.get(dataId);
+    const size = util.sizeFromShape(info.shape);
+    let target: Float32Array|Int32Array|Uint8Array;
+    switch (info.dtype) {
+      case this.binding.TF_COMPLEX64:
+        // Complex values are interleaved float32 pairs.
+        target = new Float32Array(new SharedArrayBuffer(size * 8));
+        break;
+      case this.binding.TF_FLOAT:
+        target = new Float32Array(new SharedArrayBuffer(size * 4));
+        break;
+      case this.binding.TF_INT32:
+        target = new Int32Array(new SharedArrayBuffer(size * 4));
+        break;
+      case this.binding.TF_BOOL:
+        target = new Uint8Array(new SharedArrayBuffer(size));
+        break;
+      default:
+        throw new Error(`readShared() is not supported for dtype ${
+            info.dtype}`);
+    }
+    this.readInto(dataId, target);
+    return target;
+  }
+
+  /**
+   * Exports a tensor so that another worker thread can import it with
+   * `importTensor()` without copying its data. The returned token can be
+   * posted to the other thread and is valid for one import. The exporting
+   * thread must stay alive until the imported tensor is disposed.
+   */
+  exportTensor(tensor: Tensor): number {
+    return this.binding.exportTensor(this.getInputTensorIds([tensor])[0]);
+  }
+
+  /**
+   * Traces `f` once with `inputs` and returns a function that replays the
+   * Ops it ran as a single TensorFlow function call. This lets e.g.
+   * `model.predict()` be traced once and then run with one dispatch per call.
+   *
+   * `f` runs eagerly while it is traced. Tensors other than `inputs` that it
+   * reads, such as weights, are captured as constants. Replays take inputs
+   * of the same dtypes, and shapes baked into Op attributes still apply.
+   * Async Ops cannot be captured.
+   */
+  captureFunction(
+      f: (...inputs: Tensor[]) => Tensor | Tensor[],
+      inputs: Tensor[]): (inputs: Tensor[]) => Tensor[] {
+    const inputIds = this.getInputTensorIds(inputs);
+    this.binding.beginCapture(inputIds);
+    let name: string;
+    let numOutputs: number;
+    try {
+      const result = f(...inputs);
+      const outputs = Array.isArray(result) ? result : [result];
+      const outputIds = this.getInputTensorIds(outputs);
+      name = `tfjs_captured_${getThreadId()}_${numCapturedFunctions++}`;
+      numOutputs = outputs.length;
+      this.activateContext();
+      this.binding.endCapture(name, outputIds);
+    } catch (e) {
+      this.binding.cancelCapture();
+      throw e;
+    }
+
+    return (replayInputs: Tensor[]) => {
+      if (replayInputs.length !== inputs.length) {
+        throw new Error(`Captured function ${name} takes ${
+            inputs.length} inputs, got ${replayInputs.length}`);
+      }
+      return this.executeMultipleOutputs(name, [], replayInputs, numOutputs);
+    };
+  }
+
+  /**
+   * Imports a serialized GraphDef into a native TensorFlow session and
+   * returns the ID of the graph model. The session uses the thread and
+   * placement options of the context of this backend.
+   */
+  loadGraphModel(graphDef: Uint8Array): number {
+    this.activateContext();
+    return this.binding.loadGraphModel(graphDef);
+  }
+
+  /**
+   * Runs a graph model loaded by `loadGraphModel()` in one session call,
+   * feeding `inputs` to the tensors named by `inputNames` and returning the
+   * tensors named by `outputNames`.
+   */
+  runGraphModel(
+      modelId: number, inputNames: string[], inputs: Tensor[],
+      outputNames: string[]): Tensor[] {
+    const metadata = this.binding.runGraphModel(
+        modelId, inputNames, this.getInputTensorIds(inputs), outputNames);
+    return metadata.map(m => this.createOutputTensor(m));
+  }
+
+  /**
+   * Sets how `runGraphModelBatched()` calls of a graph model are batched.
+   */
+  configureBatching(
+      modelId: number, maxBatchSize: number, batchTimeoutMicros: number) {
+    this.binding.configureBatching(modelId, maxBatchSize, batchTimeoutMicros);
+  }
+
+  /**
+   * Runs a graph model like `runGraphModel()`, batched natively with
+   * concurrent calls. Inputs are concatenated along their first dimension and
+   * the outputs are split back per call.
+   */
+  async runGraphModelBatched(
+      modelId: number, inputNames: string[], inputs: Tensor[],
+      outputNames: string[]): Promise<Tensor[]> {
+    const metadata = await this.binding.runGraphModelBatched(
+        modelId, inputNames, this.getInputTensorIds(inputs), outputNames);
+    return metadata.map(m => this.createOutputTensor(m));
+  }
+
+  /** Returns the histograms of the batched runs of a graph model. */
+  getBatchStats(modelId: number): BatchStats {
+    return this.binding.getBatchStats(modelId);
+  }
+
+  /**
+   * Loads the MetaGraph of a SavedModel that matches `tags` into a native
+   * TensorFlow session, like `loadGraphModel()`. Returns the model ID and
+   * its signatures.
+   */
+  loadSavedModel(exportDir: string, tags: string[]): SavedModelInfo {
+    this.activateContext();
+    return this.binding.loadSavedModel(exportDir, tags);
+  }
+
+  /**
+   * Runs a signature of a SavedModel loaded by `loadSavedModel()` in one
+   * session call, feeding `inputs` to the signature inputs named by
+   * `inputNames` and returning the signature outputs named by `outputNames`.
+   */
+  runSignature(
+      modelId: number, signatureKey: string, inputNames: string[],
+      inputs: Tensor[], outputNames: string[]): Tensor[] {
+    const metadata = this.binding.runSignature(
+        modelId, signatureKey, inputNames, this.getInputTensorIds(inputs),
+        outputNames);
+    return metadata.map(m => this.createOutputTensor(m));
+  }
+
+  /**
+   * Closes the session of a model loaded by `loadGraphModel()` or
+   * `loadSavedModel()`.
+   */
+  deleteGraphModel(modelId: number): void {
+    this.binding.deleteGraphModel(modelId);
+  }
+
+  /** Creates a tensor from a token returned by `exportTensor()`. */
+  importTensor(token: number): Tensor {
+    this.activateContext();
+    return this.createOutputTensor(this.binding.importTensor(token));
   }
 
   disposeData(dataId: object): void {
-    const id = this.tensorMap.get(dataId).id;
+    const info = this.tensorMap.get(dataId);
+    const id = info.id;
     if (id != null && id >= 0) {
-      this.binding.deleteTensor(id);
+      if (info.releaser != null) {
+        this.pendingReleasers.push(info.releaser);
+      }
+      this.pendingDisposals[this.numPendingDisposals++] = id;
+      if (this.numPendingDisposals === DISPOSAL_BATCH_SIZE) {
+        this.flushDisposals();
+      } else if (!this.disposalFlushScheduled) {
+        this.disposalFlushScheduled = true;
+        process.nextTick(() => this.flushDisposals());
+      }
     }
     this.tensorMap.delete(dataId);
   }
 
+  /** Deletes all tensors disposed since the last flush in the binding. */
+  flushDisposals(): void {
+    this.disposalFlushScheduled = false;
+    if (this.numPendingDisposals === 0) {
+      return;
+    }
+    const ids = this.pendingDisposals.subarray(0, this.numPendingDisposals);
+    this.numPendingDisposals = 0;
+    try {
+      this.binding.deleteTensors(ids);
+    } finally {
+      this.pendingReleasers.length = 0;
+    }
+  }
+
   write(dataId: object, values: BackendValues): void {
     if (!this.tensorMap.has(dataId)) {
       throw new Error(`Tensor ${dataId} was not registered!`);
@@ -347,6 +898,13 @@ export class NodeJSKernelBackend extends KernelBackend {
   fusedConv2d(
       x: Tensor4D, filter: Tensor4D, convInfo: Conv2DInfo, bias?: Tensor4D,
       activation?: Activation, preluActivationWeights?: Tensor): Tensor4D {
+    const fused = this.executeFusedOp(
+        'Conv2D', this.createConv2dOpAttrs(x, convInfo), [x, filter], bias,
+        activation);
+    if (fused != null) {
+      return fused as Tensor4D;
+    }
+
     let result = this.conv2d(x, filter, convInfo);
     if (bias != null) {
       result = this.add(result, bias) as Tensor4D;
@@ -374,6 +932,17 @@ export class NodeJSKernelBackend extends KernelBackend {
       preluActivationWeights?: Tensor): Tensor3D {
     // Core TensorFlow does not have a fused BatchMatMul op. Combine calls to
     // achieve the same results:
+    const opAttrs = [
+      createTypeOpAttr('T', a.dtype),
+      {name: 'adj_x', type: this.binding.TF_ATTR_BOOL, value: transposeA},
+      {name: 'adj_y', type: this.binding.TF_ATTR_BOOL, value: transposeB}
+    ];
+    const fused =
+        this.executeFusedOp('BatchMatMul', opAttrs, [a, b], bias, activation);
+    if (fused != null) {
+      return fused as Tensor3D;
+    }
+
     let result = this.batchMatMul(a, b, transposeA, transposeB);
     if (bias != null) {
       result = this.add(result, bias) as Tensor3D;
@@ -812,7 +1381,8 @@ export class NodeJSKernelBackend extends KernelBackend {
     return this.select(nans, x, stepNoNans) as T;
   }
 
-  conv2d(x: Tensor4D, filter: Tensor4D, convInfo: Conv2DInfo): Tensor4D {
+  private createConv2dOpAttrs(x: Tensor4D, convInfo: Conv2DInfo):
+      TFEOpAttr[] {
     if (convInfo.padInfo.type !== 'VALID' && convInfo.padInfo.type !== 'SAME') {
       throw new Error(
           `TF Backend supports only 'valid' and 'same' padding ` +
@@ -822,7 +1392,7 @@ export class NodeJSKernelBackend extends KernelBackend {
     const padding = convInfo.padInfo.type;
     const dataFormat = convInfo.dataFormat === 'channelsLast' ? 'NHWC' : 'NCHW';
     const dilations = [1, convInfo.dilationHeight, convInfo.dilationWidth, 1];
-    const opAttrs = [
+    return [
       createTypeOpAttr('T', x.dtype),
       {name: 'strides', type: this.binding.TF_ATTR_INT, value: strides},
       {name: 'padding', type: this.binding.TF_ATTR_STRING, value: padding},
@@ -834,6 +1404,10 @@ export class NodeJSKernelBackend extends KernelBackend {
       {name: 'use_cudnn_on_gpu', type: this.binding.TF_ATTR_BOOL, value: true},
       {name: 'dilations', type: this.binding.TF_ATTR_INT, value: dilations},
     ];
+  }
+
+  conv2d(x: Tensor4D, filter: Tensor4D, convInfo: Conv2DInfo): Tensor4D {
+    const opAttrs = this.createConv2dOpAttrs(x, convInfo);
     return this.executeSingleOutput('Conv2D', opAttrs, [x, filter]) as Tensor4D;
   }
 
@@ -1840,8 +2414,9 @@ export class NodeJSKernelBackend extends KernelBackend {
       const opAttrs: TFEOpAttr[] =
           [{name: 'T', type: this.binding.TF_ATTR_TYPE, value: typeAttr}];
 
-      this.binding.executeOp(
-          'WriteScalarSummary', opAttrs, this.getInputTensorIds(inputArgs), 0);
+      this.binding.executeOpPacked(
+          'WriteScalarSummary', encodeOpAttrs(opAttrs),
+          this.getInputTensorIds(inputArgs), 0, this.getOutputMetadata(0));
     });
   }
 
@@ -1854,10 +2429,17 @@ export class NodeJSKernelBackend extends KernelBackend {
   // ------------------------------------------------------------
 
   memory() {
-    // Due to automatic garbage collection, the numbers are unreliable.
-    // TODO(kreeger): Since there is finalization in C, count the true
-    // number of undisposed tensors.
-    return {unreliable: true};
+    // Due to automatic garbage collection, the engine counts are unreliable.
+    // The native counts below cover every tensor alive in the binding.
+    // Pending disposals still hold native memory until they are flushed.
+    this.flushDisposals();
+    const stats = this.binding.getStats();
+    return {
+      unreliable: true,
+      numNativeTensors: stats.numTensors,
+      numNativeBytes: stats.numBytes,
+      peakNativeBytes: stats.peakBytes
+    };
   }
 
   async time(f: () => void): Promise<BackendTimingInfo> {
@@ -20,6 +20,7 @@ import {Tensor5D} from '@tensorflow/tfjs-core/dist/tensor';
 // tslint:disable-next-line:max-line-length
 import {expectArraysClose} from '@tensorflow/tfjs-core/dist/test_util';
 import {NodeJSKernelBackend} from './nodejs_kernel_backend';
+import {createTypeOpAttr, nodeBackend} from './ops/op_utils';
 
 describe('delayed upload', () => {
   it('should handle data before op execution', async () => {
@@ -64,3 +65,233 @@ describe('conv3d dilations', () => {
     }
   });
 });
+
+describe('executeProgram', () => {
+  it('runs a chain of ops and returns the requested outputs', async () => {
+    const x = tf.tensor2d([1, -2, 3, -4], [2, 2]);
+    const bias = tf.tensor1d([1, 1]);
+    const typeAttr = createTypeOpAttr('T', 'float32');
+    const [result] = nodeBackend().executeProgram(
+        [
+          {name: 'Add', opAttrs: [typeAttr], inputs: [0, 1], numOutputs: 1},
+          {name: 'Relu', opAttrs: [typeAttr], inputs: [2], numOutputs: 1}
+        ],
+        [x, bias], [3]);
+    expect(result.shape).toEqual([2, 2]);
+    expectArraysClose(await result.data(), [2, 0, 4, 0]);
+  });
+});
+
+describe('executeAsync', () => {
+  it('resolves with output tensors', async () => {
+    const a = tf.tensor2d([1, 2, 3, 4], [2, 2]);
+    const b = tf.tensor2d([4, 3, 2, 1], [2, 2]);
+    const binding = nodeBackend().binding;
+    const opAttrs = [
+      createTypeOpAttr('T', 'float32'),
+      {name: 'transpose_a', type: binding.TF_ATTR_BOOL, value: false},
+      {name: 'transpose_b', type: binding.TF_ATTR_BOOL, value: false}
+    ];
+    const [result] =
+        await nodeBackend().executeAsync('MatMul', opAttrs, [a, b], 1);
+    expect(result.shape).toEqual([2, 2]);
+    expectArraysClose(await result.data(), [8, 5, 20, 13]);
+  });
+});
+
+describe('zero-copy reads', () => {
+  afterEach(() => nodeBackend().setZeroCopyReads(false));
+
+  it('dataSync() returns the tensor values', () => {
+    nodeBackend().setZeroCopyReads(true);
+    const result = tf.add(tf.tensor1d([1, 2, 3]), tf.tensor1d([4, 5, 6]));
+    expectArraysClose(result.dataSync(), [5, 7, 9]);
+  });
+});
+
+describe('readInto', () => {
+  it('reads computed tensors into a recycled buffer', () => {
+    const target = new Float32Array(3);
+    const a = tf.add(tf.tensor1d([1, 2, 3]), tf.tensor1d([4, 5, 6]));
+    nodeBackend().readInto(a.dataId, target);
+    expectArraysClose(target, [5, 7, 9]);
+
+    const b = tf.mul(tf.tensor1d([1, 2, 3]), tf.scalar(2));
+    nodeBackend().readInto(b.dataId, target);
+    expectArraysClose(target, [2, 4, 6]);
+  });
+  it('reads tensors that have not been uploaded', () => {
+    const target = new Int32Array(4);
+    const t = tf.tensor1d([7, 8], 'int32');
+    nodeBackend().readInto(t.dataId, target, 2);
+    expectArraysClose(target, [0, 0, 7, 8]);
+  });
+  it('throws with a mismatched target type', () => {
+    const t = tf.tensor1d([7, 8], 'int32');
+    expect(() => nodeBackend().readInto(t.dataId, new Float32Array(2)))
+        .toThrowError();
+  });
+});
+
+describe('shared memory', () => {
+  it('reads tensors into a SharedArrayBuffer', () => {
+    const a = tf.add(tf.tensor1d([1, 2, 3]), tf.tensor1d([4, 5, 6]));
+    const values = nodeBackend().readShared(a.dataId);
+    expect(values.buffer instanceof SharedArrayBuffer).toBe(true);
+    expectArraysClose(values, [5, 7, 9]);
+  });
+  it('creates tensors from SharedArrayBuffer-backed arrays', () => {
+    const values = new Int32Array(new SharedArrayBuffer(8));
+    values.set([3, 4]);
+    const t = tf.tensor1d(values, 'int32').add(tf.scalar(1, 'int32'));
+    expectArraysClose(t.dataSync(), [4, 5]);
+  });
+  it('exports and imports tensors', () => {
+    const a = tf.tensor2d([1, 2, 3, 4], [2, 2]);
+    const token = nodeBackend().exportTensor(a);
+    a.dispose();
+
+    const b = nodeBackend().importTensor(token);
+    expect(b.shape).toEqual([2, 2]);
+    expect(b.dtype).toBe('float32');
+    expectArraysClose(b.dataSync(), [1, 2, 3, 4]);
+    expect(() => nodeBackend().importTensor(token)).toThrowError();
+  });
+});
+
+describe('batched disposal', () => {
+  // Exposes private backend state for these tests.
+  type BackendInternals = {
+    tensorMap: WeakMap<object, {id: number}>,
+    numPendingDisposals: number
+  };
+
+  it('deletes disposed tensors in the binding on flush', () => {
+    const backend = nodeBackend();
+    const internals = backend as {} as BackendInternals;
+    const t = tf.add(tf.tensor1d([1, 2]), tf.tensor1d([3, 4]));
+    const id = internals.tensorMap.get(t.dataId).id;
+    t.dispose();
+    expect(backend.binding.tensorDataSync(id))
+        .toEqual(new Float32Array([4, 6]));
+    backend.flushDisposals();
+    expect(() => backend.binding.tensorDataSync(id)).toThrowError();
+  });
+  it('flushes on the next tick', done => {
+    const internals = nodeBackend() as {} as BackendInternals;
+    tf.tidy(() => tf.add(tf.tensor1d([1, 2]), tf.tensor1d([3, 4])));
+    expect(internals.numPendingDisposals).toBeGreaterThan(0);
+    process.nextTick(() => {
+      expect(internals.numPendingDisposals).toBe(0);
+      done();
+    });
+  });
+});
+
+describe('memory', () => {
+  it('reports native tensors and bytes', () => {
+    const backend = nodeBackend();
+    const before = backend.memory();
+    const t = tf.add(tf.tensor1d([1, 2, 3]), tf.tensor1d([4, 5, 6]));
+    const during = backend.memory();
+    expect(during.unreliable).toBe(true);
+    expect(during.numNativeTensors).toBeGreaterThan(before.numNativeTensors);
+    expect(during.numNativeBytes)
+        .toBeGreaterThanOrEqual(before.numNativeBytes + 12);
+
+    t.dispose();
+    expect(backend.memory().numNativeBytes).toBeLessThan(during.numNativeBytes);
+  });
+});
+
+describe('GC release', () => {
+  afterEach(() => nodeBackend().setGCRelease(false));
+
+  it('disposes tracked tensors explicitly', () => {
+    const backend = nodeBackend();
+    backend.setGCRelease(true);
+    const before = backend.binding.getStats();
+    const t = tf.add(tf.tensor1d([1, 2]), tf.tensor1d([3, 4]));
+    expectArraysClose(t.dataSync(), [4, 6]);
+    t.dispose();
+    backend.flushDisposals();
+    const after = backend.binding.getStats();
+    expect(after.numDisposedTensors).toBeGreaterThan(before.numDisposedTensors);
+  });
+});
+
+describe('devices', () => {
+  it('lists the host CPU', () => {
+    const devices = nodeBackend().listDevices();
+    expect(devices.some(device => device.type === 'CPU')).toBe(true);
+  });
+  it('places Ops and tensors within withDevice()', () => {
+    const backend = nodeBackend();
+    const cpu = backend.listDevices().find(device => device.type === 'CPU');
+    const result = backend.withDevice('CPU:0', () => {
+      const t = tf.add(tf.tensor1d([1, 2]), tf.tensor1d([3, 4]));
+      expect(backend.getTensorDevice(t)).toBe(cpu.name);
+      return t;
+    });
+    expectArraysClose(result, [4, 6]);
+  });
+  it('restores the placement when the scope throws', () => {
+    const backend = nodeBackend();
+    expect(() => backend.withDevice('CPU:0', () => {
+      throw new Error('scope error');
+    })).toThrowError(/scope error/);
+    expectArraysClose(tf.add(tf.scalar(1), tf.scalar(2)), [3]);
+  });
+  it('throws for an unknown device', () => {
+    expect(() => nodeBackend().withDevice('TPU:7', () => null))
+        .toThrowError(/Unknown device/);
+  });
+});
+
+describe('graph capture', () => {
+  it('replays the captured Ops with new inputs', () => {
+    const backend = nodeBackend();
+    const weight = tf.tensor1d([2, 3]);
+    const f = (x: tf.Tensor) => tf.tanh(tf.add(tf.mul(x, weight), 1));
+    const replay = backend.captureFunction(f, [tf.tensor1d([0, 0])]);
+
+    const x = tf.tensor1d([1, -1]);
+    const [result] = replay([x]);
+    expect(result.shape).toEqual([2]);
+    expectArraysClose(result, f(x));
+  });
+  it('returns multiple outputs', () => {
+    const backend = nodeBackend();
+    const replay = backend.captureFunction(
+        (a, b) => [tf.add(a, b), tf.sub(a, b)],
+        [tf.scalar(1), tf.scalar(2)]);
+    const [sum, difference] = replay([tf.scalar(5), tf.scalar(3)]);
+    expectArraysClose(sum, [8]);
+    expectArraysClose(difference, [2]);
+  });
+  it('captures Ops with list inputs', () => {
+    const backend = nodeBackend();
+    // ConcatV2 and AddN take their inputs as lists.
+    const f = (a: tf.Tensor, b: tf.Tensor) => {
+      const stacked = tf.stack([a, b]).reshape([4]);
+      return tf.addN([tf.concat([a, b]), tf.concat([b, a]), stacked]);
+    };
+    const replay =
+        backend.captureFunction(f, [tf.tensor1d([0, 0]), tf.tensor1d([0, 0])]);
+
+    const a = tf.tensor1d([1, 2]);
+    const b = tf.tensor1d([10, 20]);
+    const [result] = replay([a, b]);
+    expect(result.shape).toEqual([4]);
+    expectArraysClose(result, [12, 24, 21, 42]);
+  });
+  it('ends the capture when the traced function throws', () => {
+    const backend = nodeBackend();
+    expect(() => backend.captureFunction(() => {
+      throw new Error('trace error');
+    }, [])).toThrowError(/trace error/);
+    // A new capture can start.
+    const replay = backend.captureFunction(a => tf.neg(a), [tf.scalar(1)]);
+    expectArraysClose(replay([tf.scalar(4)])[0], [-4]);
+  });
+});
@@ -101,6 +101,159 @@ function getTFDTypeForInputs(tensors: tfc.Tensor|tfc.Tensor[]): number {
   }
 }
 
+/**
+ * Encodes a list of TFEOpAttrs into the packed little-endian layout read by
+ * `executeOpPacked()`: an int32 attribute count, then per attribute an int32
+ * type, int32 list flag, int32 name length, the utf8 name bytes, an int32
+ * value count and the values. See `ParseOpAttrsFromBuffer()` in
+ * binding/tfjs_backend.cc.
+ */
+export function encodeOpAttrs(opAttrs: TFEOpAttr[]): Uint8Array {
+  const binding = nodeBackend().binding;
+
+  const names: Buffer[] = [];
+  const values: Array<Buffer|number[]> = [];
+  const isList: boolean[] = [];
+  let byteLength = 4;
+  for (let i = 0; i < opAttrs.length; i++) {
+    const attr = opAttrs[i];
+    names.push(Buffer.from(attr.name, 'utf8'));
+
+    let attrValues: Buffer|number[];
+    let valueWidth: number;
+    switch (attr.type) {
+      case binding.TF_ATTR_STRING:
+        if (typeof attr.value !== 'string') {
+          throw new Error(`Expected a string value for attr ${attr.name}`);
+        }
+        attrValues = Buffer.from(attr.value, 'utf8');
+        valueWidth = 1;
+        break;
+      case binding.TF_ATTR_INT:
+      case binding.TF_ATTR_SHAPE:
+        valueWidth = 8;
+        break;
+      case binding.TF_ATTR_FLOAT:
+      case binding.TF_ATTR_TYPE:
+        valueWidth = 4;
+        break;
+      case binding.TF_ATTR_BOOL:
+        valueWidth = 1;
+        break;
+      default:
+        throw new Error(`Unsupported TF_AttrType: ${attr.type}`);
+    }
+    if (attrValues == null) {
+      attrValues = (isArray(attr.value) ? attr.value : [attr.value]) as
+          number[];
+      for (let j = 0; j < attrValues.length; j++) {
+        if (typeof attrValues[j] !== 'number' &&
+            typeof attrValues[j] !== 'boolean') {
+          throw new Error(`Invalid value for attr ${attr.name}`);
+        }
+      }
+    }
+    values.push(attrValues);
+    isList.push(attr.type !== binding.TF_ATTR_SHAPE && isArray(attr.value));
+    byteLength += 16 + names[i].length + attrValues.length * valueWidth;
+  }
+
+  const bytes = new Uint8Array(byteLength);
+  const view = new DataView(bytes.buffer);
+  let offset = 0;
+  view.setInt32(offset, opAttrs.length, true);
+  offset += 4;
+  for (let i = 0; i < opAttrs.length; i++) {
+    const type = opAttrs[i].type;
+    view.setInt32(offset, type, true);
+    view.setInt32(offset + 4, isList[i] ? 1 : 0, true);
+    view.setInt32(offset + 8, names[i].length, true);
+    offset += 12;
+    bytes.set(names[i], offset);
+    offset += names[i].length;
+    view.setInt32(offset, values[i].length, true);
+    offset += 4;
+
+    const attrValues = values[i];
+    if (type === binding.TF_ATTR_STRING) {
+      bytes.set(attrValues as Buffer, offset);
+      offset += attrValues.length;
+      continue;
+    }
+    for (let j = 0; j < attrValues.length; j++) {
+      const value = Number(attrValues[j]);
+      if (type === binding.TF_ATTR_INT || type === binding.TF_ATTR_SHAPE) {
+        view.setFloat64(offset, value, true);
+        offset += 8;
+      } else if (type === binding.TF_ATTR_FLOAT) {
+        view.setFloat32(offset, value, true);
+        offset += 4;
+      } else if (type === binding.TF_ATTR_TYPE) {
+        view.setInt32(offset, value, true);
+        offset += 4;
+      } else {
+        view.setUint8(offset, value ? 1 : 0);
+        offset += 1;
+      }
+    }
+  }
+  return bytes;
+}
+
+/** An Op in a program executed through `executeProgram()`. */
+export interface ProgramOp {
+  name: string;
+  opAttrs: TFEOpAttr[];
+  // Indices of program values used as inputs. Program values are the program
+  // input tensors followed by the outputs of each Op in execution order.
+  inputs: number[];
+  numOutputs: number;
+}
+
+/**
+ * Encodes a list of ProgramOps into the packed little-endian layout read by
+ * `executeProgram()`: an int32 Op count, then per Op an int32 name length,
+ * the utf8 name bytes, an int32 attribute byte length, the attributes encoded
+ * by `encodeOpAttrs()`, an int32 input count, the int32 input indices and an
+ * int32 output count.
+ */
+export function encodeProgram(ops: ProgramOp[]): Uint8Array {
+  const names: Buffer[] = [];
+  const attrs: Uint8Array[] = [];
+  let byteLength = 4;
+  for (let i = 0; i < ops.length; i++) {
+    names.push(Buffer.from(ops[i].name, 'utf8'));
+    attrs.push(encodeOpAttrs(ops[i].opAttrs));
+    byteLength += 16 + names[i].length + attrs[i].length +
+        ops[i].inputs.length * 4;
+  }
+
+  const bytes = new Uint8Array(byteLength);
+  const view = new DataView(bytes.buffer);
+  let offset = 0;
+  view.setInt32(offset, ops.length, true);
+  offset += 4;
+  for (let i = 0; i < ops.length; i++) {
+    view.setInt32(offset, names[i].length, true);
+    offset += 4;
+    bytes.set(names[i], offset);
+    offset += names[i].length;
+    view.setInt32(offset, attrs[i].length, true);
+    offset += 4;
+    bytes.set(attrs[i], offset);
+    offset += attrs[i].length;
+    view.setInt32(offset, ops[i].inputs.length, true);
+    offset += 4;
+    for (let j = 0; j < ops[i].inputs.length; j++) {
+      view.setInt32(offset, ops[i].inputs[j], true);
+      offset += 4;
+    }
+    view.setInt32(offset, ops[i].numOutputs, true);
+    offset += 4;
+  }
+  return bytes;
+}
+
 export function ensureTensorflowBackend() {
   if (gBackend === null) {
     nodeBackend();
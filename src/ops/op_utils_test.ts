@@ -18,7 +18,7 @@
 import * as tfc from '@tensorflow/tfjs-core';
 import {NodeJSKernelBackend} from '../nodejs_kernel_backend';
 // tslint:disable-next-line:max-line-length
-import {createTensorsTypeOpAttr, createTypeOpAttr, ensureTensorflowBackend, getTFDType, nodeBackend} from './op_utils';
+import {createTensorsTypeOpAttr, createTypeOpAttr, encodeOpAttrs, ensureTensorflowBackend, getTFDType, nodeBackend} from './op_utils';
 
 describe('Exposes Backend for internal Op execution.', () => {
   it('Provides the Node backend over a function', () => {
@@ -100,3 +100,39 @@ describe('Returns TFEOpAttr for a Tensor or list of Tensors', () => {
     expect(() => createTensorsTypeOpAttr('T', inputs)).toThrowError();
   });
 });
+
+describe('encodeOpAttrs()', () => {
+  const binding = nodeBackend().binding;
+
+  it('encodes an empty attribute list', () => {
+    expect(Array.from(encodeOpAttrs([]))).toEqual([0, 0, 0, 0]);
+  });
+
+  it('encodes a type attribute', () => {
+    const bytes = encodeOpAttrs([createTypeOpAttr('T', 'int32')]);
+    const view = new DataView(bytes.buffer);
+    expect(view.getInt32(0, true)).toBe(1);
+    expect(view.getInt32(4, true)).toBe(binding.TF_ATTR_TYPE);
+    expect(view.getInt32(8, true)).toBe(0);
+    expect(view.getInt32(12, true)).toBe(1);
+    expect(String.fromCharCode(bytes[16])).toBe('T');
+    expect(view.getInt32(17, true)).toBe(1);
+    expect(view.getInt32(21, true)).toBe(binding.TF_INT32);
+    expect(bytes.length).toBe(25);
+  });
+
+  it('encodes list attributes', () => {
+    const bytes = encodeOpAttrs(
+        [{name: 'ksize', type: binding.TF_ATTR_INT, value: [1, 2, 2, 1]}]);
+    const view = new DataView(bytes.buffer);
+    expect(view.getInt32(8, true)).toBe(1);
+    expect(view.getInt32(21, true)).toBe(4);
+    expect(view.getFloat64(25 + 8, true)).toBe(2);
+  });
+
+  it('throws for invalid string values', () => {
+    expect(() => encodeOpAttrs([
+      {name: 'a', type: binding.TF_ATTR_STRING, value: 1}
+    ])).toThrowError();
+  });
+});
@@ -0,0 +1,104 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import {NamedTensorMap} from '@tensorflow/tfjs-core';
+
+import {NodeJSKernelBackend} from './nodejs_kernel_backend';
+import {ensureTensorflowBackend, nodeBackend} from './ops/op_utils';
+import {SignatureDefInfo} from './tfjs_binding';
+
+const DEFAULT_SIGNATURE_KEY = 'serving_default';
+const FILE_SCHEME = 'file://';
+
+/**
+ * A TensorFlow SavedModel that runs its signatures in a native session. The
+ * variables of the model are restored once when it is loaded.
+ */
+export class SavedModel {
+  private disposed = false;
+
+  constructor(
+      private readonly backend: NodeJSKernelBackend,
+      private readonly modelId: number,
+      /** SignatureDefs of the loaded MetaGraph, by signature key. */
+      readonly signatures: {[key: string]: SignatureDefInfo}) {}
+
+  /**
+   * Runs a signature and returns its outputs by output name.
+   *
+   * @param inputs A map from signature input names to tensors.
+   * @param outputNames Names of the signature outputs to fetch. Defaults to
+   *   all outputs of the signature.
+   * @param signatureKey Key of the signature to run. Defaults to
+   *   `serving_default`.
+   */
+  runSignature(
+      inputs: NamedTensorMap, outputNames?: string[],
+      signatureKey = DEFAULT_SIGNATURE_KEY): NamedTensorMap {
+    if (this.disposed) {
+      throw new Error('Cannot run a disposed SavedModel');
+    }
+    const signature = this.signatures[signatureKey];
+    if (signature == null) {
+      throw new Error(`SavedModel has no signature ${signatureKey}`);
+    }
+    const inputNames = Object.keys(inputs);
+    const fetchNames = outputNames || Object.keys(signature.outputs);
+    const outputs = this.backend.runSignature(
+        this.modelId, signatureKey, inputNames,
+        inputNames.map(name => inputs[name]), fetchNames);
+    const result: NamedTensorMap = {};
+    fetchNames.forEach((name, i) => {
+      result[name] = outputs[i];
+    });
+    return result;
+  }
+
+  /** Closes the native session of the model. */
+  dispose(): void {
+    if (!this.disposed) {
+      this.disposed = true;
+      this.backend.deleteGraphModel(this.modelId);
+    }
+  }
+}
+
+/**
+ * Loads a TensorFlow SavedModel into a native session, restoring its
+ * variables, and returns a model whose signatures can be run.
+ *
+ * ```js
+ * const model = tf.node.loadSavedModel('path/to/saved_model');
+ * const {output} = model.runSignature({input: tf.zeros([1, 2])});
+ * ```
+ *
+ * @param path Path to the SavedModel directory, optionally with a `file://`
+ *   scheme.
+ * @param tags Tags of the MetaGraph to load. Defaults to `['serve']`.
+ */
+/**
+ * @doc {heading: 'Models', namespace: 'node'}
+ */
+export function loadSavedModel(path: string, tags = ['serve']): SavedModel {
+  ensureTensorflowBackend();
+  const exportDir = path.indexOf(FILE_SCHEME) === 0 ?
+      path.slice(FILE_SCHEME.length) :
+      path;
+  const backend = nodeBackend();
+  const info = backend.loadSavedModel(exportDir, tags);
+  return new SavedModel(backend, info.id, info.signatures);
+}
@@ -0,0 +1,140 @@
+/**
+ * @license
+ * Copyright 2019 Google Inc. All Rights Reserved.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * =============================================================================
+ */
+
+import * as tfc from '@tensorflow/tfjs-core';
+import {expectArraysClose} from '@tensorflow/tfjs-core/dist/test_util';
+import * as fs from 'fs';
+import * as path from 'path';
+import {promisify} from 'util';
+
+import {encodeGraphDef, GraphDefJSON, ProtoWriter} from './graph_def';
+import * as tfn from './index';
+
+// tslint:disable-next-line:no-require-imports
+const rimraf = require('rimraf');
+// tslint:disable-next-line:no-require-imports
+const tmp = require('tmp');
+
+const rimrafPromise = promisify(rimraf);
+const writeFile = promisify(fs.writeFile);
+
+const DT_FLOAT = 1;
+
+// Writes a signature input or output map entry pointing at `tensorName`.
+function writeTensorInfo(
+    w: ProtoWriter, field: number, key: string, tensorName: string) {
+  w.message(field, entry => {
+    entry.string(1, key);
+    entry.message(2, info => {
+      info.string(1, tensorName);
+      info.varint(2, DT_FLOAT);
+      info.message(3, shape => {
+        shape.message(2, dim => dim.varint(1, -1));
+        shape.message(2, dim => dim.varint(1, 2));
+      });
+    });
+  });
+}
+
+describe('loadSavedModel', () => {
+  // A SavedModel without variables whose serving_default signature computes
+  // output = matmul(input, w).
+  const graph: GraphDefJSON = {
+    node: [
+      {
+        name: 'x',
+        op: 'Placeholder',
+        attr: {
+          dtype: {type: 'DT_FLOAT'},
+          shape: {shape: {dim: [{size: '-1'}, {size: '2'}]}}
+        }
+      },
+      {
+        name: 'w',
+        op: 'Const',
+        attr: {dtype: {type: 'DT_FLOAT'}, value: {tensor: {}}}
+      },
+      {
+        name: 'y',
+        op: 'MatMul',
+        input: ['x', 'w'],
+        attr: {
+          T: {type: 'DT_FLOAT'},
+          transpose_a: {b: false},
+          transpose_b: {b: false}
+        }
+      }
+    ],
+    versions: {producer: 27}
+  };
+
+  let tmpDir: string;
+
+  beforeEach(async () => {
+    tmpDir = tmp.dirSync().name;
+    const w = tfc.tensor2d([[1], [2]]);
+    const graphDef = encodeGraphDef(graph, {w});
+    w.dispose();
+
+    const savedModel = new ProtoWriter();
+    savedModel.varint(1, 1);
+    savedModel.message(2, metaGraph => {
+      metaGraph.message(1, metaInfo => metaInfo.string(4, 'serve'));
+      metaGraph.bytes(2, graphDef);
+      metaGraph.message(5, entry => {
+        entry.string(1, 'serving_default');
+        entry.message(2, signature => {
+          writeTensorInfo(signature, 1, 'input', 'x:0');
+          writeTensorInfo(signature, 2, 'output', 'y:0');
+          signature.string(3, 'tensorflow/serving/predict');
+        });
+      });
+    });
+    await writeFile(
+        path.join(tmpDir, 'saved_model.pb'), Buffer.from(savedModel.finish()));
+  });
+
+  afterEach(async () => {
+    if (tmpDir != null) {
+      await rimrafPromise(tmpDir);
+    }
+  });
+
+  it('reads signatures and runs them', async () => {
+    const model = tfn.node.loadSavedModel(`file://${tmpDir}`);
+    const signature = model.signatures['serving_default'];
+    expect(signature.methodName).toBe('tensorflow/serving/predict');
+    expect(signature.inputs['input'])
+        .toEqual({name: 'x:0', dtype: DT_FLOAT, shape: [-1, 2]});
+    expect(signature.outputs['output'].name).toBe('y:0');
+
+    const {output} =
+        model.runSignature({input: tfc.tensor2d([[1, 1], [2, 3]])});
+    expect(output.shape).toEqual([2, 1]);
+    expectArraysClose(await output.data(), [3, 8]);
+
+    expect(() => model.runSignature({missing: output}))
+        .toThrowError(/no tensor named missing/);
+    model.dispose();
+    expect(() => model.runSignature({})).toThrowError(/disposed/);
+  });
+
+  it('fails for MetaGraphs with other tags', () => {
+    expect(() => tfn.node.loadSavedModel(tmpDir, ['train']))
+        .toThrowError(/Failed to load SavedModel/);
+  });
+});
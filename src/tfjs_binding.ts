@@ -29,23 +29,294 @@ export declare class TFEOpAttr {
   value: boolean | number | object | string | number[];
 }
 
+export declare class BindingStats {
+  // Number of live tensor handles.
+  numTensors: number;
+  // Bytes held by live tensor handles.
+  numBytes: number;
+  // Highest value `numBytes` has reached.
+  peakBytes: number;
+  // Number of tensors deleted explicitly.
+  numDisposedTensors: number;
+  // Number of tensors released after their `trackTensor()` value was
+  // garbage collected.
+  numReclaimedTensors: number;
+  // Number of JS typed arrays shared with native tensors that were released.
+  numReleasedRefs: number;
+  // Number of createTensor() calls whose typed array TensorFlow had to copy
+  // because it was not aligned.
+  numMisalignedCopies: number;
+  // Bytes cached by the aligned buffer pool.
+  alignedPoolCachedBytes: number;
+  // Number of misaligned copies served from a recycled tensor arena buffer.
+  tensorArenaHits: number;
+  // Number of misaligned copies that needed a new tensor arena buffer.
+  tensorArenaMisses: number;
+  // Bytes cached by the tensor arena.
+  tensorArenaCachedBytes: number;
+  // Number of uploads already on the target device, which skipped the copy.
+  numSkippedDeviceCopies: number;
+  // Uploads copied to a device, keyed by device name.
+  deviceCopies: {[deviceName: string]: DeviceCopyStats};
+}
+
+export declare interface DeviceCopyStats {
+  numCopies: number;
+  numBytes: number;
+}
+
+export declare interface DeviceInfo {
+  // Full device name, e.g. '/job:localhost/replica:0/task:0/device:CPU:0'.
+  name: string;
+  // Device type, e.g. 'CPU' or 'GPU'.
+  type: string;
+}
+
+export declare interface SignatureTensorInfo {
+  // Name of the graph tensor. Empty for sparse and composite tensors.
+  name: string;
+  // TF_DataType of the tensor, e.g. TF_FLOAT.
+  dtype: number;
+  // Dimensions, -1 for unknown sizes. Absent if the rank is unknown.
+  shape?: number[];
+}
+
+export declare interface SignatureDefInfo {
+  methodName: string;
+  inputs: {[name: string]: SignatureTensorInfo};
+  outputs: {[name: string]: SignatureTensorInfo};
+}
+
+export declare interface SavedModelInfo {
+  // Model ID accepted by `runSignature()`, `runGraphModel()` and
+  // `deleteGraphModel()`.
+  id: number;
+  signatures: {[key: string]: SignatureDefInfo};
+}
+
+export declare interface BatchHistogram {
+  count: number;
+  sum: number;
+  max: number;
+  // Bucket 0 counts values up to 1 and bucket i > 0 counts values in
+  // (2^(i-1), 2^i].
+  buckets: number[];
+}
+
+export declare interface BatchStats {
+  // Requests queued when a request is added, including itself.
+  queueDepth: BatchHistogram;
+  // Rows of each executed batch.
+  batchSize: BatchHistogram;
+  // Requests of each executed batch.
+  batchRequests: BatchHistogram;
+}
+
+export declare interface ContextConfig {
+  // Threads used to parallelize a single Op. 0 lets TensorFlow decide.
+  intraOpParallelismThreads?: number;
+  // Threads used to run independent Ops. 0 lets TensorFlow decide.
+  interOpParallelismThreads?: number;
+  // Whether Ops without a kernel for the requested device fall back to
+  // another device.
+  allowSoftPlacement?: boolean;
+  // Serialized tensorflow.ConfigProto. The options above override the same
+  // fields in it.
+  configProto?: Uint8Array;
+  // Whether to use a TensorFlow context shared by all worker threads that
+  // set this option instead of a private one. Every such worker must pass
+  // the same options, otherwise using the context throws.
+  shareContext?: boolean;
+  // Whether Op execution only enqueues kernels. Output shapes are resolved
+  // when read, and errors surface on readback or `sync()`.
+  asyncExecution?: boolean;
+}
+
 export interface TFJSBinding {
   TensorMetadata: typeof TensorMetadata;
   TFEOpAttr: typeof TFEOpAttr;
 
+  // Sets the TensorFlow context options. The context is created on first use,
+  // so this throws once a tensor was created or an Op executed:
+  configureContext(config: ContextConfig): void;
+
+  // Adds a named context with its own thread pools and tensors, returns
+  // its ID. The default context has ID 0:
+  createContext(name: string, config: ContextConfig): number;
+
+  // Selects the context that new tensors and Op executions use. Op inputs
+  // must belong to the selected context:
+  setContext(contextId: number): void;
+
+  // Lists the devices of the selected context:
+  listDevices(): DeviceInfo[];
+
+  // Places Ops and new tensors of the selected context on a device, given its
+  // full name or a 'TYPE:N' suffix. An empty name restores the default:
+  setDevice(deviceName: string): void;
+
+  // Returns the full name of the device a tensor lives on:
+  getTensorDevice(tensorId: number): string;
+
+  // Waits for the Ops enqueued in the selected context and throws the first
+  // error of an async Op since the last call:
+  sync(): void;
+
+  // Returns the shape of a tensor, waiting for its Op in async contexts:
+  getTensorShape(tensorId: number): number[];
+
   // Creates a tensor with the backend:
   createTensor(shape: number[], dtype: number, buffer: BackendValues): number;
 
   // Deletes a tensor with the backend:
   deleteTensor(tensorId: number): void;
 
-  // Reads data-sync from a tensor on the backend:
-  tensorDataSync(tensorId: number): Float32Array | Int32Array | Uint8Array;
+  // Deletes a batch of tensors with the backend in one call:
+  deleteTensors(tensorIds: Int32Array): void;
+
+  // Reads data-sync from a tensor on the backend. When `shareBuffer` is true,
+  // numeric data is returned as a view over the native tensor buffer instead
+  // of a copy. Writing to that view changes the tensor. Tensors whose buffer
+  // is the memory of an uploaded typed array are copied either way:
+  tensorDataSync(tensorId: number, shareBuffer?: boolean): Float32Array
+      |Int32Array|Uint8Array;
+
+  // Copies data from a tensor into `target` starting at element `offset`.
+  // The typed array type must match the tensor dtype. Returns the number of
+  // elements written:
+  tensorDataInto(
+      tensorId: number, target: Float32Array|Int32Array|Uint8Array,
+      offset: number): number;
+
+  // Reads data from a tensor on a worker thread:
+  tensorDataAsync(tensorId: number):
+      Promise<Float32Array|Int32Array|Uint8Array>;
+
+  // Exports the data of a tensor to any worker thread of the process. Host
+  // data owned by TensorFlow is shared, data of an uploaded typed array is
+  // copied. Returns a token that `importTensor()` accepts once:
+  exportTensor(tensorId: number): number;
+
+  // Creates a tensor in the selected context from an export token, returns
+  // its TensorMetadata:
+  importTensor(token: number): TensorMetadata;
+
+  // Drops an exported tensor that will not be imported:
+  releaseTensorExport(token: number): void;
 
   // Executes an Op on the backend, returns an array of output TensorMetadata:
   executeOp(
-    opName: string, opAttrs: TFEOpAttr[], inputTensorIds: number[],
-    numOutputs: number): TensorMetadata[];
+    opName: string, opAttrs: TFEOpAttr[],
+    inputTensorIds: number[]|Int32Array, numOutputs: number): TensorMetadata[];
+
+  // Executes an Op on a worker thread, resolves with an array of output
+  // TensorMetadata:
+  executeOpAsync(
+      opName: string, opAttrs: TFEOpAttr[],
+      inputTensorIds: number[]|Int32Array,
+      numOutputs: number): Promise<TensorMetadata[]>;
+
+  // Executes an Op on the backend with attributes packed by `encodeOpAttrs()`.
+  // Output metadata is written to `outputMetadata` as
+  // [id, dtype, rank, ...shape] per output, with a rank of -1 and no shape in
+  // async contexts. Returns the number of outputs:
+  executeOpPacked(
+      opName: string, opAttrs: Uint8Array, inputTensorIds: Int32Array,
+      numOutputs: number, outputMetadata: Int32Array): number;
+
+  // Executes a program encoded by `encodeProgram()` in one call. Only the
+  // program values listed in `outputRefs` are kept, their metadata is written
+  // as `executeOpPacked()` does. Returns the number of outputs:
+  executeProgram(
+      program: Uint8Array, inputTensorIds: Int32Array, outputRefs: Int32Array,
+      outputMetadata: Int32Array): number;
+
+  // Parses an Op name and attributes once, returns an ID of the prepared Op:
+  prepareOp(opName: string, opAttrs: TFEOpAttr[]): number;
+
+  // Executes a prepared Op on the backend, returns an array of output
+  // TensorMetadata:
+  executePrepared(
+      preparedOpId: number, inputTensorIds: number[]|Int32Array,
+      numOutputs: number): TensorMetadata[];
+
+  // Executes a prepared Op on the backend, writes packed output metadata as
+  // `executeOpPacked()` does and returns the number of outputs:
+  executePrepared(
+      preparedOpId: number, inputTensorIds: Int32Array, numOutputs: number,
+      outputMetadata: Int32Array): number;
+
+  // Releases a prepared Op:
+  releasePreparedOp(preparedOpId: number): void;
+
+  // Starts recording the Ops executed in the selected context. Ops still
+  // execute. The given tensors become the function arguments, any other
+  // tensor an Op reads is captured as a constant:
+  beginCapture(inputTensorIds: Int32Array): void;
+
+  // Stops recording and registers the Ops as a function returning the given
+  // tensors, which runs as an Op named `name`. Returns the number of Ops:
+  endCapture(name: string, outputTensorIds: Int32Array): number;
+
+  // Stops recording and drops the recorded Ops:
+  cancelCapture(): void;
+
+  // Imports a serialized GraphDef into a graph run by a native session that
+  // uses the options of the selected context, returns the ID of the model:
+  loadGraphModel(graphDef: Uint8Array): number;
+
+  // Runs a graph model in one session call, feeding the tensors named by
+  // `inputNames` and fetching those named by `outputNames`, as `node` or
+  // `node:index`. Returns an array of output TensorMetadata:
+  runGraphModel(
+      modelId: number, inputNames: string[], inputTensorIds: Int32Array,
+      outputNames: string[]): TensorMetadata[];
+
+  // Loads the MetaGraph of a SavedModel that matches `tags` into a graph run
+  // by a native session, returns the model ID and its signatures:
+  loadSavedModel(exportDir: string, tags: string[]): SavedModelInfo;
+
+  // Runs a SavedModel signature in one session call, with tensors named by
+  // their signature input and output names. Returns an array of output
+  // TensorMetadata:
+  runSignature(
+      modelId: number, signatureKey: string, inputNames: string[],
+      inputTensorIds: Int32Array, outputNames: string[]): TensorMetadata[];
+
+  // Sets the row cap of the batches of `runGraphModelBatched()` calls and how
+  // long the oldest queued call waits for a batch to fill:
+  configureBatching(
+      modelId: number, maxBatchSize: number, batchTimeoutMicros: number): void;
+
+  // Queues a graph model run that is batched with concurrent calls of the
+  // same input and output names, dtypes and trailing input dimensions. The
+  // batch runs on a worker thread. Resolves with an array of output
+  // TensorMetadata:
+  runGraphModelBatched(
+      modelId: number, inputNames: string[], inputTensorIds: Int32Array,
+      outputNames: string[]): Promise<TensorMetadata[]>;
+
+  // Returns the queue depth and batch size histograms of batched runs:
+  getBatchStats(modelId: number): BatchStats;
+
+  // Closes the session of a graph model or SavedModel and releases its graph:
+  deleteGraphModel(modelId: number): void;
+
+  // Returns native memory statistics:
+  getStats(): BindingStats;
+
+  // Allocates an ArrayBuffer aligned so that tensors created over it share its
+  // memory with TensorFlow instead of copying it:
+  allocAligned(byteLength: number): ArrayBuffer;
+
+  // Sets the caps of the arena that recycles buffers of tensors created from
+  // misaligned typed arrays, keyed by dtype and byte size. A zero
+  // `maxCachedBytes` disables the arena:
+  configureTensorArena(maxCachedBytes: number, maxBuffersPerKey: number): void;
+
+  // Returns a value that releases the tensor once it is garbage collected,
+  // unless the tensor is deleted first:
+  trackTensor(tensorId: number): object;
 
   // TF Types
   TF_FLOAT: number;
@@ -16,7 +16,8 @@
  */
 
 import * as path from 'path';
-import {TFEOpAttr, TFJSBinding} from './tfjs_binding';
+import {encodeOpAttrs, encodeProgram} from './ops/op_utils';
+import {TensorMetadata, TFEOpAttr, TFJSBinding} from './tfjs_binding';
 // tslint:disable-next-line:no-require-imports
 const binary = require('node-pre-gyp');
 const bindingPath =
@@ -78,6 +79,20 @@ describe('tensor management', () => {
 
     binding.deleteTensor(id);
   });
+  it('rejects IDs of deleted tensors after the slot is reused', () => {
+    const staleId =
+        binding.createTensor([1], binding.TF_INT32, new Int32Array([1]));
+    binding.deleteTensor(staleId);
+    const ids: number[] = [];
+    for (let i = 0; i < 16; i++) {
+      ids.push(
+          binding.createTensor([1], binding.TF_INT32, new Int32Array([i])));
+    }
+    expect(ids.indexOf(staleId)).toBe(-1);
+    expect(() => binding.tensorDataSync(staleId)).toThrowError();
+    expect(() => binding.deleteTensor(staleId)).toThrowError();
+    ids.forEach(id => binding.deleteTensor(id));
+  });
   it('throws exception when shape does not match data', () => {
     expect(() => {
       binding.createTensor([2], binding.TF_INT32, new Int32Array([1, 2, 3]));
@@ -295,3 +310,803 @@ describe('executeOp', () => {
     ]));
   });
 });
+
+describe('prepared ops', () => {
+  const matMulOpAttrs = [
+    {name: 'transpose_a', type: binding.TF_ATTR_BOOL, value: false},
+    {name: 'transpose_b', type: binding.TF_ATTR_BOOL, value: false},
+    {name: 'T', type: binding.TF_ATTR_TYPE, value: binding.TF_FLOAT}
+  ];
+  const aId = binding.createTensor(
+      [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+  const bId = binding.createTensor(
+      [2, 2], binding.TF_FLOAT, new Float32Array([4, 3, 2, 1]));
+
+  it('throws exception with invalid Op Name', () => {
+    expect(() => {
+      binding.prepareOp('NotARealOp', matMulOpAttrs);
+    }).toThrowError();
+  });
+  it('throws exception with invalid prepared Op ID', () => {
+    expect(() => {
+      binding.executePrepared(-1, [aId, bId], 1);
+    }).toThrowError();
+    expect(() => {
+      binding.releasePreparedOp(-1);
+    }).toThrowError();
+  });
+  it('executes a prepared Op multiple times', () => {
+    const preparedOpId = binding.prepareOp('MatMul', matMulOpAttrs);
+    for (let i = 0; i < 3; i++) {
+      const output = binding.executePrepared(preparedOpId, [aId, bId], 1);
+      expect(output[0].shape).toEqual([2, 2]);
+      expect(output[0].dtype).toEqual(binding.TF_FLOAT);
+      expect(binding.tensorDataSync(output[0].id)).toEqual(new Float32Array([
+        8, 5, 20, 13
+      ]));
+      binding.deleteTensor(output[0].id);
+    }
+    binding.releasePreparedOp(preparedOpId);
+    expect(() => {
+      binding.executePrepared(preparedOpId, [aId, bId], 1);
+    }).toThrowError();
+  });
+});
+
+describe('executeOpPacked', () => {
+  const matMulOpAttrs = [
+    {name: 'transpose_a', type: binding.TF_ATTR_BOOL, value: false},
+    {name: 'transpose_b', type: binding.TF_ATTR_BOOL, value: true},
+    {name: 'T', type: binding.TF_ATTR_TYPE, value: binding.TF_FLOAT}
+  ];
+  const aId = binding.createTensor(
+      [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+  const bId = binding.createTensor(
+      [2, 2], binding.TF_FLOAT, new Float32Array([4, 2, 3, 1]));
+
+  it('writes packed output metadata', () => {
+    const metadata = new Int32Array(8);
+    const numOutputs = binding.executeOpPacked(
+        'MatMul', encodeOpAttrs(matMulOpAttrs), new Int32Array([aId, bId]), 1,
+        metadata);
+    expect(numOutputs).toBe(1);
+    expect(metadata[1]).toBe(binding.TF_FLOAT);
+    expect(Array.from(metadata.subarray(2, 5))).toEqual([2, 2, 2]);
+    expect(binding.tensorDataSync(metadata[0])).toEqual(new Float32Array([
+      8, 5, 20, 13
+    ]));
+    binding.deleteTensor(metadata[0]);
+  });
+  it('throws exception when the metadata buffer is too small', () => {
+    expect(() => {
+      binding.executeOpPacked(
+          'MatMul', encodeOpAttrs(matMulOpAttrs), new Int32Array([aId, bId]),
+          1, new Int32Array(2));
+    }).toThrowError();
+  });
+  it('throws exception with malformed attributes', () => {
+    expect(() => {
+      binding.executeOpPacked(
+          'MatMul', new Uint8Array([1, 0, 0, 0, 4]),
+          new Int32Array([aId, bId]), 1, new Int32Array(8));
+    }).toThrowError();
+  });
+  it('supports packed outputs for prepared ops', () => {
+    const preparedOpId = binding.prepareOp('MatMul', matMulOpAttrs);
+    const metadata = new Int32Array(8);
+    expect(binding.executePrepared(
+               preparedOpId, new Int32Array([aId, bId]), 1, metadata))
+        .toBe(1);
+    expect(binding.tensorDataSync(metadata[0])).toEqual(new Float32Array([
+      8, 5, 20, 13
+    ]));
+    binding.deleteTensor(metadata[0]);
+    binding.releasePreparedOp(preparedOpId);
+  });
+});
+
+describe('executeProgram', () => {
+  const typeAttr = {
+    name: 'T',
+    type: binding.TF_ATTR_TYPE,
+    value: binding.TF_FLOAT
+  };
+  const xId = binding.createTensor(
+      [2, 2], binding.TF_FLOAT, new Float32Array([1, -2, 3, -4]));
+  const yId = binding.createTensor(
+      [2, 2], binding.TF_FLOAT, new Float32Array([1, 1, 1, 1]));
+  // Computes relu(x + y) and x * y, program values are [x, y, add, relu, mul].
+  const program = encodeProgram([
+    {name: 'Add', opAttrs: [typeAttr], inputs: [0, 1], numOutputs: 1},
+    {name: 'Relu', opAttrs: [typeAttr], inputs: [2], numOutputs: 1},
+    {name: 'Mul', opAttrs: [typeAttr], inputs: [0, 1], numOutputs: 1}
+  ]);
+
+  it('returns only the requested outputs', () => {
+    const metadata = new Int32Array(16);
+    const numOutputs = binding.executeProgram(
+        program, new Int32Array([xId, yId]), new Int32Array([3, 4]), metadata);
+    expect(numOutputs).toBe(2);
+    expect(Array.from(metadata.subarray(1, 5))).toEqual([
+      binding.TF_FLOAT, 2, 2, 2
+    ]);
+    expect(binding.tensorDataSync(metadata[0])).toEqual(new Float32Array([
+      2, 0, 4, 0
+    ]));
+    expect(binding.tensorDataSync(metadata[5])).toEqual(new Float32Array([
+      1, -2, 3, -4
+    ]));
+    binding.deleteTensor(metadata[0]);
+    binding.deleteTensor(metadata[5]);
+  });
+  it('throws exception with invalid value references', () => {
+    expect(() => {
+      binding.executeProgram(
+          program, new Int32Array([xId, yId]), new Int32Array([5]),
+          new Int32Array(16));
+    }).toThrowError();
+    expect(() => {
+      binding.executeProgram(
+          program, new Int32Array([xId, yId]), new Int32Array([0]),
+          new Int32Array(16));
+    }).toThrowError();
+    expect(() => {
+      const badProgram = encodeProgram(
+          [{name: 'Relu', opAttrs: [typeAttr], inputs: [2], numOutputs: 1}]);
+      binding.executeProgram(
+          badProgram, new Int32Array([xId, yId]), new Int32Array([2]),
+          new Int32Array(16));
+    }).toThrowError();
+  });
+});
+
+describe('deleteTensors', () => {
+  it('deletes all tensors in one call', () => {
+    const ids = new Int32Array(3);
+    for (let i = 0; i < ids.length; i++) {
+      ids[i] = binding.createTensor([1], binding.TF_INT32, new Int32Array([i]));
+    }
+    binding.deleteTensors(ids);
+    for (let i = 0; i < ids.length; i++) {
+      expect(() => binding.tensorDataSync(ids[i])).toThrowError();
+    }
+  });
+  it('deletes referenced tensors before throwing for unknown IDs', () => {
+    const id =
+        binding.createTensor([1], binding.TF_INT32, new Int32Array([1]));
+    expect(() => binding.deleteTensors(new Int32Array([-1, id])))
+        .toThrowError();
+    expect(() => binding.tensorDataSync(id)).toThrowError();
+  });
+  it('throws exception with a non Int32Array', () => {
+    expect(() => binding.deleteTensors(new Float32Array([1]) as {} as
+                                       Int32Array))
+        .toThrowError();
+  });
+});
+
+describe('contexts', () => {
+  const attrs =
+      [{name: 'T', type: binding.TF_ATTR_TYPE, value: binding.TF_INT32}];
+  let contextId: number;
+
+  beforeAll(() => {
+    contextId = binding.createContext(
+        'tfjs_binding_test',
+        {intraOpParallelismThreads: 1, interOpParallelismThreads: 1});
+  });
+  afterEach(() => {
+    binding.setContext(0);
+  });
+
+  it('executes Ops in the selected context', () => {
+    binding.setContext(contextId);
+    const a = binding.createTensor([1], binding.TF_INT32, new Int32Array([2]));
+    const output = binding.executeOp('Neg', attrs, [a], 1);
+    expect(binding.tensorDataSync(output[0].id)).toEqual(new Int32Array([-2]));
+    binding.deleteTensor(output[0].id);
+
+    // Tensors can be read and deleted with any context selected.
+    binding.setContext(0);
+    expect(binding.tensorDataSync(a)).toEqual(new Int32Array([2]));
+    binding.deleteTensor(a);
+  });
+  it('rejects inputs from another context', () => {
+    const a = binding.createTensor([1], binding.TF_INT32, new Int32Array([2]));
+    binding.setContext(contextId);
+    expect(() => binding.executeOp('Neg', attrs, [a], 1))
+        .toThrowError(/another context/);
+    binding.deleteTensor(a);
+  });
+  it('rejects duplicate names and unknown IDs', () => {
+    expect(() => binding.createContext('tfjs_binding_test', {})).toThrowError();
+    expect(() => binding.setContext(1000)).toThrowError();
+  });
+  it('rejects a shared context with a different config', () => {
+    // Matches the config of the workers that share the context below.
+    const shared =
+        binding.createContext('tfjs_binding_test_shared', {shareContext: true});
+    const other = binding.createContext(
+        'tfjs_binding_test_shared_other',
+        {shareContext: true, intraOpParallelismThreads: 1});
+    const data = new Int32Array([2]);
+    binding.setContext(shared);
+    binding.deleteTensor(binding.createTensor([1], binding.TF_INT32, data));
+    binding.setContext(other);
+    expect(() => binding.createTensor([1], binding.TF_INT32, data))
+        .toThrowError(/different config/);
+  });
+});
+
+describe('async execution', () => {
+  const attrs =
+      [{name: 'T', type: binding.TF_ATTR_TYPE, value: binding.TF_FLOAT}];
+  let contextId: number;
+
+  beforeAll(() => {
+    contextId = binding.createContext(
+        'tfjs_binding_test_async', {asyncExecution: true});
+  });
+  afterEach(() => {
+    binding.setContext(0);
+  });
+
+  it('resolves output shapes on demand', () => {
+    binding.setContext(contextId);
+    const a = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    const output = binding.executeOp('Neg', attrs, [a], 1);
+    expect(output[0].dtype).toBe(binding.TF_FLOAT);
+    expect(output[0].shape).toEqual([2]);
+    expect(binding.tensorDataSync(output[0].id)).toEqual(new Float32Array([
+      -1, -2
+    ]));
+    binding.deleteTensors(new Int32Array([a, output[0].id]));
+  });
+  it('writes packed outputs without a shape', () => {
+    binding.setContext(contextId);
+    const a = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    const metadata = new Int32Array(16);
+    binding.executeOpPacked(
+        'Neg', encodeOpAttrs(attrs), new Int32Array([a]), 1, metadata);
+    const id = metadata[0];
+    expect(metadata[2]).toBe(-1);
+    expect(binding.getTensorShape(id)).toEqual([2]);
+    binding.sync();
+    expect(binding.tensorDataSync(id)).toEqual(new Float32Array([-1, -2]));
+    binding.deleteTensors(new Int32Array([a, id]));
+  });
+  it('reports errors of enqueued Ops', () => {
+    binding.setContext(contextId);
+    const a = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    const b = binding.createTensor(
+        [3], binding.TF_FLOAT, new Float32Array([1, 2, 3]));
+    let output: TensorMetadata[] = [];
+    expect(() => {
+      output = binding.executeOp('Add', attrs, [a, b], 1);
+      binding.sync();
+    }).toThrowError();
+    output.forEach(info => binding.deleteTensor(info.id));
+    binding.deleteTensors(new Int32Array([a, b]));
+
+    // The error is reported once.
+    binding.sync();
+  });
+});
+
+interface WorkerLike {
+  on(event: 'message', listener: (value: number[]) => void): void;
+  on(event: 'error', listener: (error: Error) => void): void;
+  on(event: 'exit', listener: () => void): void;
+}
+
+interface WorkerThreads {
+  Worker: new(code: string, options: {eval: boolean, workerData: string}) =>
+      WorkerLike;
+}
+
+function loadWorkerThreads(): WorkerThreads {
+  try {
+    // tslint:disable-next-line:no-require-imports
+    return require('worker_threads');
+  } catch (e) {
+    return null;
+  }
+}
+
+describe('worker threads', () => {
+  const workerThreads = loadWorkerThreads();
+
+  function runInWorker(shareContext: boolean): Promise<number[]> {
+    const code = `
+      const {parentPort, workerData} = require('worker_threads');
+      const binding = require(workerData);
+      binding.configureContext({shareContext: ${shareContext}});
+      const id = binding.createTensor(
+          [2], binding.TF_INT32, new Int32Array([1, 2]));
+      const attrs = [{name: 'T', type: binding.TF_ATTR_TYPE,
+                      value: binding.TF_INT32}];
+      const output = binding.executeOp('Neg', attrs, [id], 1);
+      parentPort.postMessage(
+          Array.from(binding.tensorDataSync(output[0].id)));`;
+    return new Promise((resolve, reject) => {
+      const worker =
+          new workerThreads.Worker(code, {eval: true, workerData: bindingPath});
+      worker.on('message', resolve);
+      worker.on('error', reject);
+    });
+  }
+
+  it('gives every worker its own backend', async () => {
+    if (workerThreads == null) {
+      return;
+    }
+    const id = binding.createTensor([1], binding.TF_INT32, new Int32Array([7]));
+    expect(await runInWorker(false)).toEqual([-1, -2]);
+    expect(binding.tensorDataSync(id)).toEqual(new Int32Array([7]));
+    binding.deleteTensor(id);
+  });
+  it('imports tensors exported by another thread', async () => {
+    if (workerThreads == null) {
+      return;
+    }
+    const id =
+        binding.createTensor([2], binding.TF_INT32, new Int32Array([5, 6]));
+    const token = binding.exportTensor(id);
+    binding.deleteTensor(id);
+
+    const code = `
+      const {parentPort, workerData} = require('worker_threads');
+      const binding = require(workerData);
+      const tensor = binding.importTensor(${token});
+      parentPort.postMessage(Array.from(binding.tensorDataSync(tensor.id)));`;
+    const values = await new Promise((resolve, reject) => {
+      const worker =
+          new workerThreads.Worker(code, {eval: true, workerData: bindingPath});
+      worker.on('message', resolve);
+      worker.on('error', reject);
+    });
+    expect(values).toEqual([5, 6]);
+  });
+  it('imports tensors of typed arrays after the exporter exited', async () => {
+    if (workerThreads == null) {
+      return;
+    }
+    // The aligned upload shares the memory of the typed array, which is
+    // freed with the worker.
+    const code = `
+      const {parentPort, workerData} = require('worker_threads');
+      const binding = require(workerData);
+      const values = new Int32Array(binding.allocAligned(8));
+      values.set([3, 4]);
+      const id = binding.createTensor([2], binding.TF_INT32, values);
+      const token = binding.exportTensor(id);
+      values.set([0, 0]);
+      binding.deleteTensor(id);
+      parentPort.postMessage([token]);`;
+    const token = await new Promise<number>((resolve, reject) => {
+      let message: number[];
+      const worker =
+          new workerThreads.Worker(code, {eval: true, workerData: bindingPath});
+      worker.on('message', value => message = value);
+      worker.on('error', reject);
+      worker.on('exit', () => resolve(message[0]));
+    });
+
+    const tensor = binding.importTensor(token);
+    expect(binding.tensorDataSync(tensor.id)).toEqual(new Int32Array([3, 4]));
+    binding.deleteTensor(tensor.id);
+  });
+  it('reissues an ID once its slot generation wraps', async () => {
+    if (workerThreads == null) {
+      return;
+    }
+    // A fresh backend has a single free slot to reuse, so every ID it issues
+    // is for the same slot.
+    const code = `
+      const {parentPort, workerData} = require('worker_threads');
+      const binding = require(workerData);
+      const firstId = binding.createTensor(
+          [1], binding.TF_INT32, new Int32Array([-1]));
+      binding.deleteTensor(firstId);
+      const ids = [];
+      let id = -1;
+      while (id !== firstId && ids.length < 65536) {
+        id = binding.createTensor(
+            [1], binding.TF_INT32, new Int32Array([ids.length]));
+        ids.push(id);
+        if (id !== firstId) {
+          binding.deleteTensor(id);
+        }
+      }
+      const value = binding.tensorDataSync(id)[0];
+      binding.deleteTensor(id);
+      parentPort.postMessage([ids.length, new Set(ids).size, value]);`;
+    const [numIds, numUniqueIds, value] =
+        await new Promise<number[]>((resolve, reject) => {
+          const worker = new workerThreads.Worker(
+              code, {eval: true, workerData: bindingPath});
+          worker.on('message', resolve);
+          worker.on('error', reject);
+        });
+    // The first ID comes back only after every generation of the slot was
+    // used once, and then resolves to the newest tensor.
+    expect(numIds).toBeGreaterThan(255);
+    expect(numIds).toBeLessThan(65536);
+    expect(numUniqueIds).toBe(numIds);
+    expect(value).toBe(numIds - 1);
+  });
+  it('runs workers on a shared context', async () => {
+    if (workerThreads == null) {
+      return;
+    }
+    const results = await Promise.all([runInWorker(true), runInWorker(true)]);
+    expect(results).toEqual([[-1, -2], [-1, -2]]);
+  });
+});
+
+describe('getStats', () => {
+  it('tracks live tensors and bytes', () => {
+    const before = binding.getStats();
+    const id = binding.createTensor(
+        [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+    const during = binding.getStats();
+    expect(during.numTensors).toBe(before.numTensors + 1);
+    expect(during.numBytes).toBe(before.numBytes + 16);
+    expect(during.peakBytes).toBeGreaterThanOrEqual(during.numBytes);
+
+    binding.deleteTensor(id);
+    const after = binding.getStats();
+    expect(after.numTensors).toBe(before.numTensors);
+    expect(after.numBytes).toBe(before.numBytes);
+    expect(after.peakBytes).toBeGreaterThanOrEqual(during.numBytes);
+  });
+  it('tracks op outputs', () => {
+    const aId = binding.createTensor(
+        [2], binding.TF_INT32, new Int32Array([1, 2]));
+    const before = binding.getStats();
+    const attrs =
+        [{name: 'T', type: binding.TF_ATTR_TYPE, value: binding.TF_INT32}];
+    const output = binding.executeOp('Neg', attrs, [aId], 1);
+    expect(binding.getStats().numBytes).toBe(before.numBytes + 8);
+    binding.deleteTensors(new Int32Array([aId, output[0].id]));
+    expect(binding.getStats().numBytes).toBe(before.numBytes - 8);
+  });
+});
+
+describe('trackTensor', () => {
+  it('does not release explicitly deleted tensors again', () => {
+    const before = binding.getStats();
+    const id = binding.createTensor([1], binding.TF_INT32, new Int32Array([1]));
+    const releaser = binding.trackTensor(id);
+    expect(releaser).toBeDefined();
+    binding.deleteTensor(id);
+
+    const after = binding.getStats();
+    expect(after.numDisposedTensors).toBe(before.numDisposedTensors + 1);
+    expect(after.numReclaimedTensors).toBe(before.numReclaimedTensors);
+  });
+  it('releases tensors of collected values', async () => {
+    // gc() is only exposed when node runs with --expose-gc, as `yarn test`
+    // does.
+    const gc = (global as {} as {gc?: () => void}).gc;
+    if (gc == null) {
+      return;
+    }
+    const before = binding.getStats();
+    (() => {
+      const id =
+          binding.createTensor([1], binding.TF_INT32, new Int32Array([1]));
+      binding.trackTensor(id);
+    })();
+
+    // Finalizers may run in a task after the collection.
+    let after = before;
+    for (let i = 0; i < 10 &&
+         after.numReclaimedTensors === before.numReclaimedTensors;
+         i++) {
+      gc();
+      await new Promise(resolve => setImmediate(resolve));
+      after = binding.getStats();
+    }
+    expect(after.numReclaimedTensors).toBe(before.numReclaimedTensors + 1);
+  });
+  it('throws exception when a tensor is tracked twice', () => {
+    const id = binding.createTensor([1], binding.TF_INT32, new Int32Array([1]));
+    binding.trackTensor(id);
+    expect(() => binding.trackTensor(id)).toThrowError();
+    binding.deleteTensor(id);
+  });
+  it('throws exception with unknown tensor id', () => {
+    expect(() => binding.trackTensor(-1)).toThrowError();
+  });
+});
+
+describe('shared typed array release', () => {
+  it('releases the typed array on the event loop', done => {
+    const before = binding.getStats().numReleasedRefs;
+    const id = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    binding.deleteTensor(id);
+    setImmediate(() => {
+      expect(binding.getStats().numReleasedRefs).toBe(before + 1);
+      done();
+    });
+  });
+});
+
+describe('allocAligned', () => {
+  it('returns a buffer of the requested size', () => {
+    const buffer = binding.allocAligned(40);
+    expect(buffer.byteLength).toBe(40);
+    expect(new Float32Array(buffer).length).toBe(10);
+  });
+  it('creates tensors without a misaligned copy', () => {
+    const before = binding.getStats().numMisalignedCopies;
+    const values = new Float32Array(binding.allocAligned(16));
+    values.set([1, 2, 3, 4]);
+    const id = binding.createTensor([2, 2], binding.TF_FLOAT, values);
+    expect(binding.getStats().numMisalignedCopies).toBe(before);
+    expect(binding.tensorDataSync(id)).toEqual(new Float32Array([1, 2, 3, 4]));
+    binding.deleteTensor(id);
+  });
+  it('counts misaligned copies', () => {
+    const before = binding.getStats().numMisalignedCopies;
+    const values = new Float32Array(binding.allocAligned(20), 4, 4).fill(1);
+    const id = binding.createTensor([4], binding.TF_FLOAT, values);
+    expect(binding.getStats().numMisalignedCopies).toBe(before + 1);
+    binding.deleteTensor(id);
+  });
+  it('throws exception with a negative byte length', () => {
+    expect(() => binding.allocAligned(-1)).toThrowError();
+  });
+});
+
+describe('device copies', () => {
+  function countCopies(): number {
+    const deviceCopies = binding.getStats().deviceCopies;
+    return Object.keys(deviceCopies).reduce(
+        (sum, name) => sum + deviceCopies[name].numCopies, 0);
+  }
+
+  it('skips or counts the copy of float uploads', () => {
+    const before = binding.getStats().numSkippedDeviceCopies;
+    const copiesBefore = countCopies();
+    const id = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    const skipped = binding.getStats().numSkippedDeviceCopies - before;
+    const copied = countCopies() - copiesBefore;
+    expect(skipped + copied).toBe(1);
+    expect(binding.tensorDataSync(id)).toEqual(new Float32Array([1, 2]));
+    binding.deleteTensor(id);
+  });
+  it('leaves int32 uploads in host memory', () => {
+    const before = binding.getStats().numSkippedDeviceCopies;
+    const copiesBefore = countCopies();
+    const id =
+        binding.createTensor([2], binding.TF_INT32, new Int32Array([1, 2]));
+    expect(binding.getStats().numSkippedDeviceCopies).toBe(before);
+    expect(countCopies()).toBe(copiesBefore);
+    binding.deleteTensor(id);
+  });
+});
+
+describe('tensor arena', () => {
+  // Typed arrays at an odd float offset are never aligned for TensorFlow.
+  function createMisalignedTensor(values: number[]): number {
+    const array = new Float32Array(
+        binding.allocAligned((values.length + 1) * 4), 4, values.length);
+    array.set(values);
+    return binding.createTensor([values.length], binding.TF_FLOAT, array);
+  }
+
+  afterEach(() => binding.configureTensorArena(64 * 1024 * 1024, 8));
+
+  it('recycles buffers of the same dtype and size', () => {
+    // Start from an empty arena.
+    binding.configureTensorArena(0, 0);
+    binding.configureTensorArena(1024, 8);
+    const first = createMisalignedTensor([1, 2, 3]);
+    binding.deleteTensor(first);
+
+    const before = binding.getStats();
+    const second = createMisalignedTensor([4, 5, 6]);
+    const after = binding.getStats();
+    expect(after.tensorArenaHits).toBe(before.tensorArenaHits + 1);
+    expect(after.tensorArenaMisses).toBe(before.tensorArenaMisses);
+    expect(binding.tensorDataSync(second)).toEqual(new Float32Array([
+      4, 5, 6
+    ]));
+    binding.deleteTensor(second);
+    expect(binding.getStats().tensorArenaCachedBytes).toBe(12);
+  });
+  it('evicts buffers of the least recently used sizes', () => {
+    binding.configureTensorArena(0, 0);
+    binding.configureTensorArena(16, 8);
+    binding.deleteTensor(createMisalignedTensor([1, 2, 3]));
+    expect(binding.getStats().tensorArenaCachedBytes).toBe(12);
+
+    // The 8-byte buffer only fits once the 12-byte one is released.
+    binding.deleteTensor(createMisalignedTensor([1, 2]));
+    expect(binding.getStats().tensorArenaCachedBytes).toBe(8);
+  });
+  it('is bypassed when disabled', () => {
+    binding.configureTensorArena(0, 0);
+    const before = binding.getStats();
+    const id = createMisalignedTensor([1, 2]);
+    const after = binding.getStats();
+    expect(after.tensorArenaHits).toBe(before.tensorArenaHits);
+    expect(after.tensorArenaMisses).toBe(before.tensorArenaMisses);
+    expect(binding.tensorDataSync(id)).toEqual(new Float32Array([1, 2]));
+    binding.deleteTensor(id);
+    expect(binding.getStats().tensorArenaCachedBytes).toBe(0);
+  });
+  it('throws exception with negative caps', () => {
+    expect(() => binding.configureTensorArena(-1, 1)).toThrowError();
+  });
+});
+
+describe('tensorDataSync', () => {
+  it('shares the tensor buffer when requested', () => {
+    const id = binding.createTensor(
+        [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+    const shared = binding.tensorDataSync(id, true);
+    expect(shared).toEqual(new Float32Array([1, 2, 3, 4]));
+    // The view stays valid after the tensor is deleted.
+    binding.deleteTensor(id);
+    expect(shared).toEqual(new Float32Array([1, 2, 3, 4]));
+  });
+  it('returns a view of tensors owned by TensorFlow', () => {
+    const input =
+        binding.createTensor([2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    const attrs = [{name: 'T', type: binding.TF_ATTR_TYPE,
+                    value: binding.TF_FLOAT}];
+    const id = binding.executeOp('Neg', attrs, [input], 1)[0].id;
+    // Both reads view the same buffer, so a write shows through the other.
+    const view = binding.tensorDataSync(id, true) as Float32Array;
+    const other = binding.tensorDataSync(id, true) as Float32Array;
+    view[0] = 5;
+    expect(other).toEqual(new Float32Array([5, -2]));
+    binding.deleteTensors(new Int32Array([input, id]));
+  });
+  it('copies tensors backed by an uploaded typed array', () => {
+    // An aligned upload shares the memory of the typed array.
+    const values = new Float32Array(binding.allocAligned(8));
+    values.set([1, 2]);
+    const id = binding.createTensor([2], binding.TF_FLOAT, values);
+    const view = binding.tensorDataSync(id, true) as Float32Array;
+    view[0] = 5;
+    expect(values).toEqual(new Float32Array([1, 2]));
+    values[1] = 6;
+    expect(view).toEqual(new Float32Array([5, 2]));
+    binding.deleteTensor(id);
+  });
+  it('copies when sharing is not requested', () => {
+    const id =
+        binding.createTensor([2], binding.TF_INT32, new Int32Array([1, 2]));
+    const copy = binding.tensorDataSync(id, false);
+    copy[0] = 5;
+    expect(binding.tensorDataSync(id)).toEqual(new Int32Array([1, 2]));
+    binding.deleteTensor(id);
+  });
+  it('shares empty tensors', () => {
+    const id = binding.createTensor([0], binding.TF_FLOAT, new Float32Array(0));
+    expect(binding.tensorDataSync(id, true)).toEqual(new Float32Array(0));
+    binding.deleteTensor(id);
+  });
+});
+
+describe('tensorDataInto', () => {
+  it('copies into the target at an offset', () => {
+    const id = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([1, 2]));
+    const target = new Float32Array(4);
+    expect(binding.tensorDataInto(id, target, 1)).toBe(2);
+    expect(target).toEqual(new Float32Array([0, 1, 2, 0]));
+    binding.deleteTensor(id);
+  });
+  it('throws exception with mismatched typed array type', () => {
+    const id =
+        binding.createTensor([2], binding.TF_INT32, new Int32Array([1, 2]));
+    expect(() => binding.tensorDataInto(id, new Float32Array(2), 0))
+        .toThrowError();
+    binding.deleteTensor(id);
+  });
+  it('throws exception when the target is too small', () => {
+    const id = binding.createTensor(
+        [3], binding.TF_FLOAT, new Float32Array([1, 2, 3]));
+    expect(() => binding.tensorDataInto(id, new Float32Array(3), 1))
+        .toThrowError();
+    binding.deleteTensor(id);
+  });
+});
+
+describe('tensorDataAsync', () => {
+  it('resolves with float32 data', async () => {
+    const id = binding.createTensor(
+        [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+    const data = await binding.tensorDataAsync(id);
+    expect(data).toEqual(new Float32Array([1, 2, 3, 4]));
+    binding.deleteTensor(id);
+  });
+  it('resolves with int32 data', async () => {
+    const id =
+        binding.createTensor([3], binding.TF_INT32, new Int32Array([1, 2, 3]));
+    const data = await binding.tensorDataAsync(id);
+    expect(data).toEqual(new Int32Array([1, 2, 3]));
+    binding.deleteTensor(id);
+  });
+  it('resolves with bool data', async () => {
+    const id =
+        binding.createTensor([2], binding.TF_BOOL, new Uint8Array([1, 0]));
+    const data = await binding.tensorDataAsync(id);
+    expect(data).toEqual(new Uint8Array([1, 0]));
+    binding.deleteTensor(id);
+  });
+  it('resolves with empty data', async () => {
+    const id = binding.createTensor([0], binding.TF_FLOAT, new Float32Array(0));
+    const data = await binding.tensorDataAsync(id);
+    expect(data).toEqual(new Float32Array(0));
+    binding.deleteTensor(id);
+  });
+  it('resolves after the tensor is deleted', async () => {
+    const id = binding.createTensor(
+        [2], binding.TF_FLOAT, new Float32Array([5, 6]));
+    const promise = binding.tensorDataAsync(id);
+    binding.deleteTensor(id);
+    expect(await promise).toEqual(new Float32Array([5, 6]));
+  });
+  it('throws exception with unknown tensor id', () => {
+    expect(() => binding.tensorDataAsync(-1)).toThrowError();
+  });
+});
+
+describe('executeOpAsync', () => {
+  const matMulOpAttrs = [
+    {name: 'transpose_a', type: binding.TF_ATTR_BOOL, value: false},
+    {name: 'transpose_b', type: binding.TF_ATTR_BOOL, value: false},
+    {name: 'T', type: binding.TF_ATTR_TYPE, value: binding.TF_FLOAT}
+  ];
+
+  it('resolves with output metadata', async () => {
+    const aId = binding.createTensor(
+        [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+    const bId = binding.createTensor(
+        [2, 2], binding.TF_FLOAT, new Float32Array([4, 3, 2, 1]));
+    const promise =
+        binding.executeOpAsync('MatMul', matMulOpAttrs, [aId, bId], 1);
+    // Inputs are referenced by the in-flight Op and may be deleted right away.
+    binding.deleteTensor(aId);
+    binding.deleteTensor(bId);
+
+    const output = await promise;
+    expect(output.length).toBe(1);
+    expect(output[0].shape).toEqual([2, 2]);
+    expect(output[0].dtype).toEqual(binding.TF_FLOAT);
+    expect(binding.tensorDataSync(output[0].id)).toEqual(new Float32Array([
+      8, 5, 20, 13
+    ]));
+    binding.deleteTensor(output[0].id);
+  });
+  it('rejects when the Op fails', async done => {
+    const aId = binding.createTensor(
+        [2, 2], binding.TF_FLOAT, new Float32Array([1, 2, 3, 4]));
+    const bId = binding.createTensor(
+        [3], binding.TF_FLOAT, new Float32Array([1, 2, 3]));
+    try {
+      await binding.executeOpAsync('MatMul', matMulOpAttrs, [aId, bId], 1);
+      done.fail();
+    } catch (err) {
+      done();
+    } finally {
+      binding.deleteTensors(new Int32Array([aId, bId]));
+    }
+  });
+  it('throws exception with invalid inputs', () => {
+    expect(() => {
+      binding.executeOpAsync('MatMul', matMulOpAttrs, [-1], 1);
+    }).toThrowError();
+  });
+});